@@ -0,0 +1,2559 @@
+/**
+* @brief The Flash Manager module is part of the Resource Manager block.
+* The Flash Manager module gives a set of functions to allow writing and reading the data flash area, on the microcontroller.
+* and handle it just like an E2PROM.
+* Orders for writing operations come from Memory Driver module * and- the ones for reading operations comes from Memory
+* Driver module,
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+
+/* Renesas Generated code includes  */
+//API header of the board being built (FlashManager_eSTB or FlashManager_Gaya_RX130), found through its include path
+#include "FlashManager.h"
+#include "FlashManagerHw.h"
+#include "FlashManagerTiming.h"
+
+#include "../../../types.h"
+//#include "../../../Ssl/ResourceManager/SystemIntegrityTest/SystemIntegrity.h"
+//#include "../../../Ssl/ResourceManager/Interrupts/Interrupts.h"
+//#include "../../../Ssl/ResourceManager/Scheduling/Scheduling.h"
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#ifdef FLASHMAN_CLOCK_RUNTIME
+#define T_DSTOP			(s_tFlashManTiming.uiTdstop)
+#define T_TMS			(s_tFlashManTiming.uiTms)
+#define FLASHMAN_PCKA	(s_tFlashManTiming.ucPcka)
+#else
+#define T_DSTOP			mFlashManTiming_Loops(FLASHMAN_TDSTOP_NS, FLASHMAN_ICLK_HZ)
+#define T_TMS			mFlashManTiming_Loops(FLASHMAN_TMS_NS, FLASHMAN_ICLK_HZ)
+#define FLASHMAN_PCKA	mFlashManTiming_Pcka(FLASHMAN_FCLK_HZ)
+#endif
+//mFlashManHw_GetCycles counts per us
+#if defined(FLASHMAN_CYCLES_HZ)
+#define FLASHMAN_CYCLES_US	( FLASHMAN_CYCLES_HZ / 1000000UL )
+#elif defined(FLASHMAN_CLOCK_RUNTIME)
+#define FLASHMAN_CYCLES_US	( s_tFlashManTiming.ulIclkHz / 1000000UL )
+#else
+#define FLASHMAN_CYCLES_US	( FLASHMAN_ICLK_HZ / 1000000UL )
+#endif
+#define FPR_KEY			0xA5  //In order to write on FPMCR, first must write this value to FPR.
+#define E2FLASH_PEMODE  0x10
+#define E2FLASH_READMODE 0x08
+
+#define FLASHMAN_FCR_ERASE		0x84
+#define FLASHMAN_FCR_BLANKCHECK	0x83
+
+#define FLASHMAN_ERASE_STATUS	(mFlashManHw_IsERERR())
+#define FLASHMAN_WRITE_STATUS 	(mFlashManHw_IsPRGERR())
+
+//Asynchronous engine
+#define FLASHMAN_OP_WRITE		1
+#define FLASHMAN_OP_ERASE		2
+
+#define FLASHMAN_ST_IDLE		0	//No operation
+#define FLASHMAN_ST_START		1	//Next command to be started
+#define FLASHMAN_ST_WAIT		2	//Command started, waiting for FRDY
+
+//FlashMan_AsyncOp.ucPhase of an erase
+#define FLASHMAN_ERASE_CHECK	0	//Blank check of block uiDone + uiRun in progress
+#define FLASHMAN_ERASE_RUN		1	//Erase of the uiRun blocks from uiDone in progress, in one command
+#define FLASHMAN_ERASE_SINGLE	2	//Erase of block uiDone in progress
+
+//How a run of blocks that are not blank is erased
+#if FLASHMAN_ERASE_RANGE
+#define FLASHMAN_ERASE_BLOCKS	FLASHMAN_ERASE_RUN
+#else
+#define FLASHMAN_ERASE_BLOCKS	FLASHMAN_ERASE_SINGLE
+#endif
+
+//Erases start with a blank check of every block unless FLASHMAN_NO_BLANK_SKIP is defined (e.g. to always erase
+//again a block whose erase may have been interrupted by a reset)
+
+//Reads of at least this size are copied a word at a time (mFlashManHw_ReadWord) when source and destination
+//alignments allow it
+#define FLASHMAN_READ_WORD_MIN	8
+
+//Differential write
+#define mFlashMan_IsChanged(pucMap, i)	(((pucMap)[(i) >> 3] & (1U << ((i) & 7))) != 0)
+
+//Statistics, kept unless FLASHMAN_NO_STATS is defined. mFlashMan_StatStamp declares the stamp of an operation and
+//has to be the last declaration of the function. FlashMan_FrdyIsr updates them too: every update masks interrupts.
+#ifdef FLASHMAN_NO_STATS
+#define mFlashMan_StatStamp(tStamp)
+#define mFlashMan_StatBegin(tStamp)
+#define mFlashMan_StatEnd(ucOp, tStamp, ucStatus)
+#define mFlashMan_StatInc(field)
+#define mFlashMan_StatAdd(field, n)
+#define mFlashMan_IsReady()				(mFlashManHw_IsFRDY())
+#else
+#define mFlashMan_StatStamp(tStamp)		FlashMan_StatStamp tStamp
+#define mFlashMan_StatBegin(tStamp)		FlashMan_StatBeginDF(&(tStamp))
+#define mFlashMan_StatEnd(ucOp, tStamp, ucStatus)	FlashMan_StatEndDF((ucOp), &(tStamp), (ucStatus))
+#define mFlashMan_StatInc(field)		FlashMan_StatAddDF(&s_tFlashManStats.field, 1)
+#define mFlashMan_StatAdd(field, n)		FlashMan_StatAddDF(&s_tFlashManStats.field, (uint32_t)(n))
+#define mFlashMan_IsReady()				(FlashMan_StatAddDF(&s_ulFlashManFrdyPolls, 1), mFlashManHw_IsFRDY())
+#endif
+
+//Trace, recorded only if FLASHMAN_TRACE is defined
+#ifdef FLASHMAN_TRACE
+#define mFlashMan_TraceBegin(ucEvent, ulAddr, uiSize)	FlashMan_TraceDF((ucEvent), FLASHMAN_TR_BEGIN, (ulAddr), (uiSize))
+#define mFlashMan_TraceEnd(ucEvent, ucStatus)			FlashMan_TraceDF((ucEvent), FLASHMAN_TR_END, 0, (ucStatus))
+#define mFlashMan_TraceReject(ucEvent, ulAddr)			FlashMan_TraceDF((ucEvent), FLASHMAN_TR_REJECT, (ulAddr), ERR_FLASHE2DATA_BUSY)
+#else
+#define mFlashMan_TraceBegin(ucEvent, ulAddr, uiSize)
+#define mFlashMan_TraceEnd(ucEvent, ucStatus)
+#define mFlashMan_TraceReject(ucEvent, ulAddr)
+#endif
+
+//Block digests, kept only if FLASHMAN_CRC is defined
+#ifdef FLASHMAN_CRC
+#define FLASHMAN_DIGEST_SEARCH				0xFFFF	//Length of the programmed part not known
+#define mFlashMan_DigestProgram(ucData, ulAddr)	FlashMan_DigestProgramDF((ucData), (ulAddr))
+#define mFlashMan_DigestFailed()			(s_ptFlashManDigestLast->ucState = FLASHMAN_DIGEST_UNKNOWN)
+#ifdef FLASHMAN_USE_CRC_UNIT
+#define mFlashMan_Crc16Byte(uiCrc, ucData)	(mFlashManHw_CrcStart(uiCrc), mFlashManHw_CrcByte(ucData), mFlashManHw_CrcResult())
+#else
+#define mFlashMan_Crc16Byte(uiCrc, ucData)	\
+	( (uint16_t)(((uiCrc) << 8) ^ s_auiFlashManCrcTable[(uint8_t)(((uiCrc) >> 8) ^ (ucData))]) )
+#endif
+#else
+#define mFlashMan_DigestProgram(ucData, ulAddr)
+#define mFlashMan_DigestFailed()
+#endif
+
+//Staging buffer, kept only if FLASHMAN_STAGE is defined. Every program updates the staged copies of its bytes and
+//every erase drops the staged ranges of its blocks.
+#ifdef FLASHMAN_STAGE
+#define mFlashMan_StageWrite(pucData, ulAddr, uiSize)	FlashMan_StageWriteDF((pucData), (ulAddr), (uiSize))
+#define mFlashMan_StageErase(ulAddr, uiBlocks)			FlashMan_StageEraseDF((ulAddr), (uiBlocks))
+#else
+#define mFlashMan_StageWrite(pucData, ulAddr, uiSize)
+#define mFlashMan_StageErase(ulAddr, uiBlocks)
+#endif
+
+//Step hook, see FlashMan_SetStepHook
+#define mFlashMan_StepHook()	((s_pfnFlashManStepHook != 0) ? s_pfnFlashManStepHook() : (void)0)
+
+//A step of an asynchronous operation is a sequencer command: one byte programmed, one block blank checked or one
+//erase. No operation takes this many steps.
+#define FLASHMAN_STEPS_ALL		0xFFFF
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+#ifdef FLASHMAN_CLOCK_RUNTIME
+typedef struct
+{
+	uint16_t uiTdstop;				//Delay loops for tDSTOP
+	uint16_t uiTms;					//Delay loops for tMS
+	uint8_t ucPcka;
+	uint32_t ulIclkHz;
+} FlashMan_Timing;
+#else
+typedef char FlashMan_CheckFclk[((FLASHMAN_FCLK_HZ >= FLASHMAN_FCLK_MIN_HZ) && (FLASHMAN_FCLK_HZ <= FLASHMAN_FCLK_MAX_HZ)) ? 1 : -1];
+#endif
+
+//Mode transition waits at the compile time ICLK, in 16-bit loop counts
+typedef char FlashMan_CheckTdstop[(mFlashManTiming_LoopsWide(FLASHMAN_TDSTOP_NS, FLASHMAN_ICLK_HZ) <= 0xFFFF) ? 1 : -1];
+typedef char FlashMan_CheckTms[(mFlashManTiming_LoopsWide(FLASHMAN_TMS_NS, FLASHMAN_ICLK_HZ) <= 0xFFFF) ? 1 : -1];
+
+//Target layout, see FlashManagerTarget.h. Block aligned bases keep the block math to shifts and masks, sizes and
+//offsets inside of the data flash are 16-bit, and data is programmed a byte per command.
+typedef char FlashMan_CheckAlignRd[((FLASHMAN_BLOCK_ADDR_RD & FLASHMAN_BLOCK_MASK) == 0) ? 1 : -1];
+typedef char FlashMan_CheckAlignWr[((FLASHMAN_BLOCK_ADDR_WR & FLASHMAN_BLOCK_MASK) == 0) ? 1 : -1];
+typedef char FlashMan_CheckWrapRd[((FLASHMAN_BLOCK_ADDR_RD + (FLASHMAN_AREA_SIZE - 1UL)) > FLASHMAN_BLOCK_ADDR_RD) ? 1 : -1];
+typedef char FlashMan_CheckWrapWr[((FLASHMAN_BLOCK_ADDR_WR + (FLASHMAN_AREA_SIZE - 1UL)) > FLASHMAN_BLOCK_ADDR_WR) ? 1 : -1];
+typedef char FlashMan_CheckArea[((FLASHMAN_BLOCK_NUM > 0) && (FLASHMAN_AREA_SIZE <= 0xFFFFUL)) ? 1 : -1];
+typedef char FlashMan_CheckUnit[(FLASHMAN_PROGRAM_UNIT == 1) ? 1 : -1];
+typedef char FlashMan_CheckBlocks[(FLASHMAN_BLOCK_NUM <= 32) ? 1 : -1];		//Failed block bitmap
+#ifdef FLASHMAN_TRACE
+typedef char FlashMan_CheckTrace[((FLASHMAN_TRACE_SIZE & (FLASHMAN_TRACE_SIZE - 1)) == 0) ? 1 : -1];
+#endif
+#ifdef FLASHMAN_STAGE
+typedef char FlashMan_CheckStage[(	(FLASHMAN_STAGE_SIZE > 0) && (FLASHMAN_STAGE_SIZE <= FLASHMAN_AREA_SIZE)
+									&& (FLASHMAN_STAGE_RANGES > 0) && (FLASHMAN_STAGE_RANGES < 0xFF)) ? 1 : -1];
+#endif
+typedef char FlashMan_CheckFwb[((FLASHMAN_FWB_LAYOUT == FLASHMAN_FWB_FWB0) || (FLASHMAN_FWB_LAYOUT == FLASHMAN_FWB_FWBHL)) ? 1 : -1];
+
+#ifdef FLASHMAN_CRC
+//Digest of a block, see FlashMan_GetDigestDF
+typedef struct
+{
+	FlashMan_Digest tDigest;
+	uint8_t ucState;				//FLASHMAN_DIGEST_xxx
+} FlashMan_BlockDigest;
+#endif
+
+#ifdef FLASHMAN_STAGE
+//Staged range, see FlashMan_StageDF
+typedef struct
+{
+	uint16_t uiOffset;				//Area offset of the first byte
+	uint16_t uiSize;				//0 once dropped
+	uint16_t uiPos;					//Position of the copy in s_aucFlashManStage
+} FlashMan_StageRange;
+#endif
+
+#ifndef FLASHMAN_NO_STATS
+//Start of an operation, see FlashMan_StatEndDF
+typedef struct
+{
+	uint32_t ulCycles;
+	uint32_t ulPolls;
+} FlashMan_StatStamp;
+#endif
+
+typedef struct
+{
+	uint8_t ucState;
+	uint8_t ucOp;
+	uint8_t ucStatus;				//Status of the last operation
+	uint8_t ucPhase;				//Erase phase, FLASHMAN_ERASE_xxx
+	const uint8_t *pucData;
+	uint32_t ulAddr;
+	uint16_t uiSize;				//Bytes to program, blocks to erase
+	uint16_t uiDone;				//Bytes already programmed, blocks already erased or found blank
+	uint16_t uiRun;					//Erase: blocks from uiDone on found not blank, erased together
+	uint16_t uiSkip;				//Erase: blank block found right after the run, 0 or 1
+	uint32_t ulFailed;				//Erase: blocks whose erase failed, bit n for block n
+	FlashMan_DoneCb pfnDone;
+#ifndef FLASHMAN_NO_STATS
+	FlashMan_StatStamp tStamp;
+#endif
+} FlashMan_AsyncOp;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+void FlashManInit(void);
+void FlashManDeInit(void);
+static uint8_t FlashMan_WriteAByteDF(volatile uint8_t pucData, uint32_t ulAddr);
+static uint8_t FlashMan_ReadModeToPEmodeDF(void);
+static void FlashMan_PEmodeToReadModeDF(void);
+static uint8_t FlashMan_SetModeDF(uint8_t ucMode);
+static void FlashMan_StartProgramDF(uint8_t ucData, uint32_t ulAddr);
+static void FlashMan_StartRangeCmdDF(uint8_t ucCmd, uint32_t ulStart, uint32_t ulEnd);
+static uint8_t FlashMan_BlankCheckCmdDF(uint32_t ulStart, uint32_t ulEnd, uint8_t *pucBlank);
+static uint8_t FlashMan_FrontierCmdDF(uint32_t ulAddr, uint16_t uiLow, uint16_t uiHigh, uint16_t *puiOffset);
+static uint8_t FlashMan_EndCmdDF(void);
+static uint8_t FlashMan_SubmitDF(uint8_t ucOp, const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize,
+								FlashMan_DoneCb pfnDone);
+static uint16_t FlashMan_DiffRunEndDF(const uint8_t *pucChanged, uint16_t uiFrom, uint16_t uiSize);
+static uint8_t FlashMan_ProgramRangeDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiFrom, uint16_t uiTo,
+										uint16_t *puiProgrammed);
+static uint8_t FlashMan_ProgramBlankDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiFrom, uint16_t uiTo,
+										uint16_t *puiProgrammed);
+static uint8_t FlashMan_StartEraseStepDF(void);
+static void FlashMan_EndEraseStepDF(uint8_t ucStatus, uint8_t ucNotBlank);
+static void FlashMan_FinishDF(uint8_t ucStatus);
+static void FlashMan_WaitDF(void);
+static uint8_t FlashMan_StepDF(uint16_t uiMaxSteps, uint16_t *puiSteps);
+#ifndef FLASHMAN_NO_STATS
+static void FlashMan_StatBeginDF(FlashMan_StatStamp *ptStamp);
+static void FlashMan_StatEndDF(uint8_t ucOp, const FlashMan_StatStamp *ptStamp, uint8_t ucStatus);
+static void FlashMan_StatAddDF(uint32_t *pulCounter, uint32_t ulValue);
+#endif
+#ifdef FLASHMAN_CRC
+static void FlashMan_DigestProgramDF(uint8_t ucData, uint32_t ulAddr);
+static void FlashMan_DigestEraseDF(void);
+static uint8_t FlashMan_ScanDigestDF(uint16_t uiBlock, uint16_t uiLength, FlashMan_Digest *ptDigest);
+#endif
+#ifdef FLASHMAN_STAGE
+static uint8_t FlashMan_ReadStagedDF(volatile uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+static void FlashMan_StageWriteDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+static void FlashMan_StageEraseDF(uint32_t ulAddr, uint16_t uiBlocks);
+#endif
+#ifdef FLASHMAN_TRACE
+static void FlashMan_TraceDF(uint8_t ucEvent, uint8_t ucKind, uint32_t ulAddr, uint16_t uiArg);
+#endif
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static uint8_t s_ucFlashManMode = FLASHMAN_MODE_DISABLED;	//Current data flash mode, see FlashMan_SetModeDF
+static FlashMan_AsyncOp s_tFlashManAsync;							//Asynchronous operation, see FlashMan_Poll
+static uint16_t s_uiFlashManReadEpoch = 0;					//Incremented every time read mode is left, see FlashMan_View
+static FlashMan_StepHook s_pfnFlashManStepHook = 0;			//See FlashMan_SetStepHook
+static volatile uint16_t s_uiFlashManCmds = 0;				//Commands ended by FlashMan_StepDF, see FlashMan_WaitDF
+#ifndef FLASHMAN_NO_STATS
+static FlashMan_Stats s_tFlashManStats;								//See FlashMan_GetStats
+static uint32_t s_ulFlashManFrdyPolls = 0;							//FRDY reads while waiting for the sequencer
+static FlashMan_StatStamp s_tFlashManTransStamp;					//Open write transaction
+#endif
+#ifdef FLASHMAN_TRACE
+static FlashMan_Trace s_tFlashManTrace =							//See FlashMan_GetTrace
+{
+	FLASHMAN_TRACE_MAGIC,
+	FLASHMAN_ICLK_HZ,
+	0,
+	FLASHMAN_TRACE_SIZE,
+	sizeof(FlashMan_TraceEvent),
+	{ { 0 } }
+};
+#endif
+#ifdef FLASHMAN_STAGE
+static uint8_t s_aucFlashManStage[FLASHMAN_STAGE_SIZE];						//See FlashMan_StageDF
+static FlashMan_StageRange s_atFlashManStageRange[FLASHMAN_STAGE_RANGES];
+static uint8_t s_ucFlashManStageRanges = 0;									//Ranges in use
+static uint16_t s_uiFlashManStageUsed = 0;									//Bytes in use
+#endif
+#ifdef FLASHMAN_CRC
+static FlashMan_BlockDigest s_atFlashManDigest[FLASHMAN_BLOCK_NUM];			//See FlashMan_GetDigestDF
+static FlashMan_BlockDigest *s_ptFlashManDigestLast = &s_atFlashManDigest[0];	//Block of the last program command
+#ifndef FLASHMAN_USE_CRC_UNIT
+//CRC-16/CCITT (polynomial 0x1021, MSB first) of every byte value
+static const uint16_t s_auiFlashManCrcTable[256] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+	0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+	0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+	0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+	0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+	0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+	0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+	0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+	0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+	0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+	0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+	0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+	0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+	0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+	0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+	0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+	0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+	0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+	0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+	0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+	0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+	0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+#endif
+#endif
+#ifdef FLASHMAN_CLOCK_RUNTIME
+static FlashMan_Timing s_tFlashManTiming =
+{
+	mFlashManTiming_Loops(FLASHMAN_TDSTOP_NS, FLASHMAN_ICLK_HZ),
+	mFlashManTiming_Loops(FLASHMAN_TMS_NS, FLASHMAN_ICLK_HZ),
+	mFlashManTiming_Pcka(FLASHMAN_FCLK_HZ),
+	FLASHMAN_ICLK_HZ
+};
+#endif
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/*static uint8_t E2FlashCheckHOCO(void)
+{
+	if(SYSTEM.OSCOVFSR.BIT.HCOVF)
+	{
+		return 0;
+	}
+	else
+	{
+		return ERR_FLASHE2DATA_NOHOCO;
+	}
+
+}
+*/
+
+
+
+/**
+* @brief	This function changes to program/erase mode for data flash
+* @param	none
+* @return	none
+*/
+static uint8_t FlashMan_ReadModeToPEmodeDF(void)
+{
+	//Debería devolver el estado de FPSR.ERR, indicando si ha habido error al modificar FPMCR??
+
+	//Check for HOCO running and stabilized
+	if(!mFlashManHw_IsHOCOStable())
+	{
+		return ERR_FLASHE2DATA_NOHOCO;
+	}
+
+	//Check no Low-Speed operating mode selected
+	if(mFlashManHw_IsLowSpeedMode())
+	{
+		return ERR_FLASHE2DATA_LOWSPEED;
+	}
+
+	//E2FLASH a modo P/E
+	mFlashManHw_SetFENTRYR(0xAA80);  //FEKEY = 0xAA00 + FENTRYD = 0x0080
+	mFlashManHw_Delay(T_DSTOP);
+	if(!mFlashManHw_IsFENTRYD())
+	{
+		return ERR_FLASHE2DATA_NOPEMODE;
+	}
+
+	mFlashManHw_SetFPR(FPR_KEY);
+	//Transition from ReadMode to E2 P/E Mode
+	mFlashManHw_SetFPMCR(E2FLASH_PEMODE);
+	mFlashManHw_SetFPMCR(~(E2FLASH_PEMODE));
+	mFlashManHw_SetFPMCR(E2FLASH_PEMODE);
+
+	mFlashManHw_SetPCKA(FLASHMAN_PCKA);
+
+	return 0;
+}
+
+
+/**
+* @brief	This function changes to read mode for data flash
+* @param	none
+* @return	none
+*/
+static void FlashMan_PEmodeToReadModeDF(void)
+{
+	//E2FLASH a modo READ
+	mFlashManHw_SetFPR(FPR_KEY);
+	mFlashManHw_SetFPMCR(E2FLASH_READMODE);
+	mFlashManHw_SetFPMCR(~(E2FLASH_READMODE));
+	mFlashManHw_SetFPMCR(E2FLASH_READMODE);
+	mFlashManHw_Delay(T_TMS);
+
+	mFlashManHw_SetFENTRYR(0xAA00);
+	while(mFlashManHw_GetFENTRYR() != 0) {}
+}
+
+
+/**
+* @brief	This function starts the programming of a byte in flash memory, without waiting for it
+* @param	ucData, byte to write
+* @param	ulAddr, address wherein you want to write it
+* @return	none
+*/
+static void FlashMan_StartProgramDF(uint8_t ucData, uint32_t ulAddr)
+{
+	mFlashManHw_SetEXS(0);
+	
+	mFlashManHw_SetFSARH((uint16_t)(ulAddr >> 16));
+	mFlashManHw_SetFSARL((uint16_t)(ulAddr & 0x0000FFFF));
+	
+	mFlashManHw_SetFWB(ucData);
+
+	mFlashManHw_SetFCR(0x81);
+	mFlashMan_StatInc(ulBytesProgrammed);
+	mFlashMan_DigestProgram(ucData, ulAddr);
+}
+
+
+/**
+* @brief	This function starts an erase or blank check command from ulStart to ulEnd, without waiting for it
+* @param	ucCmd, FLASHMAN_FCR_ERASE or FLASHMAN_FCR_BLANKCHECK
+* @param	ulStart, first address
+* @param	ulEnd, last address
+* @return	none
+*/
+static void FlashMan_StartRangeCmdDF(uint8_t ucCmd, uint32_t ulStart, uint32_t ulEnd)
+{
+	mFlashManHw_SetEXS(0);
+
+	mFlashManHw_SetFSARH((uint16_t)(ulStart >> 16));
+	mFlashManHw_SetFSARL((uint16_t)(ulStart & 0x0000FFFF));
+
+	mFlashManHw_SetFEARH((uint16_t)(ulEnd >> 16));
+	mFlashManHw_SetFEARL((uint16_t)(ulEnd & 0x0000FFFF));
+
+	mFlashManHw_SetFCR(ucCmd);
+
+	if(ucCmd == FLASHMAN_FCR_ERASE)
+	{
+		mFlashMan_StatAdd(ulBlocksErased, ((ulEnd - ulStart) >> FLASHMAN_BLOCK_SHIFT) + 1);
+	}
+	else
+	{
+		mFlashMan_StatInc(ulBlankChecks);
+	}
+}
+
+
+/**
+* @brief	This function runs a blank check command from ulStart to ulEnd. Data flash must be in P/E mode.
+* @param	ulStart, first address (E2FLASHADDR_WRITEBASE based)
+* @param	ulEnd, last address
+* @param	pucBlank, 1 if every byte of the range is erased, 0 otherwise
+* @return	Command status
+*/
+static uint8_t FlashMan_BlankCheckCmdDF(uint32_t ulStart, uint32_t ulEnd, uint8_t *pucBlank)
+{
+	FlashMan_StartRangeCmdDF(FLASHMAN_FCR_BLANKCHECK, ulStart, ulEnd);
+
+	while(mFlashMan_IsReady() == 0)
+	{
+	}
+	mFlashMan_StepHook();
+
+	*pucBlank = (uint8_t)(mFlashManHw_IsBCERR() == 0);
+
+	return FlashMan_EndCmdDF();
+}
+
+
+/**
+* @brief	This function ends a sequencer command once FRDY is set: it clears FCR and gets the command status,
+*			resetting the sequencer if there was an error. FRDY drops as soon as FCR is cleared.
+* @param	none
+* @return	Program/erase status
+*/
+static uint8_t FlashMan_EndCmdDF(void)
+{
+	mFlashManHw_SetFCR(0);
+	
+	while(mFlashManHw_IsFRDY() != 0)
+	{
+	}
+	
+	//The status must be taken before FRESETR clears it
+	if((mFlashManHw_IsILGLERR()) || (FLASHMAN_WRITE_STATUS) || (FLASHMAN_ERASE_STATUS))
+	{
+		mFlashManHw_SetFRESETR(1);
+		mFlashManHw_SetFRESETR(0);
+		mFlashMan_StatInc(ulErrorResets);
+		//Conservative: whatever the command was, the block last programmed is scanned again
+		mFlashMan_DigestFailed();
+		return FLASHMAN_STATUS_ERROR;
+	}
+	else if(mFlashManHw_IsBCERR())
+	{
+		//Not blank is not an error, but it stays latched until reset
+		mFlashManHw_SetFRESETR(1);
+		mFlashManHw_SetFRESETR(0);
+	}
+	else
+	{
+		// Empty
+	}
+	
+	return FLASHMAN_STATUS_OK;
+}
+
+
+/**
+* @brief	This function writes a byte in flash memory
+* @param	ucData, byte to write
+* @param	ulAddr, address wherein you want to write it
+* @return	Write/program status
+*/
+static uint8_t FlashMan_WriteAByteDF(volatile uint8_t ucData, uint32_t ulAddr)
+{
+	FlashMan_StartProgramDF(ucData, ulAddr);
+	
+	while(mFlashMan_IsReady() == 0)
+	{
+	}
+	mFlashMan_StepHook();
+	
+	return FlashMan_EndCmdDF();
+}
+
+
+
+
+/**
+* @brief	This function takes the data flash to the requested mode, doing only the transitions that are
+*			needed from the current one: disabled <-> read mode <-> P/E mode.
+* @param	ucMode, FLASHMAN_MODE_DISABLED, FLASHMAN_MODE_READ or FLASHMAN_MODE_PE
+* @return	0 if the mode is reached, ERR_FLASHE2DATA_xxx otherwise
+*/
+static uint8_t FlashMan_SetModeDF(uint8_t ucMode)
+{
+	uint8_t ucReturn = 0;
+
+	if(ucMode == s_ucFlashManMode)
+	{
+		return 0;
+	}
+
+	//Views taken in read mode are no longer valid
+	if(s_ucFlashManMode == FLASHMAN_MODE_READ)
+	{
+		s_uiFlashManReadEpoch++;
+	}
+
+	//Leave P/E mode before anything else
+	if(s_ucFlashManMode == FLASHMAN_MODE_PE)
+	{
+		mFlashMan_TraceBegin(FLASHMAN_TR_TO_READ, 0, 0);
+		FlashMan_PEmodeToReadModeDF();
+		s_ucFlashManMode = FLASHMAN_MODE_READ;
+		mFlashMan_StatInc(ulToReadMode);
+		mFlashMan_TraceEnd(FLASHMAN_TR_TO_READ, 0);
+	}
+
+	if(ucMode == FLASHMAN_MODE_DISABLED)
+	{
+		mFlashMan_TraceBegin(FLASHMAN_TR_DISABLE, 0, 0);
+		mFlashManHw_SetDFLEN(0);
+		mFlashManHw_Delay(T_DSTOP);
+		s_ucFlashManMode = FLASHMAN_MODE_DISABLED;
+		mFlashMan_TraceEnd(FLASHMAN_TR_DISABLE, 0);
+		return 0;
+	}
+
+	//Habilitar acceso a E2FLASH, it is left in read mode
+	if(s_ucFlashManMode == FLASHMAN_MODE_DISABLED)
+	{
+		mFlashMan_TraceBegin(FLASHMAN_TR_ENABLE, 0, 0);
+		mFlashManHw_SetDFLEN(1);
+		mFlashManHw_Delay(T_DSTOP);
+		s_ucFlashManMode = FLASHMAN_MODE_READ;
+		mFlashMan_TraceEnd(FLASHMAN_TR_ENABLE, 0);
+	}
+
+	if(ucMode == FLASHMAN_MODE_PE)
+	{
+		mFlashMan_TraceBegin(FLASHMAN_TR_TO_PE, 0, 0);
+		ucReturn = FlashMan_ReadModeToPEmodeDF();
+		if(ucReturn == 0)
+		{
+			s_ucFlashManMode = FLASHMAN_MODE_PE;
+			mFlashMan_StatInc(ulToPEMode);
+		}
+		mFlashMan_TraceEnd(FLASHMAN_TR_TO_PE, ucReturn);
+	}
+
+	return ucReturn;
+}
+
+
+#ifdef FLASHMAN_CLOCK_RUNTIME
+/**
+* @brief	This function updates the mode transition waits and FISR.PCKA after a clock change. It must not be called
+*			while the data flash is in P/E mode.
+* @param	ulIclkHz, ICLK frequency
+* @param	ulFclkHz, FCLK frequency
+* @return	0 if OK, ERR_FLASHE2DATA_OUTRNG if FCLK does not allow programming the data flash, ERR_FLASHE2DATA_BUSY
+*/
+uint8_t FlashMan_SetClockDF(uint32_t ulIclkHz, uint32_t ulFclkHz)
+{
+	if((ulFclkHz < FLASHMAN_FCLK_MIN_HZ) || (ulFclkHz > FLASHMAN_FCLK_MAX_HZ))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	s_tFlashManTiming.uiTdstop = mFlashManTiming_Loops(FLASHMAN_TDSTOP_NS, ulIclkHz);
+	s_tFlashManTiming.uiTms = mFlashManTiming_Loops(FLASHMAN_TMS_NS, ulIclkHz);
+	s_tFlashManTiming.ucPcka = mFlashManTiming_Pcka(ulFclkHz);
+	s_tFlashManTiming.ulIclkHz = ulIclkHz;
+
+	return 0;
+}
+
+
+#endif
+/**
+* @brief	This function initializes the hardware for current module. It is called by System
+*			Initialization module. This function gives access to the flash memory. The driver state is set as
+*			after a reset, so a restart without one (e.g. the power cut tests on the host model) starts clean.
+* @param	none
+* @return	none
+*/
+void FlashManInit(void)
+{
+#ifdef FLASHMAN_CRC
+	uint16_t i;
+#endif
+
+	s_ucFlashManMode = FLASHMAN_MODE_DISABLED;
+	s_tFlashManAsync.ucState = FLASHMAN_ST_IDLE;
+	s_uiFlashManReadEpoch++;
+#ifdef FLASHMAN_STAGE
+	s_ucFlashManStageRanges = 0;
+	s_uiFlashManStageUsed = 0;
+#endif
+#ifdef FLASHMAN_CRC
+	for(i = 0; i < FLASHMAN_BLOCK_NUM; i++)
+	{
+		s_atFlashManDigest[i].ucState = FLASHMAN_DIGEST_UNKNOWN;
+	}
+#endif
+#ifndef FLASHMAN_NO_STATS
+	FlashMan_ResetStats();
+#endif
+#ifdef FLASHMAN_TRACE
+	FlashMan_ClearTrace();
+#endif
+	(void)FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+}
+
+/**
+* @brief	This function removes access to the flash memory, leaving P/E mode first if needed
+* @param	none
+* @return	none
+*/
+void FlashManDeInit(void)
+{
+	(void)FlashMan_SetModeDF(FLASHMAN_MODE_DISABLED);
+}
+
+/**
+* @brief	This function gives the current data flash mode
+* @param	none
+* @return	FLASHMAN_MODE_DISABLED, FLASHMAN_MODE_READ or FLASHMAN_MODE_PE
+*/
+uint8_t FlashMan_GetMode(void)
+{
+	return s_ucFlashManMode;
+}
+
+/**
+* @brief	This function reads the data on flash memory. It is refused while a program/erase is in progress or a
+*			write transaction is open, unless FLASHMAN_STAGE serves the read from the staged data.
+* @param	pucData, the pointer gives data from flash memory
+*			uiSize, number of bytes collect on pointer
+*			ulAddr, address wherein you want to start reading
+* @return	0 if OK, ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_ReadDF(volatile uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	uint16_t i;
+	uint8_t ucReturn;
+	mFlashMan_StatStamp(tStamp);
+
+	//La dirección ulAddr está dentro del rango de la E2FLASH??
+	//Se toma un bloque de 8k para la E2FLASH
+	if(!mFlashMan_IsInAreaRd(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+
+#ifdef FLASHMAN_STAGE
+	//No memory mapped access in P/E mode (program/erase in progress or open write transaction): staged data only
+	if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		ucReturn = FlashMan_ReadStagedDF(pucData, ulAddr, uiSize);
+		if(ucReturn != 0)
+		{
+			mFlashMan_TraceReject(FLASHMAN_TR_READ, ulAddr);
+		}
+		return ucReturn;
+	}
+#else
+	//No memory mapped access while a program/erase is in progress, nor inside of a write transaction
+	if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		mFlashMan_TraceReject(FLASHMAN_TR_READ, ulAddr);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+#endif
+
+	mFlashMan_StatBegin(tStamp);
+	mFlashMan_TraceBegin(FLASHMAN_TR_READ, ulAddr, uiSize);
+
+	//E2FLASH a modo READ, nothing to do when it is already there
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_READ, tStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_READ, ucReturn);
+		return ucReturn;
+	}
+
+
+	//Pointer pointing to a flash memory address
+	const uint8_t *pucMemoryPos = mFlashManHw_ReadPtr(ulAddr);
+
+	i = 0;
+	if((uiSize >= FLASHMAN_READ_WORD_MIN) && ((((uintptr_t)pucMemoryPos ^ (uintptr_t)pucData) & 3U) == 0))
+	{
+		for(; ((uintptr_t)&pucMemoryPos[i] & 3U) != 0; i++)
+		{
+			pucData[i] = pucMemoryPos[i];
+		}
+		for(; (uint16_t)(i + 4) <= uiSize; i += 4)
+		{
+			mFlashManHw_ReadWord(&pucData[i], &pucMemoryPos[i]);
+		}
+	}
+
+	for(;i<uiSize;i++)
+	{
+		pucData[i] = pucMemoryPos[i];
+	}
+
+	mFlashMan_StatEnd(FLASHMAN_STATS_READ, tStamp, 0);
+	mFlashMan_TraceEnd(FLASHMAN_TR_READ, 0);
+
+	return 0;
+}
+
+
+/**
+* @brief	This function gives a read-only view of the data flash, used in place without copying it to RAM. The view
+*			is valid while the data flash stays in read mode: any write, erase, blank check or FlashManDeInit ends it
+*			(see FlashMan_IsViewValid). No view is given while a write transaction is open.
+* @param	ulAddr, address of the first byte (E2FLASHADDR_READBASE based)
+* @param	uiSize, number of bytes
+* @param	ptView, view
+* @return	0 if OK, ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_GetViewDF(uint32_t ulAddr, uint16_t uiSize, FlashMan_View *ptView)
+{
+	uint8_t ucReturn;
+
+	ptView->pucData = 0;
+	ptView->uiSize = 0;
+
+	if(!mFlashMan_IsInAreaRd(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	//Switching to read mode would end an open write transaction
+	if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	ptView->pucData = mFlashManHw_ReadPtr(ulAddr);
+	ptView->uiSize = uiSize;
+	ptView->uiEpoch = s_uiFlashManReadEpoch;
+
+	return 0;
+}
+
+
+/**
+* @brief	This function tells whether a view can still be used
+* @param	ptView, view given by FlashMan_GetViewDF
+* @return	1 if valid, 0 otherwise
+*/
+uint8_t FlashMan_IsViewValid(const FlashMan_View *ptView)
+{
+	return (uint8_t)(	(ptView->pucData != 0) && (s_ucFlashManMode == FLASHMAN_MODE_READ)
+						&& (ptView->uiEpoch == s_uiFlashManReadEpoch));
+}
+
+
+/**
+* @brief	This function writes varius bytes in flash memory. Synchronous wrapper of FlashMan_SubmitWriteDF.
+* @param	pucData, pointer of bytes to write
+* @param	uiSize, number of bytes to write
+* @param	ulAddr, address wherein you want to start writing
+* @return	Write status
+*/
+uint8_t FlashMan_WriteDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	uint8_t ucReturn;
+
+	ucReturn = FlashMan_SubmitWriteDF(pucData, ulAddr, uiSize, 0);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	FlashMan_WaitDF();
+
+	return s_tFlashManAsync.ucStatus;
+}
+
+
+/**
+* @brief	This function gives the end of the run of bytes that, from uiFrom on, are all changed or all unchanged
+* @param	pucChanged, bitmap of changed bytes
+* @param	uiFrom, first byte of the run
+* @param	uiSize, number of bytes of the bitmap
+* @return	index after the last byte of the run
+*/
+static uint16_t FlashMan_DiffRunEndDF(const uint8_t *pucChanged, uint16_t uiFrom, uint16_t uiSize)
+{
+	uint8_t ucChanged = mFlashMan_IsChanged(pucChanged, uiFrom);
+	uint16_t i;
+
+	for(i = (uint16_t)(uiFrom + 1); (i < uiSize) && (mFlashMan_IsChanged(pucChanged, i) == ucChanged); i++)
+	{
+	}
+
+	return i;
+}
+
+
+/**
+* @brief	This function programs the bytes uiFrom to uiTo - 1. Data flash must be in P/E mode.
+* @param	pucData, bytes of the whole write
+* @param	ulAddr, address of the whole write
+* @param	uiFrom, first byte
+* @param	uiTo, byte after the last one
+* @param	puiProgrammed, incremented for every byte programmed
+* @return	Write status
+*/
+static uint8_t FlashMan_ProgramRangeDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiFrom, uint16_t uiTo,
+										uint16_t *puiProgrammed)
+{
+	uint8_t ucReturn = FLASHMAN_STATUS_OK;
+
+	for(; (uiFrom < uiTo) && (ucReturn == FLASHMAN_STATUS_OK); uiFrom++)
+	{
+		ucReturn = FlashMan_WriteAByteDF(pucData[uiFrom], ulAddr + uiFrom);
+		if(ucReturn == FLASHMAN_STATUS_OK)
+		{
+			(*puiProgrammed)++;
+		}
+	}
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function programs the erased cells of a range whose read image already matches the data: erased
+*			cells read as undefined values, so they have to be programmed anyway. The erased tail is found with a
+*			blank check of the last byte and, if it is erased, a search of its start. Before the tail erased cells
+*			can sit among written ones, so every byte there is blank checked on its own. Data flash must be in P/E
+*			mode.
+* @param	pucData, bytes of the whole write
+* @param	ulAddr, address of the whole write
+* @param	uiFrom, first byte
+* @param	uiTo, byte after the last one
+* @param	puiProgrammed, incremented for every byte programmed
+* @return	Write status
+*/
+static uint8_t FlashMan_ProgramBlankDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiFrom, uint16_t uiTo,
+										uint16_t *puiProgrammed)
+{
+	uint16_t uiTail = uiTo;
+	uint8_t ucBlank;
+	uint8_t ucReturn;
+
+	ucReturn = FlashMan_BlankCheckCmdDF(ulAddr + uiTo - 1, ulAddr + uiTo - 1, &ucBlank);
+	if((ucReturn == FLASHMAN_STATUS_OK) && ucBlank)
+	{
+		ucReturn = FlashMan_FrontierCmdDF(ulAddr, uiFrom, (uint16_t)(uiTo - 1), &uiTail);
+	}
+
+	//The byte before the tail is written, the ones before it are not known
+	for(; ((uiFrom + 1U) < uiTail) && (ucReturn == FLASHMAN_STATUS_OK); uiFrom++)
+	{
+		ucReturn = FlashMan_BlankCheckCmdDF(ulAddr + uiFrom, ulAddr + uiFrom, &ucBlank);
+		if((ucReturn == FLASHMAN_STATUS_OK) && ucBlank)
+		{
+			ucReturn = FlashMan_ProgramRangeDF(pucData, ulAddr, uiFrom, (uint16_t)(uiFrom + 1), puiProgrammed);
+		}
+	}
+
+	if(ucReturn != FLASHMAN_STATUS_OK)
+	{
+		return ucReturn;
+	}
+
+	return FlashMan_ProgramRangeDF(pucData, ulAddr, uiTail, uiTo, puiProgrammed);
+}
+
+
+/**
+* @brief	This function writes only the bytes that differ from the data flash content. The read image is compared
+*			first; then, in P/E mode, every run of changed bytes is blank checked and nothing is programmed if one of
+*			them is already written, since a written cell cannot be programmed over.
+* @param	pucData, pointer of bytes to write
+* @param	ulAddr, address wherein you want to start writing
+* @param	uiSize, number of bytes to write, up to FLASHMAN_DIFF_MAX_SIZE
+* @param	puiProgrammed, number of bytes actually programmed
+* @return	0 if OK, ERR_FLASHE2DATA_NEEDERASE if the block has to be erased first, ERR_FLASHE2DATA_xxx or
+*			FLASHMAN_STATUS_ERROR otherwise
+*/
+uint8_t FlashMan_WriteDiffDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize, uint16_t *puiProgrammed)
+{
+	uint8_t aucChanged[FLASHMAN_DIFF_MAX_SIZE / 8];
+	const uint8_t *pucImage;
+	uint16_t i;
+	uint16_t uiEnd;
+	uint8_t ucBlank;
+	uint8_t ucReturn;
+	mFlashMan_StatStamp(tStamp);
+
+	*puiProgrammed = 0;
+
+	if((uiSize == 0) || (uiSize > FLASHMAN_DIFF_MAX_SIZE) || !mFlashMan_IsInAreaWr(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+
+	//The read image is not accessible inside of a write transaction
+	if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		mFlashMan_TraceReject(FLASHMAN_TR_DIFF, ulAddr);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	mFlashMan_StatBegin(tStamp);
+	mFlashMan_TraceBegin(FLASHMAN_TR_DIFF, ulAddr, uiSize);
+
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_DIFF, tStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_DIFF, ucReturn);
+		return ucReturn;
+	}
+
+	pucImage = mFlashManHw_ReadPtr((ulAddr - FLASHMAN_BLOCK_ADDR_WR) + FLASHMAN_BLOCK_ADDR_RD);
+	for(i = 0; i < sizeof(aucChanged); i++)
+	{
+		aucChanged[i] = 0;
+	}
+	for(i = 0; i < uiSize; i++)
+	{
+		if(pucImage[i] != pucData[i])
+		{
+			aucChanged[i >> 3] |= (uint8_t)(1U << (i & 7));
+		}
+	}
+
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_PE);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_DIFF, tStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_DIFF, ucReturn);
+		return ucReturn;
+	}
+
+	//Every changed byte must be erased
+	for(i = 0; (i < uiSize) && (ucReturn == 0); i = uiEnd)
+	{
+		uiEnd = FlashMan_DiffRunEndDF(aucChanged, i, uiSize);
+		if(mFlashMan_IsChanged(aucChanged, i))
+		{
+			ucReturn = FlashMan_BlankCheckCmdDF(ulAddr + i, ulAddr + uiEnd - 1, &ucBlank);
+			if((ucReturn == 0) && !ucBlank)
+			{
+				ucReturn = ERR_FLASHE2DATA_NEEDERASE;
+			}
+		}
+	}
+
+	if(ucReturn == 0)
+	{
+		mFlashMan_StageWrite(pucData, ulAddr, uiSize);
+	}
+
+	for(i = 0; (i < uiSize) && (ucReturn == 0); i = uiEnd)
+	{
+		uiEnd = FlashMan_DiffRunEndDF(aucChanged, i, uiSize);
+		if(mFlashMan_IsChanged(aucChanged, i))
+		{
+			ucReturn = FlashMan_ProgramRangeDF(pucData, ulAddr, i, uiEnd, puiProgrammed);
+		}
+		else
+		{
+			ucReturn = FlashMan_ProgramBlankDF(pucData, ulAddr, i, uiEnd, puiProgrammed);
+		}
+	}
+
+	(void)FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+
+	mFlashMan_StatEnd(FLASHMAN_STATS_DIFF, tStamp, ucReturn);
+	mFlashMan_TraceEnd(FLASHMAN_TR_DIFF, ucReturn);
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function opens a write transaction: the data flash enters P/E mode once and stays there until
+*			FlashMan_WriteCommit, whatever the number of FlashMan_WriteAppend calls in between. Only one
+*			transaction can be open at a time and no read can be done while it is open.
+* @param	ptTrans, transaction to open
+* @return	0 if P/E mode is reached, ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_WriteBegin(FlashMan_WriteTrans *ptTrans)
+{
+	uint8_t ucReturn;
+
+	ptTrans->ucOpen = 0;
+	ptTrans->ucStatus = FLASHMAN_STATUS_OK;
+	ptTrans->uiAppends = 0;
+	ptTrans->uiFailedAppend = FLASHMAN_TRANS_NO_FAIL;
+	ptTrans->ulFailedAddr = 0;
+
+	if(FlashMan_IsBusy())
+	{
+		mFlashMan_TraceReject(FLASHMAN_TR_TRANS, 0);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	mFlashMan_StatBegin(s_tFlashManTransStamp);
+	mFlashMan_TraceBegin(FLASHMAN_TR_TRANS, 0, 0);
+
+	//E2Flash a mode P/E
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_PE);
+	if(ucReturn == 0)
+	{
+		ptTrans->ucOpen = 1;
+	}
+	else
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_WRITE, s_tFlashManTransStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_TRANS, ucReturn);
+	}
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function programs one record inside an open write transaction. A record that fails stops at the
+*			failing byte, but the following appends are still programmed; the transaction keeps the first
+*			failure.
+* @param	ptTrans, open transaction
+* @param	pucData, pointer of bytes to write
+* @param	ulAddr, address wherein you want to start writing
+* @param	uiSize, number of bytes to write
+* @return	Write status of this record
+*/
+uint8_t FlashMan_WriteAppend(FlashMan_WriteTrans *ptTrans, const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	uint16_t i;
+	uint8_t ucReturn = FLASHMAN_STATUS_OK;
+
+	if(ptTrans->ucOpen == 0)
+	{
+		ucReturn = ERR_FLASHE2DATA_NOPEMODE;
+	}
+	else if(!mFlashMan_IsInAreaWr(ulAddr, uiSize))
+	{
+		ucReturn = ERR_FLASHE2DATA_OUTRNG;
+	}
+	else
+	{
+		mFlashMan_TraceBegin(FLASHMAN_TR_APPEND, ulAddr, uiSize);
+		mFlashMan_StageWrite(pucData, ulAddr, uiSize);
+		for(i=0;i<uiSize;i++)
+		{
+			ucReturn = FlashMan_WriteAByteDF(*(pucData+i), ulAddr+i);
+
+			if (ucReturn != FLASHMAN_STATUS_OK)	{ ulAddr += i; break;	}	//Exit the for loop
+			else								{ /* EMPTY */			}
+		}
+		mFlashMan_TraceEnd(FLASHMAN_TR_APPEND, ucReturn);
+	}
+
+	if((ucReturn != FLASHMAN_STATUS_OK) && (ptTrans->ucStatus == FLASHMAN_STATUS_OK))
+	{
+		ptTrans->ucStatus = ucReturn;
+		ptTrans->uiFailedAppend = ptTrans->uiAppends;
+		ptTrans->ulFailedAddr = ulAddr;
+	}
+	ptTrans->uiAppends++;
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function closes a write transaction, taking the data flash back to read mode
+* @param	ptTrans, transaction to close
+* @return	Aggregated write status: the status of the first append that failed, FLASHMAN_STATUS_OK if none
+*/
+uint8_t FlashMan_WriteCommit(FlashMan_WriteTrans *ptTrans)
+{
+	if(ptTrans->ucOpen != 0)
+	{
+		//Back to read mode, so the next read does not need any transition
+		(void)FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+		ptTrans->ucOpen = 0;
+		mFlashMan_StatEnd(FLASHMAN_STATS_WRITE, s_tFlashManTransStamp, ptTrans->ucStatus);
+		mFlashMan_TraceEnd(FLASHMAN_TR_TRANS, ptTrans->ucStatus);
+	}
+
+	return ptTrans->ucStatus;
+}
+
+
+/**
+* @brief	This function erases a Flash Memory Block. Synchronous wrapper of FlashMan_SubmitEraseDF.
+* @param	ulAddr, Block address which is wanted to erase
+* @return	Erase status
+*/
+uint8_t FlashMan_BlockEraseDF(uint32_t ulAddr)
+{	
+	return FlashMan_EraseBlocksDF(ulAddr, 1, 0);
+}
+
+
+/**
+* @brief	This function erases uiBlocks consecutive blocks in a single P/E session. Synchronous wrapper of
+*			FlashMan_SubmitEraseBlocksDF.
+* @param	ulAddr, any address of the first block
+* @param	uiBlocks, number of blocks
+* @param	pulFailed, blocks whose erase failed, bit n for block n; 0 if not needed
+* @return	Erase status, ERR_FLASHE2DATA_xxx if the erase could not be started
+*/
+uint8_t FlashMan_EraseBlocksDF(uint32_t ulAddr, uint16_t uiBlocks, uint32_t *pulFailed)
+{
+	uint8_t ucReturn;
+
+	ucReturn = FlashMan_SubmitEraseBlocksDF(ulAddr, uiBlocks, 0);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	FlashMan_WaitDF();
+
+	if(pulFailed != 0)
+	{
+		*pulFailed = s_tFlashManAsync.ulFailed;
+	}
+
+	return s_tFlashManAsync.ucStatus;
+}
+
+
+/**
+* @brief	This function programs a whole data flash image, e.g. the default parameters at the end of line, in a
+*			single P/E session: every block is erased and its bytes to program are programmed, then the data flash
+*			is read back and compared with the image. The bytes not to program are left erased, so the modules can
+*			program them later. The driver is taken for the whole time; only the step hook is called meanwhile.
+* @param	ptImage, image
+* @param	pulFailed, blocks whose erase, program or read back failed, bit n for block n; 0 if not needed
+* @return	0 if OK, FLASHMAN_STATUS_ERROR if a command failed, ERR_FLASHE2DATA_VERIFY if only the read back differs,
+*			ERR_FLASHE2DATA_xxx if the image could not be started
+*/
+uint8_t FlashMan_ProgramImageDF(const FlashMan_Image *ptImage, uint32_t *pulFailed)
+{
+	const uint8_t *pucMemoryPos;
+	uint32_t ulFailed = 0;
+	uint32_t ulBlockAddr;
+	uint16_t uiOffset;
+	uint16_t uiBlock;
+	uint16_t i;
+	uint8_t ucReturn;
+	mFlashMan_StatStamp(tStamp);
+
+	if(pulFailed != 0)
+	{
+		*pulFailed = 0;
+	}
+
+	//Only one operation at a time, and not inside an open write transaction
+	if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		mFlashMan_TraceReject(FLASHMAN_TR_IMAGE, E2FLASHADDR_WRITEBASE);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	mFlashMan_StatBegin(tStamp);
+	mFlashMan_TraceBegin(FLASHMAN_TR_IMAGE, E2FLASHADDR_WRITEBASE, FLASHMAN_BLOCK_NUM);
+
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_PE);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_WRITE, tStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_IMAGE, ucReturn);
+		return ucReturn;
+	}
+	mFlashMan_StageErase(E2FLASHADDR_WRITEBASE, FLASHMAN_BLOCK_NUM);
+
+	for(uiBlock = 0; uiBlock < FLASHMAN_BLOCK_NUM; uiBlock++)
+	{
+		ulBlockAddr = mFlashMan_BlockAddrWr(uiBlock);
+		FlashMan_StartRangeCmdDF(FLASHMAN_FCR_ERASE, ulBlockAddr, ulBlockAddr + FLASHMAN_BLOCK_SIZE - 1);
+		while(mFlashMan_IsReady() == 0)
+		{
+		}
+		mFlashMan_StepHook();
+		if(FlashMan_EndCmdDF() != FLASHMAN_STATUS_OK)
+		{
+			ulFailed |= 1UL << uiBlock;
+			continue;
+		}
+#ifdef FLASHMAN_CRC
+		s_atFlashManDigest[uiBlock].tDigest.uiCrc = FLASHMAN_CRC_INIT;
+		s_atFlashManDigest[uiBlock].tDigest.uiLength = 0;
+		s_atFlashManDigest[uiBlock].ucState = FLASHMAN_DIGEST_VALID;
+#endif
+
+		uiOffset = (uint16_t)(uiBlock << FLASHMAN_BLOCK_SHIFT);
+		for(i = 0; i < FLASHMAN_BLOCK_SIZE; i++, uiOffset++)
+		{
+			if(	mFlashMan_IsChanged(ptImage->pucProgram, uiOffset)
+				&& (FlashMan_WriteAByteDF(ptImage->pucData[uiOffset], ulBlockAddr + i) != FLASHMAN_STATUS_OK))
+			{
+				ulFailed |= 1UL << uiBlock;
+				break;
+			}
+		}
+	}
+	ucReturn = (ulFailed != 0) ? FLASHMAN_STATUS_ERROR : FLASHMAN_STATUS_OK;
+
+	//Read back the blocks programmed
+	(void)FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+	pucMemoryPos = mFlashManHw_ReadPtr(E2FLASHADDR_READBASE);
+	for(uiOffset = 0; uiOffset < FLASHMAN_AREA_SIZE; uiOffset++)
+	{
+		uiBlock = (uint16_t)(uiOffset >> FLASHMAN_BLOCK_SHIFT);
+		if(	((ulFailed & (1UL << uiBlock)) == 0) && mFlashMan_IsChanged(ptImage->pucProgram, uiOffset)
+			&& (pucMemoryPos[uiOffset] != ptImage->pucData[uiOffset]))
+		{
+			ulFailed |= 1UL << uiBlock;
+			ucReturn = (ucReturn == FLASHMAN_STATUS_OK) ? ERR_FLASHE2DATA_VERIFY : ucReturn;
+		}
+	}
+
+	if(pulFailed != 0)
+	{
+		*pulFailed = ulFailed;
+	}
+	mFlashMan_StatEnd(FLASHMAN_STATS_WRITE, tStamp, ucReturn);
+	mFlashMan_TraceEnd(FLASHMAN_TR_IMAGE, ucReturn);
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function searches, by bisection over blank checks, the offset from which ulAddr + uiLow ..
+*			ulAddr + uiHigh - 1 is erased, the range being written from its start. Data flash must be in P/E mode.
+* @param	ulAddr, base address (E2FLASHADDR_WRITEBASE based)
+* @param	uiLow, first offset of the range
+* @param	uiHigh, offset after the range, known to be erased from here on
+* @param	puiOffset, offset of the first erased byte, uiHigh if the range is full
+* @return	Command status
+*/
+static uint8_t FlashMan_FrontierCmdDF(uint32_t ulAddr, uint16_t uiLow, uint16_t uiHigh, uint16_t *puiOffset)
+{
+	uint16_t uiMid;
+	uint8_t ucBlank;
+	uint8_t ucReturn = FLASHMAN_STATUS_OK;
+
+	while((uiLow < uiHigh) && (ucReturn == FLASHMAN_STATUS_OK))
+	{
+		uiMid = (uint16_t)(uiLow + ((uiHigh - uiLow) / 2));
+		ucReturn = FlashMan_BlankCheckCmdDF(ulAddr + uiMid, ulAddr + uiHigh - 1, &ucBlank);
+		if(ucBlank)
+		{
+			uiHigh = uiMid;
+		}
+		else
+		{
+			uiLow = (uint16_t)(uiMid + 1);
+		}
+	}
+	*puiOffset = uiHigh;
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function checks with the sequencer blank check command whether a range of the data flash is erased.
+*			Erased cells read as undefined values, so this is the only reliable way to tell them from written ones.
+* @param	ulAddr, first address (E2FLASHADDR_WRITEBASE based)
+* @param	uiSize, number of bytes
+* @param	pucBlank, 1 if every byte of the range is erased, 0 otherwise
+* @return	0 if OK, ERR_FLASHE2DATA_xxx or FLASHMAN_STATUS_ERROR otherwise
+*/
+uint8_t FlashMan_BlankCheckDF(uint32_t ulAddr, uint16_t uiSize, uint8_t *pucBlank)
+{
+	uint8_t ucMode = s_ucFlashManMode;
+	uint8_t ucReturn;
+	mFlashMan_StatStamp(tStamp);
+
+	if((uiSize == 0) || !mFlashMan_IsInAreaWr(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	if(FlashMan_IsBusy())
+	{
+		mFlashMan_TraceReject(FLASHMAN_TR_BLANKCHECK, ulAddr);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	mFlashMan_StatBegin(tStamp);
+	mFlashMan_TraceBegin(FLASHMAN_TR_BLANKCHECK, ulAddr, uiSize);
+
+	//Inside of a write transaction the data flash is already in P/E mode and it is left so
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_PE);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_BLANKCHECK, tStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_BLANKCHECK, ucReturn);
+		return ucReturn;
+	}
+
+	ucReturn = FlashMan_BlankCheckCmdDF(ulAddr, ulAddr + uiSize - 1, pucBlank);
+
+	(void)FlashMan_SetModeDF((ucMode == FLASHMAN_MODE_PE) ? FLASHMAN_MODE_PE : FLASHMAN_MODE_READ);
+
+	mFlashMan_StatEnd(FLASHMAN_STATS_BLANKCHECK, tStamp, ucReturn);
+	mFlashMan_TraceEnd(FLASHMAN_TR_BLANKCHECK, ucReturn);
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function finds the write frontier of a range filled from its start, like a log: the offset from
+*			which the rest of the range is erased. It is a binary search over blank checks, so it takes
+*			log2(uiSize) + 1 sequencer commands at most instead of reading the whole range.
+* @param	ulAddr, first address of the range (E2FLASHADDR_WRITEBASE based)
+* @param	uiSize, number of bytes
+* @param	puiOffset, offset of the first erased byte, uiSize if the range is full
+* @return	0 if OK, ERR_FLASHE2DATA_xxx or FLASHMAN_STATUS_ERROR otherwise
+*/
+uint8_t FlashMan_FindFrontierDF(uint32_t ulAddr, uint16_t uiSize, uint16_t *puiOffset)
+{
+	uint8_t ucMode = s_ucFlashManMode;
+	uint8_t ucReturn;
+	mFlashMan_StatStamp(tStamp);
+
+	if((uiSize == 0) || !mFlashMan_IsInAreaWr(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	if(FlashMan_IsBusy())
+	{
+		mFlashMan_TraceReject(FLASHMAN_TR_FRONTIER, ulAddr);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	mFlashMan_StatBegin(tStamp);
+	mFlashMan_TraceBegin(FLASHMAN_TR_FRONTIER, ulAddr, uiSize);
+
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_PE);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd(FLASHMAN_STATS_BLANKCHECK, tStamp, ucReturn);
+		mFlashMan_TraceEnd(FLASHMAN_TR_FRONTIER, ucReturn);
+		return ucReturn;
+	}
+
+	ucReturn = FlashMan_FrontierCmdDF(ulAddr, 0, uiSize, puiOffset);
+
+	(void)FlashMan_SetModeDF((ucMode == FLASHMAN_MODE_PE) ? FLASHMAN_MODE_PE : FLASHMAN_MODE_READ);
+
+	mFlashMan_StatEnd(FLASHMAN_STATS_BLANKCHECK, tStamp, ucReturn);
+	mFlashMan_TraceEnd(FLASHMAN_TR_FRONTIER, ucReturn);
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function submits an asynchronous write: the data flash enters P/E mode and the first byte is
+*			started, the rest is done by FlashMan_Poll. pucData must stay valid until the operation ends.
+* @param	pucData, pointer of bytes to write
+* @param	ulAddr, address wherein you want to start writing
+* @param	uiSize, number of bytes to write
+* @param	pfnDone, function called with the write status when the operation ends, 0 if not needed
+* @return	0 if the operation is started, ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_SubmitWriteDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize, FlashMan_DoneCb pfnDone)
+{
+	uint8_t ucReturn;
+
+	if(!mFlashMan_IsInAreaWr(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+
+	ucReturn = FlashMan_SubmitDF(FLASHMAN_OP_WRITE, pucData, ulAddr, uiSize, pfnDone);
+	if(ucReturn == 0)
+	{
+		mFlashMan_StageWrite(pucData, ulAddr, uiSize);
+	}
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function submits an asynchronous block erase, the rest is done by FlashMan_Poll. The block is
+*			blank checked first and a blank block is not erased again.
+* @param	ulAddr, any address of the block which is wanted to erase
+* @param	pfnDone, function called with the erase status when the operation ends, 0 if not needed
+* @return	0 if the operation is started, ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_SubmitEraseDF(uint32_t ulAddr, FlashMan_DoneCb pfnDone)
+{
+	return FlashMan_SubmitEraseBlocksDF(ulAddr, 1, pfnDone);
+}
+
+
+/**
+* @brief	This function submits an asynchronous erase of uiBlocks consecutive blocks, the rest is done by
+*			FlashMan_Poll in a single P/E session. Every block is blank checked first; each run of blocks that
+*			are not blank is erased with one command when the device allows it (FLASHMAN_ERASE_RANGE), and
+*			again block by block if that command fails, to tell which blocks failed.
+* @param	ulAddr, any address of the first block
+* @param	uiBlocks, number of blocks
+* @param	pfnDone, function called with the erase status when the operation ends, 0 if not needed
+* @return	0 if the operation is started, ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_SubmitEraseBlocksDF(uint32_t ulAddr, uint16_t uiBlocks, FlashMan_DoneCb pfnDone)
+{
+	uint8_t ucReturn;
+
+	ulAddr = mFlashMan_BlockBase(ulAddr);
+	if((uiBlocks == 0) || (uiBlocks > FLASHMAN_BLOCK_NUM)
+		|| !mFlashMan_IsInAreaWr(ulAddr, (uint32_t)uiBlocks << FLASHMAN_BLOCK_SHIFT))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+
+	ucReturn = FlashMan_SubmitDF(FLASHMAN_OP_ERASE, 0, ulAddr, uiBlocks, pfnDone);
+	if(ucReturn == 0)
+	{
+		mFlashMan_StageErase(ulAddr, uiBlocks);
+	}
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function starts an asynchronous operation whose range is already checked by FlashMan_SubmitWriteDF
+*			or FlashMan_SubmitEraseBlocksDF. The operation in progress is not touched until the submit is accepted.
+* @param	ucOp, FLASHMAN_OP_WRITE or FLASHMAN_OP_ERASE
+* @param	pucData, bytes to write, 0 for an erase
+* @param	ulAddr, first address of the operation
+* @param	uiSize, number of bytes to write or of blocks to erase
+* @param	pfnDone, completion callback, 0 if not needed
+* @return	0 if the operation is started, ERR_FLASHE2DATA_xxx otherwise
+*/
+static uint8_t FlashMan_SubmitDF(uint8_t ucOp, const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize,
+									FlashMan_DoneCb pfnDone)
+{
+	uint8_t ucReturn;
+
+	//Only one operation at a time, and not inside an open write transaction
+	if((s_tFlashManAsync.ucState != FLASHMAN_ST_IDLE) || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+	{
+		mFlashMan_TraceReject((ucOp == FLASHMAN_OP_ERASE) ? FLASHMAN_TR_ERASE : FLASHMAN_TR_WRITE, ulAddr);
+		return ERR_FLASHE2DATA_BUSY;
+	}
+
+	mFlashMan_StatBegin(s_tFlashManAsync.tStamp);
+	mFlashMan_TraceBegin((ucOp == FLASHMAN_OP_ERASE) ? FLASHMAN_TR_ERASE : FLASHMAN_TR_WRITE, ulAddr, uiSize);
+
+	//Enter in program-erase mode
+	ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_PE);
+	if(ucReturn != 0)
+	{
+		mFlashMan_StatEnd((ucOp == FLASHMAN_OP_ERASE) ? FLASHMAN_STATS_ERASE : FLASHMAN_STATS_WRITE,
+							s_tFlashManAsync.tStamp, ucReturn);
+		mFlashMan_TraceEnd((ucOp == FLASHMAN_OP_ERASE) ? FLASHMAN_TR_ERASE : FLASHMAN_TR_WRITE, ucReturn);
+		return ucReturn;
+	}
+
+	s_tFlashManAsync.ucOp = ucOp;
+	s_tFlashManAsync.pucData = pucData;
+	s_tFlashManAsync.uiSize = uiSize;
+	s_tFlashManAsync.ucStatus = FLASHMAN_STATUS_OK;
+	s_tFlashManAsync.ulAddr = ulAddr;
+	s_tFlashManAsync.uiDone = 0;
+#ifdef FLASHMAN_NO_BLANK_SKIP
+	s_tFlashManAsync.ucPhase = FLASHMAN_ERASE_BLOCKS;
+	s_tFlashManAsync.uiRun = s_tFlashManAsync.uiSize;
+#else
+	s_tFlashManAsync.ucPhase = FLASHMAN_ERASE_CHECK;
+	s_tFlashManAsync.uiRun = 0;
+#endif
+	s_tFlashManAsync.uiSkip = 0;
+	s_tFlashManAsync.ulFailed = 0;
+	s_tFlashManAsync.pfnDone = pfnDone;
+#ifdef FLASHMAN_CRC
+	//Not known until the erase ends
+	if(ucOp == FLASHMAN_OP_ERASE)
+	{
+		uint16_t i;
+
+		for(i = 0; i < s_tFlashManAsync.uiSize; i++)
+		{
+			s_atFlashManDigest[mFlashMan_BlockOfWr(ulAddr) + i].ucState = FLASHMAN_DIGEST_UNKNOWN;
+		}
+	}
+#endif
+
+#ifdef FLASHMAN_USE_FRDYI
+	//Only the first command is started here, FlashMan_FrdyIsr ends it and goes on. The state is set first, as the
+	//interrupt may come before the command start returns.
+	s_tFlashManAsync.ucState = FLASHMAN_ST_WAIT;
+	mFlashManHw_SetFRDYIE(1);
+	if(ucOp == FLASHMAN_OP_WRITE)
+	{
+		if(uiSize != 0)
+		{
+			FlashMan_StartProgramDF(pucData[0], ulAddr);
+		}
+		else
+		{
+			FlashMan_FinishDF(FLASHMAN_STATUS_OK);
+		}
+	}
+	else if(!FlashMan_StartEraseStepDF())
+	{
+		FlashMan_FinishDF(FLASHMAN_STATUS_OK);
+	}
+	else
+	{
+		// Empty
+	}
+#else
+	s_tFlashManAsync.ucState = FLASHMAN_ST_START;
+	(void)FlashMan_Poll();
+#endif
+
+	return 0;
+}
+
+
+/**
+* @brief	This function advances the asynchronous operation in progress without waiting for the sequencer:
+*			when FRDY is set the command is ended and the next one started. It is called from the scheduler
+*			tick, or from FlashMan_FrdyIsr when FLASHMAN_USE_FRDYI is defined, but never from both. When the
+*			operation ends the data flash goes back to read mode and the completion callback is called.
+* @param	none
+* @return	FLASHMAN_ASYNC_BUSY while an operation is in progress, FLASHMAN_ASYNC_IDLE otherwise
+*/
+uint8_t FlashMan_Poll(void)
+{
+	uint8_t ucReturn;
+	uint16_t uiSteps = 0;
+#ifndef FLASHMAN_NO_STATS
+	uint32_t ulPsw;
+	uint32_t ulCycles = mFlashManHw_GetCycles();
+#endif
+
+	ucReturn = FlashMan_StepDF(FLASHMAN_STEPS_ALL, &uiSteps);
+
+#ifndef FLASHMAN_NO_STATS
+	ulCycles = mFlashManHw_GetCycles() - ulCycles;
+	mFlashManHw_IntSave(ulPsw);
+	if(ulCycles > s_tFlashManStats.ulPollCyclesMax)
+	{
+		s_tFlashManStats.ulPollCyclesMax = ulCycles;
+	}
+	mFlashManHw_IntRestore(ulPsw);
+#endif
+
+	return ucReturn;
+}
+
+
+#ifndef FLASHMAN_USE_FRDYI
+/**
+* @brief	This function runs the asynchronous operation in progress for a bounded time, so flash work fits in a
+*			fixed scheduler slot: it waits for the sequencer and goes on with the next commands until the operation
+*			ends, uiMaxSteps commands are done or ulMaxUs have passed, whichever comes first. The next call resumes
+*			where this one stopped. A command already started is not waited for once the time is over: it goes on
+*			in the sequencer and is ended by the next call, so a call lasts at most ulMaxUs plus the end of a
+*			command and the start of the next one. The step hook is called once per command ended.
+*			The time budget needs mFlashManHw_GetCycles, i.e. FLASHMAN_GET_CYCLES on the target.
+* @param	ulMaxUs, time budget, 0 for no time limit
+* @param	uiMaxSteps, commands to do at most (one byte programmed, one block blank checked or erased), 0 for no
+*			limit. With no limit at all the operation is run to its end.
+* @return	FLASHMAN_ASYNC_BUSY while an operation is in progress, FLASHMAN_ASYNC_IDLE otherwise,
+*			ERR_FLASHE2DATA_OUTRNG if a time budget is given without a cycle counter (nothing is done)
+*/
+uint8_t FlashMan_PollBudget(uint32_t ulMaxUs, uint16_t uiMaxSteps)
+{
+	uint8_t ucReturn;
+	uint16_t uiSteps = 0;
+	uint16_t uiHooked;
+	uint32_t ulStart = mFlashManHw_GetCycles();
+	uint32_t ulBudget;
+	uint64_t ullBudget;
+
+	if((ulMaxUs != 0) && !mFlashManHw_HasCycles())
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	//In 64 bits: a budget beyond the counter range (89 s at 48 MHz) is clamped to it, not wrapped
+	ullBudget = (uint64_t)ulMaxUs * FLASHMAN_CYCLES_US;
+	ulBudget = (ullBudget > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)ullBudget;
+	if(uiMaxSteps == 0)
+	{
+		uiMaxSteps = FLASHMAN_STEPS_ALL;
+	}
+
+	for(;;)
+	{
+		uiHooked = uiSteps;
+		ucReturn = FlashMan_StepDF(uiMaxSteps, &uiSteps);
+		//Once per command ended, not every time the sequencer is found busy
+		for(; uiHooked < uiSteps; uiHooked++)
+		{
+			mFlashMan_StepHook();
+		}
+		if((ucReturn == FLASHMAN_ASYNC_IDLE) || (uiSteps >= uiMaxSteps))
+		{
+			break;
+		}
+		if((ulMaxUs != 0) && ((mFlashManHw_GetCycles() - ulStart) >= ulBudget))
+		{
+			break;
+		}
+	}
+
+	return ucReturn;
+}
+#endif
+
+
+/**
+* @brief	This function sets the step hook, called once per command ended (byte programmed, block erased or
+*			blank checked) of the long operations: in the synchronous calls and in FlashMan_PollBudget (not in
+*			FlashMan_Poll). It is meant for a watchdog refresh or a scheduler yield; the data flash is in P/E mode
+*			when it is called, so it must not use the Flash Manager module.
+* @param	pfnHook, hook, 0 for none
+* @return	none
+*/
+void FlashMan_SetStepHook(FlashMan_StepHook pfnHook)
+{
+	s_pfnFlashManStepHook = pfnHook;
+}
+
+
+/**
+* @brief	This function ends the command in progress of the asynchronous operation if FRDY is set and starts the
+*			next ones, as long as the sequencer is ready and fewer than uiMaxSteps commands have been ended
+* @param	uiMaxSteps, commands to end at most
+* @param	puiSteps, commands ended so far, incremented for every command ended
+* @return	FLASHMAN_ASYNC_BUSY while an operation is in progress, FLASHMAN_ASYNC_IDLE otherwise
+*/
+static uint8_t FlashMan_StepDF(uint16_t uiMaxSteps, uint16_t *puiSteps)
+{
+	uint8_t ucStatus;
+	uint8_t ucNotBlank;
+	uint8_t ucReturn = FLASHMAN_ASYNC_IDLE;
+
+	while(s_tFlashManAsync.ucState != FLASHMAN_ST_IDLE)
+	{
+		if(s_tFlashManAsync.ucState == FLASHMAN_ST_START)
+		{
+			if((s_tFlashManAsync.ucOp == FLASHMAN_OP_WRITE) && (s_tFlashManAsync.uiDone >= s_tFlashManAsync.uiSize))
+			{
+				FlashMan_FinishDF(FLASHMAN_STATUS_OK);
+				break;
+			}
+			//Budget used: the next command is started by the next call
+			if(*puiSteps >= uiMaxSteps)
+			{
+				ucReturn = FLASHMAN_ASYNC_BUSY;
+				break;
+			}
+			if(s_tFlashManAsync.ucOp == FLASHMAN_OP_WRITE)
+			{
+				FlashMan_StartProgramDF(s_tFlashManAsync.pucData[s_tFlashManAsync.uiDone],
+										s_tFlashManAsync.ulAddr + s_tFlashManAsync.uiDone);
+			}
+			else if(!FlashMan_StartEraseStepDF())
+			{
+				FlashMan_FinishDF((s_tFlashManAsync.ulFailed != 0) ? FLASHMAN_STATUS_ERROR : FLASHMAN_STATUS_OK);
+				break;
+			}
+			else
+			{
+				// Empty
+			}
+			s_tFlashManAsync.ucState = FLASHMAN_ST_WAIT;
+		}
+
+		//Sequencer still busy: come back on the next tick / interrupt
+		if(mFlashMan_IsReady() == 0)
+		{
+			ucReturn = FLASHMAN_ASYNC_BUSY;
+			break;
+		}
+
+		//The blank check result is lost in FlashMan_EndCmdDF
+		ucNotBlank = (uint8_t)mFlashManHw_IsBCERR();
+		ucStatus = FlashMan_EndCmdDF();
+		(*puiSteps)++;
+		s_uiFlashManCmds++;
+		if(s_tFlashManAsync.ucOp == FLASHMAN_OP_ERASE)
+		{
+			FlashMan_EndEraseStepDF(ucStatus, ucNotBlank);
+		}
+		else if(ucStatus != FLASHMAN_STATUS_OK)
+		{
+			FlashMan_FinishDF(ucStatus);
+			break;
+		}
+		else
+		{
+			s_tFlashManAsync.uiDone++;
+		}
+
+		s_tFlashManAsync.ucState = FLASHMAN_ST_START;
+	}
+
+	return ucReturn;
+}
+
+
+/**
+* @brief	This function starts the next command of the asynchronous erase: the blank check of the next block, or
+*			the erase of the run of blocks found not blank once the run ends
+* @param	none
+* @return	1 if a command was started, 0 if the erase is complete
+*/
+static uint8_t FlashMan_StartEraseStepDF(void)
+{
+	FlashMan_AsyncOp *ptOp = &s_tFlashManAsync;
+	uint32_t ulStart = ptOp->ulAddr + ((uint32_t)ptOp->uiDone << FLASHMAN_BLOCK_SHIFT);
+	uint16_t uiBlocks = 1;
+
+	if(ptOp->ucPhase == FLASHMAN_ERASE_CHECK)
+	{
+		if((ptOp->uiDone + ptOp->uiRun) < ptOp->uiSize)
+		{
+			ulStart += (uint32_t)ptOp->uiRun << FLASHMAN_BLOCK_SHIFT;
+			FlashMan_StartRangeCmdDF(FLASHMAN_FCR_BLANKCHECK, ulStart, ulStart + FLASHMAN_BLOCK_SIZE - 1);
+			return 1;
+		}
+		if(ptOp->uiRun == 0)
+		{
+			return 0;
+		}
+		//Run up to the last block
+		ptOp->ucPhase = FLASHMAN_ERASE_BLOCKS;
+	}
+
+	if(ptOp->ucPhase == FLASHMAN_ERASE_RUN)
+	{
+		uiBlocks = ptOp->uiRun;
+	}
+	FlashMan_StartRangeCmdDF(FLASHMAN_FCR_ERASE, ulStart, ulStart + ((uint32_t)uiBlocks << FLASHMAN_BLOCK_SHIFT) - 1);
+
+	return 1;
+}
+
+
+/**
+* @brief	This function takes the result of the last command of the asynchronous erase
+* @param	ucStatus, command status
+* @param	ucNotBlank, blank check result, 1 if the block is not blank
+* @return	none
+*/
+static void FlashMan_EndEraseStepDF(uint8_t ucStatus, uint8_t ucNotBlank)
+{
+	FlashMan_AsyncOp *ptOp = &s_tFlashManAsync;
+	uint8_t ucRunEnd = 0;
+
+	switch(ptOp->ucPhase)
+	{
+		case FLASHMAN_ERASE_CHECK:
+			//A block that cannot be blank checked is erased anyway
+			if(ucNotBlank || (ucStatus != FLASHMAN_STATUS_OK))
+			{
+				ptOp->uiRun++;
+#if !FLASHMAN_ERASE_RANGE
+				ptOp->ucPhase = FLASHMAN_ERASE_BLOCKS;
+#endif
+			}
+			else if(ptOp->uiRun != 0)
+			{
+				ptOp->uiSkip = 1;
+				ptOp->ucPhase = FLASHMAN_ERASE_BLOCKS;
+			}
+			else
+			{
+				ptOp->uiDone++;
+			}
+			break;
+
+		case FLASHMAN_ERASE_RUN:
+			if((ucStatus == FLASHMAN_STATUS_OK) || (ptOp->uiRun == 1))
+			{
+				if(ucStatus != FLASHMAN_STATUS_OK)
+				{
+					ptOp->ulFailed |= 1UL << (mFlashMan_BlockOfWr(ptOp->ulAddr) + ptOp->uiDone);
+				}
+				ptOp->uiDone += ptOp->uiRun;
+				ptOp->uiRun = 0;
+				ucRunEnd = 1;
+			}
+			else
+			{
+				//Again block by block, to know which ones fail
+				ptOp->ucPhase = FLASHMAN_ERASE_SINGLE;
+			}
+			break;
+
+		default:
+			if(ucStatus != FLASHMAN_STATUS_OK)
+			{
+				ptOp->ulFailed |= 1UL << (mFlashMan_BlockOfWr(ptOp->ulAddr) + ptOp->uiDone);
+			}
+			ptOp->uiDone++;
+			ptOp->uiRun--;
+			ucRunEnd = (uint8_t)(ptOp->uiRun == 0);
+			break;
+	}
+
+	if(ucRunEnd)
+	{
+		ptOp->uiDone += ptOp->uiSkip;
+		ptOp->uiSkip = 0;
+		ptOp->ucPhase = FLASHMAN_ERASE_CHECK;
+	}
+}
+
+
+/**
+* @brief	This function waits for the end of the asynchronous operation of a synchronous call, with the step hook
+*			called once per command ended
+* @param	none
+* @return	none
+*/
+static void FlashMan_WaitDF(void)
+{
+	uint16_t uiCmds = s_uiFlashManCmds;
+
+	for(;;)
+	{
+#ifdef FLASHMAN_USE_FRDYI
+		//Driven by FlashMan_FrdyIsr only
+		mFlashManHw_Spin();
+		if(!FlashMan_IsBusy())
+#else
+		if(FlashMan_Poll() != FLASHMAN_ASYNC_BUSY)
+#endif
+		{
+			break;
+		}
+		for(; uiCmds != s_uiFlashManCmds; uiCmds++)
+		{
+			mFlashMan_StepHook();
+		}
+	}
+}
+
+
+/**
+* @brief	This function ends the asynchronous operation in progress
+* @param	ucStatus, operation status
+* @return	none
+*/
+static void FlashMan_FinishDF(uint8_t ucStatus)
+{
+#ifdef FLASHMAN_USE_FRDYI
+	mFlashManHw_SetFRDYIE(0);
+#endif
+
+	//Exit from program-erase mode
+	(void)FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+
+	s_tFlashManAsync.ucStatus = ucStatus;
+	s_tFlashManAsync.ucState = FLASHMAN_ST_IDLE;
+#ifdef FLASHMAN_CRC
+	if(s_tFlashManAsync.ucOp == FLASHMAN_OP_ERASE)
+	{
+		FlashMan_DigestEraseDF();
+	}
+#endif
+
+	mFlashMan_StatEnd((s_tFlashManAsync.ucOp == FLASHMAN_OP_ERASE) ? FLASHMAN_STATS_ERASE : FLASHMAN_STATS_WRITE,
+						s_tFlashManAsync.tStamp, ucStatus);
+	mFlashMan_TraceEnd((s_tFlashManAsync.ucOp == FLASHMAN_OP_ERASE) ? FLASHMAN_TR_ERASE : FLASHMAN_TR_WRITE, ucStatus);
+
+	if(s_tFlashManAsync.pfnDone != 0)
+	{
+		s_tFlashManAsync.pfnDone(ucStatus);
+	}
+}
+
+
+/**
+* @brief	This function tells whether an asynchronous operation is in progress
+* @param	none
+* @return	1 if busy, 0 otherwise
+*/
+uint8_t FlashMan_IsBusy(void)
+{
+	//Volatile read: the state may be changed by FlashMan_FrdyIsr while the caller waits
+	return (uint8_t)(*(volatile const uint8_t *)&s_tFlashManAsync.ucState != FLASHMAN_ST_IDLE);
+}
+
+
+/**
+* @brief	This function gives the status of the last asynchronous operation
+* @param	none
+* @return	Write/erase status
+*/
+uint8_t FlashMan_GetLastStatus(void)
+{
+	return s_tFlashManAsync.ucStatus;
+}
+
+
+/**
+* @brief	This function gives the blocks that failed in the last asynchronous erase
+* @param	none
+* @return	Bit n set if the erase of block n failed
+*/
+uint32_t FlashMan_GetFailedBlocks(void)
+{
+	return s_tFlashManAsync.ulFailed;
+}
+
+
+#ifndef FLASHMAN_NO_STATS
+/**
+* @brief	This function takes the start of an operation for the statistics
+* @param	ptStamp, start of the operation
+* @return	none
+*/
+static void FlashMan_StatBeginDF(FlashMan_StatStamp *ptStamp)
+{
+	ptStamp->ulCycles = mFlashManHw_GetCycles();
+	ptStamp->ulPolls = s_ulFlashManFrdyPolls;
+}
+
+
+/**
+* @brief	This function adds an operation that has ended to the statistics of its type
+* @param	ucOp, FLASHMAN_STATS_xxx
+* @param	ptStamp, start of the operation
+* @param	ucStatus, operation result, 0 if OK
+* @return	none
+*/
+static void FlashMan_StatEndDF(uint8_t ucOp, const FlashMan_StatStamp *ptStamp, uint8_t ucStatus)
+{
+	FlashMan_OpStats *ptOp = &s_tFlashManStats.atOp[ucOp];
+	uint32_t ulCycles = mFlashManHw_GetCycles() - ptStamp->ulCycles;
+	uint32_t ulPsw;
+
+	mFlashManHw_IntSave(ulPsw);
+	ptOp->ulCalls++;
+	if(ucStatus != 0)
+	{
+		ptOp->ulErrors++;
+	}
+	ptOp->ulFrdyPolls += s_ulFlashManFrdyPolls - ptStamp->ulPolls;
+	ptOp->ullCyclesTotal += ulCycles;
+	if(ulCycles < ptOp->ulCyclesMin)
+	{
+		ptOp->ulCyclesMin = ulCycles;
+	}
+	if(ulCycles > ptOp->ulCyclesMax)
+	{
+		ptOp->ulCyclesMax = ulCycles;
+	}
+	mFlashManHw_IntRestore(ulPsw);
+}
+
+
+/**
+* @brief	This function adds to a statistics counter with interrupts masked
+* @param	pulCounter, counter
+* @param	ulValue, value to add
+* @return	none
+*/
+static void FlashMan_StatAddDF(uint32_t *pulCounter, uint32_t ulValue)
+{
+	uint32_t ulPsw;
+
+	mFlashManHw_IntSave(ulPsw);
+	*pulCounter += ulValue;
+	mFlashManHw_IntRestore(ulPsw);
+}
+
+
+/**
+* @brief	This function copies the driver statistics, with interrupts masked so the copy is consistent
+* @param	ptStats, copy of the statistics
+* @return	none
+*/
+void FlashMan_GetStats(FlashMan_Stats *ptStats)
+{
+	uint32_t ulPsw;
+
+	mFlashManHw_IntSave(ulPsw);
+	*ptStats = s_tFlashManStats;
+	mFlashManHw_IntRestore(ulPsw);
+}
+
+
+/**
+* @brief	This function clears the driver statistics
+* @param	none
+* @return	none
+*/
+void FlashMan_ResetStats(void)
+{
+	uint32_t ulPsw;
+	uint8_t i;
+
+	mFlashManHw_IntSave(ulPsw);
+	s_tFlashManStats = (FlashMan_Stats){ 0 };
+	for(i = 0; i < FLASHMAN_STATS_OPS; i++)
+	{
+		s_tFlashManStats.atOp[i].ulCyclesMin = 0xFFFFFFFFUL;
+	}
+	mFlashManHw_IntRestore(ulPsw);
+}
+#endif
+
+
+#ifdef FLASHMAN_CRC
+/**
+* @brief	This function computes the CRC-16/CCITT of a buffer, table driven or, with FLASHMAN_USE_CRC_UNIT, with
+*			the CRC calculator of the device. Start from FLASHMAN_CRC_INIT; the CRC of several consecutive
+*			buffers is computed by passing the result of each one to the next.
+* @param	uiCrc, CRC of the previous data, FLASHMAN_CRC_INIT at the start
+* @param	pucData, data
+* @param	uiSize, number of bytes
+* @return	CRC up to the end of the data
+*/
+uint16_t FlashMan_Crc16(uint16_t uiCrc, const uint8_t *pucData, uint16_t uiSize)
+{
+	uint16_t i;
+
+#ifdef FLASHMAN_USE_CRC_UNIT
+	mFlashManHw_CrcStart(uiCrc);
+	for(i = 0; i < uiSize; i++)
+	{
+		mFlashManHw_CrcByte(pucData[i]);
+	}
+	uiCrc = mFlashManHw_CrcResult();
+#else
+	for(i = 0; i < uiSize; i++)
+	{
+		uiCrc = mFlashMan_Crc16Byte(uiCrc, pucData[i]);
+	}
+#endif
+
+	return uiCrc;
+}
+
+
+/**
+* @brief	This function extends the digest of a block with a byte being programmed. The digest follows the
+*			programmed part of the block as long as it is written in order from its start, as logs and records
+*			are; a byte programmed anywhere else leaves the digest to be scanned again.
+* @param	ucData, byte
+* @param	ulAddr, address (E2FLASHADDR_WRITEBASE based)
+* @return	none
+*/
+static void FlashMan_DigestProgramDF(uint8_t ucData, uint32_t ulAddr)
+{
+	FlashMan_BlockDigest *ptBlock = &s_atFlashManDigest[mFlashMan_BlockOfWr(ulAddr)];
+
+	s_ptFlashManDigestLast = ptBlock;
+	if((ptBlock->ucState != FLASHMAN_DIGEST_UNKNOWN)
+		&& ((uint16_t)(ulAddr & FLASHMAN_BLOCK_MASK) == ptBlock->tDigest.uiLength))
+	{
+		ptBlock->tDigest.uiCrc = mFlashMan_Crc16Byte(ptBlock->tDigest.uiCrc, ucData);
+		ptBlock->tDigest.uiLength++;
+	}
+	else
+	{
+		ptBlock->ucState = FLASHMAN_DIGEST_UNKNOWN;
+	}
+}
+
+
+/**
+* @brief	This function empties the digests of the blocks of the asynchronous erase that just ended, but the
+*			ones that failed
+* @param	none
+* @return	none
+*/
+static void FlashMan_DigestEraseDF(void)
+{
+	uint16_t uiBlock = mFlashMan_BlockOfWr(s_tFlashManAsync.ulAddr);
+	uint16_t i;
+
+	for(i = 0; i < s_tFlashManAsync.uiSize; i++, uiBlock++)
+	{
+		if((s_tFlashManAsync.ulFailed & (1UL << uiBlock)) == 0)
+		{
+			s_atFlashManDigest[uiBlock].tDigest.uiCrc = FLASHMAN_CRC_INIT;
+			s_atFlashManDigest[uiBlock].tDigest.uiLength = 0;
+			s_atFlashManDigest[uiBlock].ucState = FLASHMAN_DIGEST_VALID;
+		}
+	}
+}
+
+
+/**
+* @brief	This function computes the digest of a block from the data flash: its length is the given one, or the
+*			write frontier if it is to be searched, but the whole block if something was programmed beyond it
+* @param	uiBlock, block
+* @param	uiLength, length of the programmed part, FLASHMAN_DIGEST_SEARCH to search it
+* @param	ptDigest, digest
+* @return	0 if OK, ERR_FLASHE2DATA_xxx or FLASHMAN_STATUS_ERROR otherwise
+*/
+static uint8_t FlashMan_ScanDigestDF(uint16_t uiBlock, uint16_t uiLength, FlashMan_Digest *ptDigest)
+{
+	uint32_t ulAddr = mFlashMan_BlockAddrWr(uiBlock);
+	uint8_t ucBlank = 1;
+	uint8_t ucReturn = 0;
+
+	if(uiLength > FLASHMAN_BLOCK_SIZE)
+	{
+		ucReturn = FlashMan_FindFrontierDF(ulAddr, FLASHMAN_BLOCK_SIZE, &uiLength);
+	}
+	if((ucReturn == 0) && (uiLength < FLASHMAN_BLOCK_SIZE))
+	{
+		ucReturn = FlashMan_BlankCheckDF(ulAddr + uiLength, (uint16_t)(FLASHMAN_BLOCK_SIZE - uiLength), &ucBlank);
+	}
+	if(ucReturn == 0)
+	{
+		ucReturn = FlashMan_SetModeDF(FLASHMAN_MODE_READ);
+	}
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	ptDigest->uiLength = ucBlank ? uiLength : (uint16_t)FLASHMAN_BLOCK_SIZE;
+	ptDigest->uiCrc = FlashMan_Crc16(FLASHMAN_CRC_INIT, mFlashManHw_ReadPtr(mFlashMan_BlockAddrRd(uiBlock)),
+										ptDigest->uiLength);
+
+	return 0;
+}
+
+
+/**
+* @brief	This function gives the digest of a block: the CRC-16/CCITT and length of its programmed part. It
+*			is kept up to date while the block is programmed and erased, so usually no data flash is read; the
+*			block is only scanned when its digest is not known (after FlashManInit or an out of order write), and a
+*			digest given by FlashMan_ClaimDigest is verified here the first time, with a CRC of its length and a
+*			blank check of the rest of the block.
+* @param	uiBlock, block
+* @param	ptDigest, digest
+* @return	0 if OK, ERR_FLASHE2DATA_CRC if a claimed digest does not match the data flash (ptDigest then has
+*			the actual one), ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_GetDigestDF(uint16_t uiBlock, FlashMan_Digest *ptDigest)
+{
+	FlashMan_BlockDigest *ptBlock;
+	uint16_t uiLength;
+	uint8_t ucReturn;
+
+	if(uiBlock >= FLASHMAN_BLOCK_NUM)
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	ptBlock = &s_atFlashManDigest[uiBlock];
+
+	if(ptBlock->ucState != FLASHMAN_DIGEST_VALID)
+	{
+		//The data flash image is not readable during an operation or a write transaction
+		if(FlashMan_IsBusy() || (s_ucFlashManMode == FLASHMAN_MODE_PE))
+		{
+			return ERR_FLASHE2DATA_BUSY;
+		}
+
+		uiLength = (ptBlock->ucState == FLASHMAN_DIGEST_CLAIMED) ? ptBlock->tDigest.uiLength : FLASHMAN_DIGEST_SEARCH;
+		ucReturn = FlashMan_ScanDigestDF(uiBlock, uiLength, ptDigest);
+		if((ucReturn == 0) && (ptBlock->ucState == FLASHMAN_DIGEST_CLAIMED)
+			&& ((ptDigest->uiCrc != ptBlock->tDigest.uiCrc) || (ptDigest->uiLength != ptBlock->tDigest.uiLength)))
+		{
+			//Wrong claim: the actual digest is searched as if it was not known
+			ptBlock->ucState = FLASHMAN_DIGEST_UNKNOWN;
+			ucReturn = FlashMan_ScanDigestDF(uiBlock, FLASHMAN_DIGEST_SEARCH, ptDigest);
+			if(ucReturn == 0)
+			{
+				ucReturn = ERR_FLASHE2DATA_CRC;
+			}
+		}
+		if((ucReturn == 0) || (ucReturn == ERR_FLASHE2DATA_CRC))
+		{
+			ptBlock->tDigest = *ptDigest;
+			ptBlock->ucState = FLASHMAN_DIGEST_VALID;
+		}
+
+		return ucReturn;
+	}
+
+	*ptDigest = ptBlock->tDigest;
+
+	return 0;
+}
+
+
+/**
+* @brief	This function takes a digest saved by the application, e.g. at the last shutdown, as the digest of a
+*			block without reading the data flash, so startup validation is a comparison of digests. The claim is
+*			verified by the first FlashMan_GetDigestDF of the block, which can be left for an idle time.
+* @param	uiBlock, block
+* @param	ptDigest, saved digest
+* @return	0 if OK, ERR_FLASHE2DATA_OUTRNG
+*/
+uint8_t FlashMan_ClaimDigest(uint16_t uiBlock, const FlashMan_Digest *ptDigest)
+{
+	if((uiBlock >= FLASHMAN_BLOCK_NUM) || (ptDigest->uiLength > FLASHMAN_BLOCK_SIZE))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+
+	s_atFlashManDigest[uiBlock].tDigest = *ptDigest;
+	s_atFlashManDigest[uiBlock].ucState = FLASHMAN_DIGEST_CLAIMED;
+
+	return 0;
+}
+
+
+/**
+* @brief	This function gives the state of the digest of a block, without reading the data flash
+* @param	uiBlock, block
+* @return	FLASHMAN_DIGEST_xxx, FLASHMAN_DIGEST_UNKNOWN if the block is out of range
+*/
+uint8_t FlashMan_GetDigestState(uint16_t uiBlock)
+{
+	if(uiBlock >= FLASHMAN_BLOCK_NUM)
+	{
+		return FLASHMAN_DIGEST_UNKNOWN;
+	}
+
+	return s_atFlashManDigest[uiBlock].ucState;
+}
+#endif
+
+
+#ifdef FLASHMAN_STAGE
+/**
+* @brief	This function serves a read in P/E mode: every byte comes from the write in progress or, if it is not
+*			written by it, from a staged range
+* @param	pucData, the pointer gives data from the staged copies
+* @param	ulAddr, address wherein you want to start reading (E2FLASHADDR_READBASE based, already checked)
+* @param	uiSize, number of bytes
+* @return	0 if OK, ERR_FLASHE2DATA_BUSY if some byte is not staged
+*/
+static uint8_t FlashMan_ReadStagedDF(volatile uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	const FlashMan_StageRange *ptRange;
+	uint16_t uiOffset = (uint16_t)(ulAddr - FLASHMAN_BLOCK_ADDR_RD);
+	uint16_t uiWrite = 0;
+	uint16_t uiWriteSize = 0;
+	uint16_t i;
+	uint8_t r;
+
+	if((s_tFlashManAsync.ucState != FLASHMAN_ST_IDLE) && (s_tFlashManAsync.ucOp == FLASHMAN_OP_WRITE))
+	{
+		uiWrite = (uint16_t)(s_tFlashManAsync.ulAddr - FLASHMAN_BLOCK_ADDR_WR);
+		uiWriteSize = s_tFlashManAsync.uiSize;
+	}
+
+	for(i = 0; i < uiSize; i++, uiOffset++)
+	{
+		if((uint16_t)(uiOffset - uiWrite) < uiWriteSize)
+		{
+			pucData[i] = s_tFlashManAsync.pucData[uiOffset - uiWrite];
+			continue;
+		}
+
+		for(r = 0; r < s_ucFlashManStageRanges; r++)
+		{
+			ptRange = &s_atFlashManStageRange[r];
+			if((uint16_t)(uiOffset - ptRange->uiOffset) < ptRange->uiSize)
+			{
+				pucData[i] = s_aucFlashManStage[ptRange->uiPos + (uint16_t)(uiOffset - ptRange->uiOffset)];
+				break;
+			}
+		}
+		if(r == s_ucFlashManStageRanges)
+		{
+			return ERR_FLASHE2DATA_BUSY;
+		}
+	}
+
+	mFlashMan_StatInc(ulStagedReads);
+
+	return 0;
+}
+
+/**
+* @brief	This function updates the staged copies of the bytes of a program
+* @param	pucData, bytes to program
+* @param	ulAddr, address of the first byte (E2FLASHADDR_WRITEBASE based, already checked)
+* @param	uiSize, number of bytes
+* @return	none
+*/
+static void FlashMan_StageWriteDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	const FlashMan_StageRange *ptRange;
+	uint16_t uiOffset = (uint16_t)(ulAddr - FLASHMAN_BLOCK_ADDR_WR);
+	uint16_t i;
+	uint8_t r;
+
+	for(r = 0; r < s_ucFlashManStageRanges; r++)
+	{
+		ptRange = &s_atFlashManStageRange[r];
+		for(i = 0; i < uiSize; i++)
+		{
+			if((uint16_t)((uiOffset + i) - ptRange->uiOffset) < ptRange->uiSize)
+			{
+				s_aucFlashManStage[ptRange->uiPos + (uint16_t)((uiOffset + i) - ptRange->uiOffset)] = pucData[i];
+			}
+		}
+	}
+}
+
+/**
+* @brief	This function drops the staged ranges that overlap the blocks of an erase
+* @param	ulAddr, first address of the first block (E2FLASHADDR_WRITEBASE based, already checked)
+* @param	uiBlocks, number of blocks
+* @return	none
+*/
+static void FlashMan_StageEraseDF(uint32_t ulAddr, uint16_t uiBlocks)
+{
+	FlashMan_StageRange *ptRange;
+	uint32_t ulStart = ulAddr - FLASHMAN_BLOCK_ADDR_WR;
+	uint32_t ulEnd = ulStart + ((uint32_t)uiBlocks << FLASHMAN_BLOCK_SHIFT);
+	uint8_t r;
+
+	for(r = 0; r < s_ucFlashManStageRanges; r++)
+	{
+		ptRange = &s_atFlashManStageRange[r];
+		if((ptRange->uiOffset < ulEnd) && (((uint32_t)ptRange->uiOffset + ptRange->uiSize) > ulStart))
+		{
+			ptRange->uiSize = 0;
+		}
+	}
+}
+
+/**
+* @brief	This function keeps a RAM copy of a range of the data flash, so FlashMan_ReadDF can still serve it while
+*			the data flash is in P/E mode (asynchronous program/erase or open write transaction) instead of
+*			returning ERR_FLASHE2DATA_BUSY. Programs keep the copy up to date; an erase of its block drops it.
+*			The copy is taken from the data flash, or from the staged data when called in P/E mode.
+* @param	ulAddr, address of the first byte (E2FLASHADDR_READBASE based)
+* @param	uiSize, number of bytes
+* @return	0 if OK, ERR_FLASHE2DATA_NOSTAGE if there is no room left until FlashMan_UnstageDF,
+*			ERR_FLASHE2DATA_xxx otherwise
+*/
+uint8_t FlashMan_StageDF(uint32_t ulAddr, uint16_t uiSize)
+{
+	FlashMan_StageRange *ptRange;
+	uint8_t ucReturn;
+
+	if((uiSize == 0) || !mFlashMan_IsInAreaRd(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	if(	(s_ucFlashManStageRanges >= FLASHMAN_STAGE_RANGES)
+		|| (uiSize > (uint16_t)(FLASHMAN_STAGE_SIZE - s_uiFlashManStageUsed)))
+	{
+		return ERR_FLASHE2DATA_NOSTAGE;
+	}
+
+	ucReturn = FlashMan_ReadDF(&s_aucFlashManStage[s_uiFlashManStageUsed], ulAddr, uiSize);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	ptRange = &s_atFlashManStageRange[s_ucFlashManStageRanges];
+	ptRange->uiOffset = (uint16_t)(ulAddr - FLASHMAN_BLOCK_ADDR_RD);
+	ptRange->uiSize = uiSize;
+	ptRange->uiPos = s_uiFlashManStageUsed;
+	s_uiFlashManStageUsed = (uint16_t)(s_uiFlashManStageUsed + uiSize);
+	s_ucFlashManStageRanges++;
+
+	return 0;
+}
+
+/**
+* @brief	This function drops every staged range
+* @param	none
+* @return	none
+*/
+void FlashMan_UnstageDF(void)
+{
+	s_ucFlashManStageRanges = 0;
+	s_uiFlashManStageUsed = 0;
+}
+#endif
+
+
+#ifdef FLASHMAN_TRACE
+/**
+* @brief	This function records a trace event, overwriting the oldest one when the ring is full. It takes a
+*			timestamp, an index mask and a few stores, with interrupts masked. It can be called from FlashMan_FrdyIsr.
+* @param	ucEvent, FLASHMAN_TR_xxx event
+* @param	ucKind, FLASHMAN_TR_BEGIN, FLASHMAN_TR_END or FLASHMAN_TR_REJECT
+* @param	ulAddr, address of the operation
+* @param	uiArg, size on begin, status otherwise
+* @return	none
+*/
+static void FlashMan_TraceDF(uint8_t ucEvent, uint8_t ucKind, uint32_t ulAddr, uint16_t uiArg)
+{
+	FlashMan_TraceEvent *ptEvent;
+	uint32_t ulPsw;
+
+	//FlashMan_FrdyIsr traces too: the slot is taken and filled with interrupts masked
+	mFlashManHw_IntSave(ulPsw);
+	ptEvent = &s_tFlashManTrace.atEvent[s_tFlashManTrace.ulCount & (FLASHMAN_TRACE_SIZE - 1U)];
+	s_tFlashManTrace.ulCount++;
+	ptEvent->ulTime = mFlashManHw_GetCycles();
+	ptEvent->ulAddr = ulAddr;
+	ptEvent->uiArg = uiArg;
+	ptEvent->ucEvent = ucEvent;
+	ptEvent->ucKind = ucKind;
+	mFlashManHw_IntRestore(ulPsw);
+}
+
+
+/**
+* @brief	This function gives the trace ring, to be dumped as it is (sizeof(FlashMan_Trace) bytes) and converted
+*			on the host by FlashTrace
+* @param	none
+* @return	trace ring
+*/
+const FlashMan_Trace *FlashMan_GetTrace(void)
+{
+	return &s_tFlashManTrace;
+}
+
+
+/**
+* @brief	This function empties the trace ring
+* @param	none
+* @return	none
+*/
+void FlashMan_ClearTrace(void)
+{
+	s_tFlashManTrace.ulCount = 0;
+}
+#endif
+
+
+#ifdef FLASHMAN_USE_FRDYI
+/**
+* @brief	This function is the body of the FRDYI (flash ready) interrupt, to be called from its vector
+* @param	none
+* @return	none
+*/
+void FlashMan_FrdyIsr(void)
+{
+	(void)FlashMan_Poll();
+}
+#endif
@@ -0,0 +1,129 @@
+/**
+* @brief Register access layer of the Flash Manager module. Every access of the driver to the FLASH
+* and SYSTEM registers and to the memory mapped data flash goes through these macros, so the same driver
+* can be built for the target or, with FLASHMAN_HOST defined, against the host sequencer model (FlashSim).
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHMANAGERHW_H__
+#define __FLASHMANAGERHW_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManagerTarget.h"
+#ifdef FLASHMAN_HOST
+#include "FlashSim.h"
+#else
+#include "r_cg_macrodriver.h"
+#endif
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#ifdef FLASHMAN_HOST
+
+#define mFlashManHw_SetDFLEN(x)			FlashSim_RegWrite(FLASHSIM_REG_DFLCTL, (uint16_t)(x))
+#define mFlashManHw_SetFENTRYR(x)		FlashSim_RegWrite(FLASHSIM_REG_FENTRYR, (uint16_t)(x))
+#define mFlashManHw_GetFENTRYR()		FlashSim_RegRead(FLASHSIM_REG_FENTRYR)
+#define mFlashManHw_IsFENTRYD()			((FlashSim_RegRead(FLASHSIM_REG_FENTRYR) & FLASHSIM_FENTRYR_FENTRYD) != 0)
+#define mFlashManHw_SetFPR(x)			FlashSim_RegWrite(FLASHSIM_REG_FPR, (uint16_t)(x))
+#define mFlashManHw_SetFPMCR(x)			FlashSim_RegWrite(FLASHSIM_REG_FPMCR, (uint16_t)(uint8_t)(x))
+#define mFlashManHw_SetPCKA(x)			FlashSim_RegWrite(FLASHSIM_REG_FISR, (uint16_t)(x))
+#define mFlashManHw_SetEXS(x)			FlashSim_RegWrite(FLASHSIM_REG_FASR, (uint16_t)(x))
+#define mFlashManHw_SetFSARH(x)			FlashSim_RegWrite(FLASHSIM_REG_FSARH, (uint16_t)(x))
+#define mFlashManHw_SetFSARL(x)			FlashSim_RegWrite(FLASHSIM_REG_FSARL, (uint16_t)(x))
+#define mFlashManHw_SetFEARH(x)			FlashSim_RegWrite(FLASHSIM_REG_FEARH, (uint16_t)(x))
+#define mFlashManHw_SetFEARL(x)			FlashSim_RegWrite(FLASHSIM_REG_FEARL, (uint16_t)(x))
+#if FLASHMAN_FWB_LAYOUT == FLASHMAN_FWB_FWBHL
+#define mFlashManHw_SetFWB(x)			{ FlashSim_RegWrite(FLASHSIM_REG_FWBH, 0); FlashSim_RegWrite(FLASHSIM_REG_FWBL, (uint16_t)(x)); }
+#else
+#define mFlashManHw_SetFWB(x)			FlashSim_RegWrite(FLASHSIM_REG_FWB0, (uint16_t)(x))
+#endif
+#define mFlashManHw_SetFCR(x)			FlashSim_RegWrite(FLASHSIM_REG_FCR, (uint16_t)(x))
+#define mFlashManHw_IsFRDY()			((FlashSim_RegRead(FLASHSIM_REG_FSTATR1) & FLASHSIM_FSTATR1_FRDY) != 0)
+#define mFlashManHw_IsILGLERR()			((FlashSim_RegRead(FLASHSIM_REG_FSTATR0) & FLASHSIM_FSTATR0_ILGLERR) != 0)
+#define mFlashManHw_IsPRGERR()			((FlashSim_RegRead(FLASHSIM_REG_FSTATR0) & FLASHSIM_FSTATR0_PRGERR) != 0)
+#define mFlashManHw_IsERERR()			((FlashSim_RegRead(FLASHSIM_REG_FSTATR0) & FLASHSIM_FSTATR0_ERERR) != 0)
+#define mFlashManHw_IsBCERR()			((FlashSim_RegRead(FLASHSIM_REG_FSTATR0) & FLASHSIM_FSTATR0_BCERR) != 0)
+#define mFlashManHw_SetFRESETR(x)		FlashSim_RegWrite(FLASHSIM_REG_FRESETR, (uint16_t)(x))
+#define mFlashManHw_SetFRDYIE(x)		FlashSim_RegWrite(FLASHSIM_REG_FRDYIE, (uint16_t)(x))
+#define mFlashManHw_IsHOCOStable()		((FlashSim_RegRead(FLASHSIM_REG_OSCOVFSR) & 0x08) != 0)
+#define mFlashManHw_IsLowSpeedMode()	((FlashSim_RegRead(FLASHSIM_REG_SOPCCR) & 0x01) != 0)
+#define mFlashManHw_Delay(n)			FlashSim_Delay((uint32_t)(n))
+#define mFlashManHw_GetCycles()			((uint32_t)((FlashSim_ReadClock() * (FLASHMAN_ICLK_HZ / 1000000UL)) / 1000U))
+#define mFlashManHw_HasCycles()			1
+#define FLASHMAN_CYCLES_HZ				FLASHMAN_ICLK_HZ
+#define mFlashManHw_ReadPtr(ulAddr)		FlashSim_ReadPtr(ulAddr)
+//Byte by byte: a uint32_t access to a uint8_t buffer breaks the strict aliasing the host compiler optimizes on
+#define mFlashManHw_ReadWord(pucDst, pucSrc)	\
+	{ (pucDst)[0] = (pucSrc)[0]; (pucDst)[1] = (pucSrc)[1]; (pucDst)[2] = (pucSrc)[2]; (pucDst)[3] = (pucSrc)[3]; }
+#define mFlashManHw_Xchg(plVar, plVal)	(*(plVal) = __atomic_exchange_n((plVar), *(plVal), __ATOMIC_SEQ_CST))
+#define mFlashManHw_IntSave(ulPsw)		((ulPsw) = FlashSim_IntSave())
+#define mFlashManHw_IntRestore(ulPsw)	FlashSim_IntRestore(ulPsw)
+//Busy wait on a flag set by FlashMan_FrdyIsr: the model time only runs on its accesses
+#define mFlashManHw_Spin()				FlashSim_Delay(1)
+
+#else
+
+#define mFlashManHw_SetDFLEN(x)			(FLASH.DFLCTL.BIT.DFLEN = (x))
+#define mFlashManHw_SetFENTRYR(x)		(FLASH.FENTRYR.WORD = (x))
+#define mFlashManHw_GetFENTRYR()		(FLASH.FENTRYR.WORD)
+#define mFlashManHw_IsFENTRYD()			(FLASH.FENTRYR.BIT.FENTRYD)
+#define mFlashManHw_SetFPR(x)			(FLASH.FPR = (x))
+#define mFlashManHw_SetFPMCR(x)			(FLASH.FPMCR.BYTE = (x))
+#define mFlashManHw_SetPCKA(x)			(FLASH.FISR.BIT.PCKA = (x))
+#define mFlashManHw_SetEXS(x)			(FLASH.FASR.BIT.EXS = (x))
+#define mFlashManHw_SetFSARH(x)			(FLASH.FSARH = (x))
+#define mFlashManHw_SetFSARL(x)			(FLASH.FSARL = (x))
+#define mFlashManHw_SetFEARH(x)			(FLASH.FEARH = (x))
+#define mFlashManHw_SetFEARL(x)			(FLASH.FEARL = (x))
+#if FLASHMAN_FWB_LAYOUT == FLASHMAN_FWB_FWBHL
+#define mFlashManHw_SetFWB(x)			{ FLASH.FWBH = 0; FLASH.FWBL = (uint16_t)(x); }
+#else
+#define mFlashManHw_SetFWB(x)			(FLASH.FWB0 = (x))
+#endif
+#define mFlashManHw_SetFCR(x)			(FLASH.FCR.BYTE = (x))
+#define mFlashManHw_IsFRDY()			(FLASH.FSTATR1.BIT.FRDY)
+#define mFlashManHw_IsILGLERR()			(FLASH.FSTATR0.BIT.ILGLERR)
+#define mFlashManHw_IsPRGERR()			(FLASH.FSTATR0.BIT.PRGERR)
+#define mFlashManHw_IsERERR()			(FLASH.FSTATR0.BIT.ERERR)
+#define mFlashManHw_IsBCERR()			(FLASH.FSTATR0.BIT.BCERR)
+#define mFlashManHw_SetFRESETR(x)		(FLASH.FRESETR.BYTE = (x))
+#define mFlashManHw_SetFRDYIE(x)		(FLASH.FRDYIE.BIT.FRDYIE = (x))
+#define mFlashManHw_IsHOCOStable()		(SYSTEM.OSCOVFSR.BIT.HCOVF)
+#define mFlashManHw_IsLowSpeedMode()	(SYSTEM.SOPCCR.BIT.SOPCM)
+#define mFlashManHw_Delay(n)			{ volatile uint16_t uiDelay; for(uiDelay=0;uiDelay<(n);uiDelay++){} }
+#define mFlashManHw_ReadPtr(ulAddr)		((const uint8_t *)(ulAddr))
+//One 32-bit read of the data flash and one store, both 4 byte aligned
+#define mFlashManHw_ReadWord(pucDst, pucSrc)	(*(volatile uint32_t *)(pucDst) = *(const uint32_t *)(pucSrc))
+//Atomic exchange of two 32-bit variables (XCHG instruction), *plVal gets the previous value of *plVar
+#define mFlashManHw_Xchg(plVar, plVal)	xchg((signed long *)(plVar), (signed long *)(plVal))
+//Interrupts masked around the updates shared with FlashMan_FrdyIsr: PSW saved in a uint32_t and I flag cleared,
+//then I set again only if it was set, so the pair can be used from the interrupt too
+#define mFlashManHw_IntSave(ulPsw)		{ (ulPsw) = (uint32_t)get_psw(); clrpsw_i(); }
+#define mFlashManHw_IntRestore(ulPsw)	{ if(((ulPsw) & 0x00010000UL) != 0) { setpsw_i(); } }
+//Busy wait on a flag set by FlashMan_FrdyIsr
+#define mFlashManHw_Spin()
+//Free running 32-bit cycle counter for the statistics and the time budget of FlashMan_PollBudget, given by the
+//project (e.g. from a CMT or MTU channel); without it only the counts are kept and no time budget can be given.
+//FLASHMAN_CYCLES_HZ is its frequency when it does not count ICLK cycles; otherwise ICLK is taken, the one set by
+//FlashMan_SetClockDF with FLASHMAN_CLOCK_RUNTIME.
+#ifdef FLASHMAN_GET_CYCLES
+#define mFlashManHw_GetCycles()			((uint32_t)FLASHMAN_GET_CYCLES())
+#define mFlashManHw_HasCycles()			1
+#else
+#define mFlashManHw_GetCycles()			(0UL)
+#define mFlashManHw_HasCycles()			0
+#endif
+//CRC calculator for the block digests (FLASHMAN_USE_CRC_UNIT): CRC-CCITT, MSB first, seeded through CRCDOR. The
+//module must be out of module stop and not used by anything that can preempt the driver.
+#define mFlashManHw_CrcStart(uiCrc)		(CRC.CRCCR.BYTE = 0x07, CRC.CRCDOR = (uint16_t)(uiCrc))
+#define mFlashManHw_CrcByte(ucData)		(CRC.CRCDIR = (uint8_t)(ucData))
+#define mFlashManHw_CrcResult()			((uint16_t)CRC.CRCDOR)
+
+#endif
+
+
+#endif // __FLASHMANAGERHW_H__
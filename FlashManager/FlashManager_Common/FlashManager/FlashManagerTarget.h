@@ -0,0 +1,80 @@
+/**
+* @brief Compile-time traits of the devices supported by the Flash Manager module. The device is selected with
+* FLASHMAN_TARGET_RX140 (eSTB, default) or FLASHMAN_TARGET_RX130 (Gaya); the addresses, geometry, program unit,
+* write buffer layout, erase command range and clocks of its data flash come from here, so the single FlashManager.c
+* of FlashManager_Common serves both boards.
+* Block size and addresses are powers of two / block aligned, so address to block translation and range checks
+* reduce to constant shifts, masks and one unsigned compare.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHMANAGERTARGET_H__
+#define __FLASHMANAGERTARGET_H__
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Write buffer layouts
+#define FLASHMAN_FWB_FWB0		0	//8-bit FWB0
+#define FLASHMAN_FWB_FWBHL		1	//16-bit FWBH:FWBL pair, the data flash byte goes to FWBL
+
+#if defined(FLASHMAN_TARGET_RX130) && defined(FLASHMAN_TARGET_RX140)
+#error "Only one FLASHMAN_TARGET_xxx can be defined"
+#elif !defined(FLASHMAN_TARGET_RX130) && !defined(FLASHMAN_TARGET_RX140)
+#define FLASHMAN_TARGET_RX140
+#endif
+
+#if defined(FLASHMAN_TARGET_RX130)
+#define FLASHMAN_TARGET_NAME		"RX130"
+#define FLASHMAN_BLOCK_ADDR_RD		0x00100000UL	//Data flash in read mode
+#define FLASHMAN_BLOCK_ADDR_WR		0x000F1000UL	//Data flash for FSAR/FEAR in P/E mode
+#define FLASHMAN_BLOCK_SHIFT		10				//1 KB blocks
+#define FLASHMAN_BLOCK_NUM			8
+#define FLASHMAN_PROGRAM_UNIT		1				//Bytes per program command
+#define FLASHMAN_FWB_LAYOUT			FLASHMAN_FWB_FWBHL
+#define FLASHMAN_ERASE_RANGE		1				//Erase command takes a FSAR .. FEAR range of blocks
+#define FLASHMAN_TARGET_ICLK_HZ		32000000UL
+#define FLASHMAN_TARGET_FCLK_HZ		32000000UL
+#define FLASHMAN_FCLK_MIN_HZ		1000000UL		//FCLK range for programming and erasing
+#define FLASHMAN_FCLK_MAX_HZ		32000000UL
+#define FLASHMAN_TDSTOP_NS			250				//DFLEN = 1 to data flash access
+#define FLASHMAN_TMS_NS				2000			//FPMCR set to read mode to FENTRYR clear
+#define FLASHMAN_PE_CYCLES			100000UL		//Guaranteed program/erase cycles of a data flash block
+#else
+#define FLASHMAN_TARGET_NAME		"RX140"
+#define FLASHMAN_BLOCK_ADDR_RD		0x00100000UL
+#define FLASHMAN_BLOCK_ADDR_WR		0xFE000000UL
+#define FLASHMAN_BLOCK_SHIFT		10
+#define FLASHMAN_BLOCK_NUM			8
+#define FLASHMAN_PROGRAM_UNIT		1
+#define FLASHMAN_FWB_LAYOUT			FLASHMAN_FWB_FWB0
+#define FLASHMAN_ERASE_RANGE		1
+#define FLASHMAN_TARGET_ICLK_HZ		48000000UL
+#define FLASHMAN_TARGET_FCLK_HZ		32000000UL
+#define FLASHMAN_FCLK_MIN_HZ		1000000UL
+#define FLASHMAN_FCLK_MAX_HZ		32000000UL
+#define FLASHMAN_TDSTOP_NS			250
+#define FLASHMAN_TMS_NS				2000
+#define FLASHMAN_PE_CYCLES			100000UL
+#endif
+
+//Geometry
+#define FLASHMAN_BLOCK_SIZE			( 1U << FLASHMAN_BLOCK_SHIFT )
+#define FLASHMAN_BLOCK_MASK			( FLASHMAN_BLOCK_SIZE - 1U )
+#define FLASHMAN_AREA_SIZE			( FLASHMAN_BLOCK_SIZE * FLASHMAN_BLOCK_NUM )
+
+//Block index of a P/E address, and first address of its block; the address must be inside of the data flash
+#define mFlashMan_BlockOfWr(ulAddr)		( (uint16_t)(((uint32_t)(ulAddr) - FLASHMAN_BLOCK_ADDR_WR) >> FLASHMAN_BLOCK_SHIFT) )
+#define mFlashMan_BlockBase(ulAddr)		( (uint32_t)(ulAddr) & ~(uint32_t)FLASHMAN_BLOCK_MASK )
+#define mFlashMan_BlockAddrRd(uiBlock)	( FLASHMAN_BLOCK_ADDR_RD + ((uint32_t)(uiBlock) << FLASHMAN_BLOCK_SHIFT) )
+#define mFlashMan_BlockAddrWr(uiBlock)	( FLASHMAN_BLOCK_ADDR_WR + ((uint32_t)(uiBlock) << FLASHMAN_BLOCK_SHIFT) )
+
+//1 if [ulAddr, ulAddr + uiSize) lies inside of the data flash mapped at ulBase (addresses below ulBase wrap around)
+#define mFlashMan_IsInArea(ulBase, ulAddr, uiSize)	\
+	( (((uint32_t)(ulAddr) - (ulBase)) < FLASHMAN_AREA_SIZE)	\
+	&& ((((uint32_t)(ulAddr) - (ulBase)) + (uint32_t)(uiSize)) <= FLASHMAN_AREA_SIZE) )
+#define mFlashMan_IsInAreaRd(ulAddr, uiSize)	mFlashMan_IsInArea(FLASHMAN_BLOCK_ADDR_RD, ulAddr, uiSize)
+#define mFlashMan_IsInAreaWr(ulAddr, uiSize)	mFlashMan_IsInArea(FLASHMAN_BLOCK_ADDR_WR, ulAddr, uiSize)
+
+
+#endif // __FLASHMANAGERTARGET_H__
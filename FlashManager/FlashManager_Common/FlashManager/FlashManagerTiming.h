@@ -0,0 +1,45 @@
+/**
+* @brief Timing of the Flash Manager module. The software waits of the data flash mode transitions and the
+* FISR.PCKA value are derived from the clock configuration instead of being fixed loop counts: at compile time from
+* FLASHMAN_ICLK_HZ / FLASHMAN_FCLK_HZ, or at run time through FlashMan_SetClockDF when FLASHMAN_CLOCK_RUNTIME is
+* defined (clock switched by the application).
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHMANAGERTIMING_H__
+#define __FLASHMANAGERTIMING_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManagerTarget.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Clock configuration, to be set from the project clock settings
+#ifndef FLASHMAN_ICLK_HZ
+#define FLASHMAN_ICLK_HZ			FLASHMAN_TARGET_ICLK_HZ
+#endif
+#ifndef FLASHMAN_FCLK_HZ
+#define FLASHMAN_FCLK_HZ			FLASHMAN_TARGET_FCLK_HZ
+#endif
+
+//CPU cycles per iteration of mFlashManHw_Delay, depends on the compiler and its options
+#ifndef FLASHMAN_DELAY_LOOP_CYCLES
+#define FLASHMAN_DELAY_LOOP_CYCLES	4
+#endif
+
+//Delay loop iterations for ulNs at ulIclkHz, rounded up. The product of ns and kHz takes 64 bits (32 bits only
+//reach 42 us at 100 MHz); the result must fit in 16 bits, i.e. 2.6 ms at 100 MHz, see mFlashManTiming_LoopsWide.
+#define mFlashManTiming_LoopsWide(ulNs, ulIclkHz)	\
+	((((uint64_t)(ulNs) * ((ulIclkHz) / 1000UL)) + ((FLASHMAN_DELAY_LOOP_CYCLES * 1000000UL) - 1UL))	\
+		/ (FLASHMAN_DELAY_LOOP_CYCLES * 1000000UL))
+#define mFlashManTiming_Loops(ulNs, ulIclkHz)	((uint16_t)mFlashManTiming_LoopsWide(ulNs, ulIclkHz))
+
+//FISR.PCKA: FCLK in MHz rounded up, minus one
+#define mFlashManTiming_Pcka(ulFclkHz)	((uint8_t)((((ulFclkHz) + 999999UL) / 1000000UL) - 1UL))
+
+
+#endif // __FLASHMANAGERTIMING_H__
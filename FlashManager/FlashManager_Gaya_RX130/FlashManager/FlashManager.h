@@ -6,6 +6,18 @@
 * and handle it just like an E2PROM. -Orders for writing operations come from Memory Driver module
 * and- the ones for reading operations comes from Memory Driver module, Variant Decoder module and
 * Variant Table module.
+*
+* Gaya (RX130) build of the common driver: FlashManager_Common/FlashManager/FlashManager.c is compiled directly with
+* this folder in the include path, the RX130 traits are selected here and the API comes from the FlashManager.h of
+* FlashManager_eSTB (geometry in FlashManager_Common/FlashManager/FlashManagerTarget.h).
+*
+* Migration from the former Gaya driver:
+* - FlashMan_ReadDF, FlashMan_WriteDF and FlashMan_BlockEraseDF returned void and now return uint8_t: 0 if done,
+*   otherwise ERR_FLASHE2DATA_xxx (e.g. ERR_FLASHE2DATA_OUTRNG for a range outside the data flash,
+*   ERR_FLASHE2DATA_BUSY while a program/erase is running) or FLASHMAN_STATUS_ERROR. Every caller has to check it:
+*   a refused write or erase leaves the data flash unchanged. FlashManInit is still void.
+* - Reads go through the read mapping at FLASHMAN_BLOCK_ADDR_RD = 0x00100000 instead of 0x05500000; callers using
+*   FLASHMAN_BLOCK_x_RD only need a rebuild, hard coded read addresses must be moved.
 * 
 * @date 07/09/2018
 * @version 0.0.1
@@ -14,65 +26,25 @@
 * The above copyright refers to the E.G.O. group development centers.
 */
 
-#ifndef __FLASHMANAGER_H__
-#define __FLASHMANAGER_H__
-
-
-/***************************************************************************************************
-* Includes
-***************************************************************************************************/
-
-#include "../../../types.h"
+#ifndef __FLASHMANAGER_GAYA_H__
+#define __FLASHMANAGER_GAYA_H__
 
 
 /***************************************************************************************************
 * Defines
 ***************************************************************************************************/
-#define T_DSTOP  30
-#define T_MS  300
-
-
-//info about all area
-#define FLASHMAN_BLOCK_SIZE	0x400
-#define FLASHMAN_BLOCK_NUM	8
-
-//addresses of each block (read mode)
-#define FLASHMAN_BLOCK_ADDR_RD	0x05500000
-#define	FLASHMAN_BLOCK_0_RD		( FLASHMAN_BLOCK_ADDR_RD )
-#define	FLASHMAN_BLOCK_1_RD		( FLASHMAN_BLOCK_0_RD + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_2_RD		( FLASHMAN_BLOCK_1_RD + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_3_RD		( FLASHMAN_BLOCK_2_RD + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_4_RD		( FLASHMAN_BLOCK_3_RD + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_5_RD		( FLASHMAN_BLOCK_4_RD + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_6_RD		( FLASHMAN_BLOCK_5_RD + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_7_RD		( FLASHMAN_BLOCK_6_RD + FLASHMAN_BLOCK_SIZE )
-
-//addresses of each block (write mode)
-#define FLASHMAN_BLOCK_ADDR_WR	0xF1000
-#define	FLASHMAN_BLOCK_0_WR		( FLASHMAN_BLOCK_ADDR_WR )
-#define	FLASHMAN_BLOCK_1_WR		( FLASHMAN_BLOCK_0_WR + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_2_WR		( FLASHMAN_BLOCK_1_WR + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_3_WR		( FLASHMAN_BLOCK_2_WR + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_4_WR		( FLASHMAN_BLOCK_3_WR + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_5_WR		( FLASHMAN_BLOCK_4_WR + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_6_WR		( FLASHMAN_BLOCK_5_WR + FLASHMAN_BLOCK_SIZE )
-#define	FLASHMAN_BLOCK_7_WR		( FLASHMAN_BLOCK_6_WR + FLASHMAN_BLOCK_SIZE )
-
-
-
-
 
+#ifndef FLASHMAN_TARGET_RX130
+#define FLASHMAN_TARGET_RX130
+#endif
 
 
 /***************************************************************************************************
-* Declarations of Public Functions
+* Includes
 ***************************************************************************************************/
 
-void FlashManInit(void);
-void FlashMan_ReadDF(volatile u8 *pucData, u32 ulAddr, u16 uiSize);
-void FlashMan_WriteDF(const u8 *pucData, u32 ulAddr, u16 uiSize);
-void FlashMan_BlockEraseDF(u32 ulAddr);
+#include "../../FlashManager_eSTB/FlashManager/FlashManager.h"
 
 
 
-#endif // __FLASHMANAGER_H__
+#endif // __FLASHMANAGER_GAYA_H__
@@ -0,0 +1,2631 @@
+/**
+* @brief Throughput benchmark of the Flash Manager module on the host FLASH sequencer model. It runs the
+* public FlashMan_* functions of the driver built for one target against FlashSim and reports, from the virtual clock of
+* the model, bytes/s for writes, blocks/s for erases and the time each call spends outside sequencer
+* commands (mode transitions, delays and register setup), plus the illegal sequences the model detected.
+*
+* Build from the project root, e.g. for the eSTB (RX140) driver:
+*	cc -DFLASHMAN_HOST -IDrivers/FlashManager/FlashManager_Host -IDrivers/FlashManager/FlashManager_eSTB/FlashManager
+*	   Drivers/FlashManager/FlashManager_Host/FlashSim.c Drivers/FlashManager/FlashManager_Host/FlashBench.c
+*	   Drivers/FlashManager/FlashManager_Common/FlashManager/FlashManager.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashEeprom.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashBlock.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashCache.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashQueue.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashCodec.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashCounter.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashJournal.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashTable.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashSum.c
+*	   Drivers/FlashManager/FlashManager_Host/FlashTableGen.c -DFLASHTBLGEN_NO_MAIN -o flashbench
+* and for the Gaya (RX130) target add -DFLASHMAN_TARGET_RX130 and put
+* -IDrivers/FlashManager/FlashManager_Gaya_RX130/FlashManager in front of the eSTB include path (same sources, see
+* FlashManagerTarget.h).
+* With -DFLASHMAN_TRACE (and e.g. -DFLASHMAN_TRACE_SIZE=4096) the trace ring is saved to flashbench.trace at the end,
+* to be converted by FlashTrace.
+* With -DFLASHMAN_STAGE the reads served from the staging buffer during a program/erase are measured too.
+* With -DFLASHEEP_CODEC the EEPROM stores its values packed.
+* With -DFLASHMAN_USE_FRDYI the model calls FlashMan_FrdyIsr when FRDY rises, FlashMan_Poll is never called, and an
+* interrupt driven write is checked against a foreground that traces a reject at every model access.
+* The power cut test (FlashSim_SetPowerCut) reports the distribution of the EEPROM recovery time at startup.
+* The parameter image saved raw and packed is a built-in sample unless a captured image is given:
+*	flashbench [image.bin]
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+//clock_gettime for FlashBench_HostNs, also with -std=c99
+#define _POSIX_C_SOURCE	199309L
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FlashSim.h"
+#include "FlashManager.h"
+#include "FlashEeprom.h"
+#include "FlashBlock.h"
+#include "FlashCache.h"
+#include "FlashQueue.h"
+#include "FlashCodec.h"
+#include "FlashCounter.h"
+#include "FlashJournal.h"
+#include "FlashTable.h"
+#include "FlashTableGen.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#ifdef FLASHMAN_TARGET_RX130
+#define FLASHBENCH_DEVICE	(&g_tFlashSim_RX130)
+#else
+#define FLASHBENCH_DEVICE	(&g_tFlashSim_RX140)
+#endif
+
+#define FLASHBENCH_AREA		((uint32_t)FLASHBENCH_DEVICE->uiBlockSize * FLASHBENCH_DEVICE->ucBlockNum)
+
+#define FLASHBENCH_EEP_DATA	8		//Bytes per EEPROM value
+
+//Power cuts of FlashBench_PowerCut
+#define FLASHBENCH_CUTS			2000
+#define FLASHBENCH_CUT_CMDS		1000	//A cut lands in one of the next FLASHBENCH_CUT_CMDS sequencer commands
+#define FLASHBENCH_CUT_MISMATCH	0xFF	//Key holding neither its last value nor the one being written
+
+//Parameter image saved by FlashBench_Codec, in records of FLASHBENCH_IMG_REC bytes
+#define FLASHBENCH_IMG_SIZE	1024	//Built-in sample
+#define FLASHBENCH_IMG_MAX	( FLASHBENCH_AREA / 2 )
+#define FLASHBENCH_IMG_REC	32
+#define FLASHBENCH_IMG_PACKED	0x80	//Record length flag
+
+#define FLASHBENCH_TBL_VALUE	8		//Bytes per variant table value
+#define FLASHBENCH_TBL_KEY(i)	( 0x00A00000UL + ((uint32_t)(i) * 0x0101U) )	//Variant codes, all odd
+#define FLASHBENCH_TBL_ROUNDS	50		//Lookups in place take no model time, they are timed on the host
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+typedef struct
+{
+	uint64_t ullStartNs;
+	FlashSim_Stats tStart;
+} FlashBench_Run;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static uint8_t s_aucPattern[FLASHSIM_MAX_SIZE];
+static volatile uint8_t s_aucReadBuf[FLASHSIM_MAX_SIZE];
+static uint32_t s_ulErrors;
+#ifdef __FLASHCODEC_H__
+static uint8_t s_aucImage[FLASHSIM_MAX_SIZE / 2];
+#endif
+#ifdef __FLASHEEPROM_H__
+static jmp_buf s_tCutJump;				//Back to FlashBench_CutUpdates at a power cut
+static uint8_t s_aucCutShadow[FLASHEEP_MAX_KEYS][FLASHBENCH_EEP_DATA];
+static uint8_t s_aucCutValue[FLASHBENCH_EEP_DATA];	//Value being written at the cut
+static uint16_t s_uiCutKey;							//Key being written at the cut
+static uint32_t s_ulCutSeed;
+#endif
+#ifdef __FLASHCACHE_H__
+static jmp_buf s_tCacheCutJump;						//Back to FlashBench_CacheCutFlushes at a power cut
+static uint8_t s_aucCacheShadow[FLASHCACHE_SIZE];	//Mirror written back
+static uint8_t s_aucCacheValue[FLASHCACHE_SIZE];	//Mirror being written back at the cut
+static uint32_t s_ulCacheSeed;
+#endif
+#ifdef FLASHMAN_USE_FRDYI
+static uint64_t s_ullIsrMaxNs;		//Longest FlashMan_FrdyIsr call
+#else
+static uint64_t s_ullHookNs;		//Last step hook call, or start of the FlashMan_PollBudget call
+static uint64_t s_ullHookGapNs;		//Longest time without a step hook call
+static uint32_t s_ulHookCalls;
+#endif
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static void FlashBench_Start(FlashBench_Run *ptRun);
+static void FlashBench_Report(const FlashBench_Run *ptRun, const char *pcName, uint32_t ulSize, uint32_t ulCalls,
+								uint32_t ulUnits, const char *pcUnit);
+static uint64_t FlashBench_HostNs(void);
+static void FlashBench_ReportHost(const char *pcName, uint32_t ulSize, uint32_t ulCalls, uint64_t ullNs,
+									const char *pcUnit);
+static void FlashBench_EraseAll(void);
+static void FlashBench_Erase(uint8_t ucBlank);
+static void FlashBench_EraseRange(uint32_t ulWritten, const char *pcName);
+static void FlashBench_Write(uint16_t uiSize);
+static void FlashBench_Read(uint16_t uiSize);
+static void FlashBench_Check(void);
+#ifdef FLASHMAN_TRANS_NO_FAIL
+static void FlashBench_Transaction(uint16_t uiRecords, uint16_t uiSize);
+#endif
+#ifdef FLASHMAN_ASYNC_BUSY
+static void FlashBench_Async(uint16_t uiSize);
+#endif
+#ifdef FLASHMAN_USE_FRDYI
+static void FlashBench_FrdyIsr(void);
+static void FlashBench_Interrupt(uint16_t uiSize);
+#else
+static void FlashBench_StepHook(void);
+static void FlashBench_Budget(uint16_t uiSize, uint32_t ulMaxUs, uint16_t uiMaxSteps);
+#endif
+static void FlashBench_View(void);
+static void FlashBench_Frontier(uint16_t uiWritten);
+#ifdef FLASHMAN_DIFF_MAX_SIZE
+static void FlashBench_Diff(void);
+#endif
+#ifdef FLASHMAN_CRC
+static void FlashBench_Digest(uint16_t uiRecords, uint16_t uiSize);
+#endif
+#ifdef FLASHMAN_STAGE
+static void FlashBench_Stage(void);
+#endif
+#ifdef __FLASHEEPROM_H__
+static void FlashBench_Eeprom(uint16_t uiUpdates);
+static void FlashBench_EndOfLineDirty(void);
+static void FlashBench_EndOfLine(uint16_t uiKeys);
+static void FlashBench_ErasedValue(uint8_t ucErased, uint16_t uiUpdates);
+#endif
+#ifdef __FLASHCACHE_H__
+static void FlashBench_Cache(uint16_t uiUpdates);
+static void FlashBench_CacheCutHook(void);
+static void FlashBench_CacheCutFlushes(uint16_t uiCut);
+static void FlashBench_CacheCut(uint16_t uiCuts);
+#endif
+#ifdef __FLASHQUEUE_H__
+static void FlashBench_Queue(uint16_t uiBursts);
+#endif
+#ifdef __FLASHCOUNTER_H__
+static void FlashBench_Counter(uint16_t uiIncrements);
+#endif
+#ifdef __FLASHJOURNAL_H__
+static void FlashBench_Journal(uint16_t uiEntries);
+#endif
+#ifdef __FLASHBLOCK_H__
+static void FlashBench_Wear(uint16_t uiRewrites, uint8_t ucAlloc);
+#endif
+#ifdef __FLASHTABLE_H__
+static void FlashBench_Table(uint16_t uiCount, uint8_t ucKind);
+#endif
+#ifdef __FLASHCODEC_H__
+static uint16_t FlashBench_Image(const char *pcFile);
+static void FlashBench_Codec(uint16_t uiSize, uint8_t ucPack);
+#endif
+#ifndef FLASHMAN_NO_STATS
+static void FlashBench_Stats(void);
+#endif
+#ifdef __FLASHEEPROM_H__
+static void FlashBench_CutHook(void);
+static void FlashBench_CutUpdates(uint16_t uiCut);
+static int FlashBench_CompareUs(const void *pvA, const void *pvB);
+static void FlashBench_PowerCut(uint16_t uiCuts);
+#endif
+#ifdef FLASHMAN_TRACE
+static void FlashBench_Trace(const char *pcFile);
+#endif
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function takes a snapshot of the model counters before a run
+* @param	ptRun, snapshot
+* @return	none
+*/
+static void FlashBench_Start(FlashBench_Run *ptRun)
+{
+	ptRun->tStart = *FlashSim_GetStats();
+	ptRun->ullStartNs = FlashSim_Now();
+}
+
+/**
+* @brief	This function prints one line of results
+* @param	ptRun, snapshot taken before the run
+* @param	pcName, operation
+* @param	ulSize, bytes per call
+* @param	ulCalls, number of calls
+* @param	ulUnits, bytes or blocks processed, used for the throughput
+* @param	pcUnit, unit of the throughput
+* @return	none
+*/
+static void FlashBench_Report(const FlashBench_Run *ptRun, const char *pcName, uint32_t ulSize, uint32_t ulCalls,
+								uint32_t ulUnits, const char *pcUnit)
+{
+	const FlashSim_Stats *ptNow = FlashSim_GetStats();
+	double dElapsedNs = (double)(FlashSim_Now() - ptRun->ullStartNs);
+	double dBusyNs = (double)(ptNow->ullBusyNs - ptRun->tStart.ullBusyNs);
+	uint32_t ulModes = (ptNow->ulToPEMode - ptRun->tStart.ulToPEMode) + (ptNow->ulToReadMode - ptRun->tStart.ulToReadMode);
+	uint32_t ulIllegal = ptNow->ulIllegalCmds - ptRun->tStart.ulIllegalCmds;
+	uint32_t ulViolations = (ptNow->ulProtectErrors - ptRun->tStart.ulProtectErrors)
+							+ (ptNow->ulReadViolations - ptRun->tStart.ulReadViolations)
+							+ (ptNow->ulTimingViolations - ptRun->tStart.ulTimingViolations)
+							+ (ptNow->ulOverwrites - ptRun->tStart.ulOverwrites);
+
+	printf("%-14s %6lu %6lu %12.1f %-8s %10.2f %12.2f %8.2f %10.1f %8lu %8lu\n",
+			pcName, (unsigned long)ulSize, (unsigned long)ulCalls,
+			(dElapsedNs > 0) ? ((double)ulUnits * 1e9 / dElapsedNs) : 0.0, pcUnit,	//0: no flash access at all
+			dElapsedNs / 1e3 / ulCalls,
+			(dElapsedNs - dBusyNs) / 1e3 / ulCalls,
+			(double)ulModes / ulCalls,
+			(double)(ptNow->ulFrdyPolls - ptRun->tStart.ulFrdyPolls) / ulCalls,
+			(unsigned long)ulIllegal, (unsigned long)ulViolations);
+
+	s_ulErrors += ulIllegal + ulViolations;
+}
+
+/**
+* @brief	This function gives the host time, for the runs that only read the memory mapped data flash: the model
+*			time does not advance for them
+* @param	none
+* @return	host time in ns
+*/
+static uint64_t FlashBench_HostNs(void)
+{
+	struct timespec tNow;
+
+	(void)clock_gettime(CLOCK_MONOTONIC, &tNow);
+
+	return ((uint64_t)tNow.tv_sec * 1000000000ULL) + (uint64_t)tNow.tv_nsec;
+}
+
+/**
+* @brief	This function prints one line of results timed on the host, see FlashBench_HostNs. Only the relation
+*			between such lines is meaningful, not the time itself on the target.
+* @param	pcName, operation
+* @param	ulSize, bytes per call
+* @param	ulCalls, number of calls
+* @param	ullNs, host time of all the calls
+* @param	pcUnit, unit of the throughput, calls per second
+* @return	none
+*/
+static void FlashBench_ReportHost(const char *pcName, uint32_t ulSize, uint32_t ulCalls, uint64_t ullNs,
+									const char *pcUnit)
+{
+	double dNs = (ullNs > 0) ? (double)ullNs : 1.0;
+
+	printf("%-14s %6lu %6lu %12.1f %-8s %10.4f %12s host time\n", pcName, (unsigned long)ulSize,
+			(unsigned long)ulCalls, (double)ulCalls * 1e9 / dNs, pcUnit, dNs / 1e3 / ulCalls, "");
+}
+
+/**
+* @brief	This function erases the whole data flash and checks that every cell is blank afterwards
+* @param	none
+* @return	none
+*/
+static void FlashBench_EraseAll(void)
+{
+	uint32_t ulOffset;
+
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset += FLASHBENCH_DEVICE->uiBlockSize)
+	{
+		FlashMan_BlockEraseDF(FLASHBENCH_DEVICE->ulWriteBase + ulOffset);
+	}
+
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset++)
+	{
+		if(!FlashSim_IsBlank(ulOffset))
+		{
+			printf("  erase failed at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+}
+
+/**
+* @brief	This function measures the erase of the whole data flash
+* @param	ucBlank, 0 to write one byte in every block first, 1 to erase blocks already blank
+* @return	none
+*/
+static void FlashBench_Erase(uint8_t ucBlank)
+{
+	FlashBench_Run tRun;
+	uint32_t ulOffset;
+
+	for(ulOffset = 0; (ulOffset < FLASHBENCH_AREA) && !ucBlank; ulOffset += FLASHBENCH_DEVICE->uiBlockSize)
+	{
+		(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase + ulOffset, 1);
+	}
+
+	FlashBench_Start(&tRun);
+	FlashBench_EraseAll();
+	FlashBench_Report(&tRun, ucBlank ? "erase blank" : "erase", FLASHBENCH_DEVICE->uiBlockSize,
+						FLASHBENCH_DEVICE->ucBlockNum, FLASHBENCH_DEVICE->ucBlockNum, "blocks/s");
+}
+
+/**
+* @brief	This function measures the erase of the whole data flash with a single FlashMan_EraseBlocksDF call and
+*			checks that every cell is blank afterwards
+* @param	ulWritten, blocks to write one byte in first, bit n for block n
+* @param	pcName, row name
+* @return	none
+*/
+static void FlashBench_EraseRange(uint32_t ulWritten, const char *pcName)
+{
+	FlashBench_Run tRun;
+	uint32_t ulFailed = 0xFFFFFFFFUL;
+	uint32_t ulOffset;
+	uint8_t ucReturn;
+
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset += FLASHBENCH_DEVICE->uiBlockSize)
+	{
+		if(ulWritten & (1UL << (ulOffset / FLASHBENCH_DEVICE->uiBlockSize)))
+		{
+			(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase + ulOffset, 1);
+		}
+	}
+
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_EraseBlocksDF(FLASHBENCH_DEVICE->ulWriteBase, FLASHBENCH_DEVICE->ucBlockNum, &ulFailed);
+	FlashBench_Report(&tRun, pcName, FLASHBENCH_AREA, 1, FLASHBENCH_DEVICE->ucBlockNum, "blocks/s");
+
+	if((ucReturn != 0) || (ulFailed != 0))
+	{
+		printf("  range erase returned %u, failed blocks 0x%08lX\n", (unsigned)ucReturn, (unsigned long)ulFailed);
+		s_ulErrors++;
+	}
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset++)
+	{
+		if(!FlashSim_IsBlank(ulOffset))
+		{
+			printf("  range erase failed at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+}
+
+/**
+* @brief	This function measures writes of uiSize bytes over the whole (erased) data flash and checks the
+*			programmed data
+* @param	uiSize, bytes per call
+* @return	none
+*/
+static void FlashBench_Write(uint16_t uiSize)
+{
+	FlashBench_Run tRun;
+	uint32_t ulOffset;
+	uint32_t ulCalls = 0;
+
+	FlashBench_EraseAll();
+
+	FlashBench_Start(&tRun);
+	for(ulOffset = 0; (ulOffset + uiSize) <= FLASHBENCH_AREA; ulOffset += uiSize)
+	{
+		FlashMan_WriteDF(&s_aucPattern[ulOffset], FLASHBENCH_DEVICE->ulWriteBase + ulOffset, uiSize);
+		ulCalls++;
+	}
+	FlashBench_Report(&tRun, "write", uiSize, ulCalls, ulCalls * uiSize, "bytes/s");
+
+	FlashBench_Check();
+}
+
+/**
+* @brief	This function measures reads of uiSize bytes over the whole data flash
+* @param	uiSize, bytes per call
+* @return	none
+*/
+static void FlashBench_Read(uint16_t uiSize)
+{
+	FlashBench_Run tRun;
+	uint32_t ulOffset;
+	uint32_t ulCalls = 0;
+
+	FlashBench_Start(&tRun);
+	for(ulOffset = 0; (ulOffset + uiSize) <= FLASHBENCH_AREA; ulOffset += uiSize)
+	{
+		FlashMan_ReadDF(&s_aucReadBuf[ulOffset], FLASHBENCH_DEVICE->ulReadBase + ulOffset, uiSize);
+		ulCalls++;
+	}
+	FlashBench_Report(&tRun, "read", uiSize, ulCalls, ulCalls * uiSize, "bytes/s");
+
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset++)
+	{
+		if(s_aucReadBuf[ulOffset] != s_aucPattern[ulOffset])
+		{
+			printf("  read mismatch at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+}
+
+/**
+* @brief	This function checks the array of the model against the written pattern
+* @param	none
+* @return	none
+*/
+static void FlashBench_Check(void)
+{
+	uint32_t ulOffset;
+
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset++)
+	{
+		if(FlashSim_Peek(ulOffset) != s_aucPattern[ulOffset])
+		{
+			printf("  data mismatch at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+}
+
+#ifdef FLASHMAN_TRANS_NO_FAIL
+/**
+* @brief	This function measures a parameter set save done as one write transaction, records scattered over
+*			the whole data flash
+* @param	uiRecords, number of records
+* @param	uiSize, bytes per record
+* @return	none
+*/
+static void FlashBench_Transaction(uint16_t uiRecords, uint16_t uiSize)
+{
+	FlashBench_Run tRun;
+	FlashMan_WriteTrans tTrans;
+	FlashMan_View tView;
+	uint32_t ulStride = FLASHBENCH_AREA / uiRecords;
+	uint32_t ulOffset;
+	uint16_t i;
+
+	FlashBench_EraseAll();
+
+	FlashBench_Start(&tRun);
+	(void)FlashMan_WriteBegin(&tTrans);
+	for(i = 0; i < uiRecords; i++)
+	{
+		ulOffset = i * ulStride;
+		(void)FlashMan_WriteAppend(&tTrans, &s_aucPattern[ulOffset], FLASHBENCH_DEVICE->ulWriteBase + ulOffset, uiSize);
+
+		//No memory mapped access while the transaction is open: it would leave P/E mode under the next append
+		if(i == 0)
+		{
+#ifndef FLASHMAN_STAGE
+			if(FlashMan_ReadDF(s_aucReadBuf, FLASHBENCH_DEVICE->ulReadBase, uiSize) != ERR_FLASHE2DATA_BUSY)
+			{
+				printf("  read inside of a transaction not rejected\n");
+				s_ulErrors++;
+			}
+#endif
+			if(FlashMan_GetViewDF(FLASHBENCH_DEVICE->ulReadBase, uiSize, &tView) != ERR_FLASHE2DATA_BUSY)
+			{
+				printf("  view inside of a transaction not rejected\n");
+				s_ulErrors++;
+			}
+		}
+	}
+	if(FlashMan_WriteCommit(&tTrans) != FLASHMAN_STATUS_OK)
+	{
+		printf("  transaction failed at append %u\n", (unsigned)tTrans.uiFailedAppend);
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "transaction", uiSize, uiRecords, (uint32_t)uiRecords * uiSize, "bytes/s");
+}
+#endif
+
+#ifdef FLASHMAN_ASYNC_BUSY
+/**
+* @brief	This function measures the asynchronous engine driven from a 100 us scheduler tick: one block erase,
+*			or one write of uiSize bytes, and the longest time a single FlashMan_Poll call holds the CPU
+* @param	uiSize, bytes to write, 0 for a block erase
+* @return	none
+*/
+static void FlashBench_Async(uint16_t uiSize)
+{
+	FlashBench_Run tRun;
+#ifndef FLASHMAN_USE_FRDYI
+	uint64_t ullHoldNs;
+#endif
+	uint64_t ullMaxHoldNs = 0;
+	uint32_t ulTicks = 0;
+	uint32_t ulOffset;
+	uint8_t ucReturn;
+
+	FlashBench_EraseAll();
+
+	FlashBench_Start(&tRun);
+	if(uiSize == 0)
+	{
+		ucReturn = FlashMan_SubmitEraseDF(FLASHBENCH_DEVICE->ulWriteBase, 0);
+	}
+	else
+	{
+		ucReturn = FlashMan_SubmitWriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase, uiSize, 0);
+	}
+	ullMaxHoldNs = FlashSim_Now() - tRun.ullStartNs;
+
+	//A submit while busy is rejected and leaves the operation in progress as it is
+	if((ucReturn == 0) && (FlashMan_SubmitWriteDF(&s_aucPattern[1], FLASHBENCH_DEVICE->ulWriteBase + 1, 1, 0)
+							!= ERR_FLASHE2DATA_BUSY))
+	{
+		printf("  asynchronous submit while busy not rejected\n");
+		s_ulErrors++;
+	}
+
+#ifdef FLASHMAN_USE_FRDYI
+	s_ullIsrMaxNs = ullMaxHoldNs;
+#endif
+	while((ucReturn == 0) && FlashMan_IsBusy())
+	{
+		FlashSim_Advance(100000);
+#ifndef FLASHMAN_USE_FRDYI
+		ullHoldNs = FlashSim_Now();
+		(void)FlashMan_Poll();
+		ullHoldNs = FlashSim_Now() - ullHoldNs;
+		if(ullHoldNs > ullMaxHoldNs)
+		{
+			ullMaxHoldNs = ullHoldNs;
+		}
+#endif
+		ulTicks++;
+	}
+#ifdef FLASHMAN_USE_FRDYI
+	ullMaxHoldNs = s_ullIsrMaxNs;
+#endif
+	if((ucReturn != 0) || (FlashMan_GetLastStatus() != FLASHMAN_STATUS_OK))
+	{
+		printf("  asynchronous operation failed\n");
+		s_ulErrors++;
+	}
+	for(ulOffset = 0; ulOffset < uiSize; ulOffset++)
+	{
+		if(FlashSim_Peek(ulOffset) != s_aucPattern[ulOffset])
+		{
+			printf("  asynchronous write mismatch at %lu\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+
+	if(uiSize == 0)
+	{
+		FlashBench_Report(&tRun, "async erase", FLASHBENCH_DEVICE->uiBlockSize, 1, 1, "blocks/s");
+	}
+	else
+	{
+		FlashBench_Report(&tRun, "async write", uiSize, 1, uiSize, "bytes/s");
+	}
+#ifdef FLASHMAN_USE_FRDYI
+	printf("%-14s %6s %6lu ticks, longest FlashMan_FrdyIsr %.2f us\n", "", "", (unsigned long)ulTicks,
+			(double)ullMaxHoldNs / 1e3);
+#else
+	printf("%-14s %6s %6lu ticks, longest FlashMan_Poll %.2f us\n", "", "", (unsigned long)ulTicks,
+			(double)ullMaxHoldNs / 1e3);
+#endif
+}
+#endif
+
+#ifdef FLASHMAN_USE_FRDYI
+/**
+* @brief	This function is the FRDY interrupt handler given to the model, timed around FlashMan_FrdyIsr
+* @param	none
+* @return	none
+*/
+static void FlashBench_FrdyIsr(void)
+{
+	uint64_t ullNs = FlashSim_Now();
+
+	FlashMan_FrdyIsr();
+	ullNs = FlashSim_Now() - ullNs;
+	if(ullNs > s_ullIsrMaxNs)
+	{
+		s_ullIsrMaxNs = ullNs;
+	}
+}
+
+/**
+* @brief	This function runs an interrupt driven write of uiSize bytes while the foreground keeps calling
+*			FlashMan_ReadDF, rejected as busy. With the trace the timestamp of the reject is the only model access
+*			of the loop, so every interrupt is raised in the middle of a trace event: the trace must still count one
+*			event per reject and end with the end of the write. The statistics must count one more write.
+* @param	uiSize, bytes to write
+* @return	none
+*/
+static void FlashBench_Interrupt(uint16_t uiSize)
+{
+#ifdef FLASHMAN_TRACE
+	const FlashMan_Trace *ptTrace = FlashMan_GetTrace();
+	const FlashMan_TraceEvent *ptLast;
+#endif
+#ifndef FLASHMAN_NO_STATS
+	FlashMan_Stats tBefore;
+	FlashMan_Stats tAfter;
+#endif
+	FlashBench_Run tRun;
+	uint8_t aucRead[1];
+	uint32_t ulRejected = 0;
+	uint32_t ulOffset;
+	uint8_t ucReturn;
+
+	FlashBench_EraseAll();
+#ifndef FLASHMAN_NO_STATS
+	FlashMan_GetStats(&tBefore);
+#endif
+#ifdef FLASHMAN_TRACE
+	FlashMan_ClearTrace();
+#endif
+	s_ullIsrMaxNs = 0;
+
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_SubmitWriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase, uiSize, 0);
+	while((ucReturn == 0) && FlashMan_IsBusy())
+	{
+		//Busy, or not staged with FLASHMAN_STAGE: the next block, as the data being written is staged
+		ulRejected += (FlashMan_ReadDF(aucRead, FLASHBENCH_DEVICE->ulReadBase + FLASHBENCH_DEVICE->uiBlockSize, 1) != 0);
+#ifndef FLASHMAN_TRACE
+		//Without the trace a reject takes no model time
+		FlashSim_Delay(1);
+#endif
+	}
+	FlashBench_Report(&tRun, "frdyi write", uiSize, 1, uiSize, "bytes/s");
+	printf("%-14s %6s %6s %lu interrupts (%lu raised while masked), longest FlashMan_FrdyIsr %.2f us, "
+			"%lu rejects\n", "", "", "", (unsigned long)(FlashSim_GetStats()->ulInterrupts - tRun.tStart.ulInterrupts),
+			(unsigned long)(FlashSim_GetStats()->ulDeferredInts - tRun.tStart.ulDeferredInts),
+			(double)s_ullIsrMaxNs / 1e3, (unsigned long)ulRejected);
+
+	if((ucReturn != 0) || (FlashMan_GetLastStatus() != FLASHMAN_STATUS_OK))
+	{
+		printf("  interrupt driven write failed\n");
+		s_ulErrors++;
+	}
+	for(ulOffset = 0; ulOffset < uiSize; ulOffset++)
+	{
+		if(FlashSim_Peek(ulOffset) != s_aucPattern[ulOffset])
+		{
+			printf("  interrupt driven write mismatch at %lu\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+#ifdef FLASHMAN_TRACE
+	//Submit, P/E mode entry (begin and end), rejects, read mode entry from the interrupt, end
+	ptLast = &ptTrace->atEvent[(ptTrace->ulCount - 1U) & (FLASHMAN_TRACE_SIZE - 1U)];
+	if(	(ptTrace->ulCount != (ulRejected + 6U)) || (ptLast->ucEvent != FLASHMAN_TR_WRITE)
+		|| (ptLast->ucKind != FLASHMAN_TR_END))
+	{
+		printf("  trace of the interrupt driven write: %lu events for %lu rejects, last %u/%u\n",
+				(unsigned long)ptTrace->ulCount, (unsigned long)ulRejected, (unsigned)ptLast->ucEvent,
+				(unsigned)ptLast->ucKind);
+		s_ulErrors++;
+	}
+#endif
+#ifndef FLASHMAN_NO_STATS
+	FlashMan_GetStats(&tAfter);
+	if(	(tAfter.atOp[FLASHMAN_STATS_WRITE].ulCalls != (tBefore.atOp[FLASHMAN_STATS_WRITE].ulCalls + 1U))
+		|| (tAfter.ulBytesProgrammed != (tBefore.ulBytesProgrammed + uiSize)))
+	{
+		printf("  statistics of the interrupt driven write not counted\n");
+		s_ulErrors++;
+	}
+#endif
+}
+#else
+/**
+* @brief	This function is the step hook of FlashBench_Budget, it stands for a watchdog refresh
+* @param	none
+* @return	none
+*/
+static void FlashBench_StepHook(void)
+{
+	uint64_t ullNow = FlashSim_Now();
+
+	if((ullNow - s_ullHookNs) > s_ullHookGapNs)
+	{
+		s_ullHookGapNs = ullNow - s_ullHookNs;
+	}
+	s_ullHookNs = ullNow;
+	s_ulHookCalls++;
+}
+
+/**
+* @brief	This function measures a write of uiSize bytes run by FlashMan_PollBudget from a 1 ms scheduler slot:
+*			the slots it takes, the longest FlashMan_PollBudget call and the longest time inside of a call
+*			without a step hook call
+* @param	uiSize, bytes to write
+* @param	ulMaxUs, time budget per slot, 0 for none
+* @param	uiMaxSteps, bytes per slot, 0 for no limit
+* @return	none
+*/
+static void FlashBench_Budget(uint16_t uiSize, uint32_t ulMaxUs, uint16_t uiMaxSteps)
+{
+	FlashBench_Run tRun;
+	char acName[16];
+	uint64_t ullHoldNs;
+	uint64_t ullMaxHoldNs;
+	uint32_t ulSlots = 0;
+	uint32_t ulOffset;
+	uint8_t ucReturn;
+
+	FlashBench_EraseAll();
+	FlashMan_SetStepHook(FlashBench_StepHook);
+	s_ullHookGapNs = 0;
+	s_ulHookCalls = 0;
+
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_SubmitWriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase, uiSize, 0);
+	ullMaxHoldNs = FlashSim_Now() - tRun.ullStartNs;
+
+	while((ucReturn == 0) && FlashMan_IsBusy())
+	{
+		FlashSim_Advance(1000000);
+		ullHoldNs = FlashSim_Now();
+		s_ullHookNs = ullHoldNs;
+		(void)FlashMan_PollBudget(ulMaxUs, uiMaxSteps);
+		ullHoldNs = FlashSim_Now() - ullHoldNs;
+		if(ullHoldNs > ullMaxHoldNs)
+		{
+			ullMaxHoldNs = ullHoldNs;
+		}
+		ulSlots++;
+	}
+	FlashMan_SetStepHook(0);
+	if((ucReturn != 0) || (FlashMan_GetLastStatus() != FLASHMAN_STATUS_OK))
+	{
+		printf("  budgeted write failed\n");
+		s_ulErrors++;
+	}
+
+	//One hook call per byte programmed
+	if(s_ulHookCalls != uiSize)
+	{
+		printf("  %lu step hook calls for %u bytes\n", (unsigned long)s_ulHookCalls, (unsigned)uiSize);
+		s_ulErrors++;
+	}
+
+	//A budget of seconds takes the whole write in one slot, whatever it gives in counter cycles
+	if((ulMaxUs >= 1000000UL) && (ulSlots > 1))
+	{
+		printf("  budget of %lu us cut the write in %lu slots\n", (unsigned long)ulMaxUs, (unsigned long)ulSlots);
+		s_ulErrors++;
+	}
+
+	if(ulMaxUs >= 1000000UL)
+	{
+		(void)snprintf(acName, sizeof(acName), "budget %lus", (unsigned long)(ulMaxUs / 1000000UL));
+	}
+	else if(ulMaxUs != 0)
+	{
+		(void)snprintf(acName, sizeof(acName), "budget %luus", (unsigned long)ulMaxUs);
+	}
+	else
+	{
+		(void)snprintf(acName, sizeof(acName), "budget %uB", (unsigned)uiMaxSteps);
+	}
+	FlashBench_Report(&tRun, acName, uiSize, 1, uiSize, "bytes/s");
+	printf("%-14s %6s %6lu slots, longest call %.2f us, %lu hook calls, longest without hook %.2f us\n", "", "",
+			(unsigned long)ulSlots, (double)ullMaxHoldNs / 1e3, (unsigned long)s_ulHookCalls,
+			(double)s_ullHookGapNs / 1e3);
+
+	for(ulOffset = 0; ulOffset < uiSize; ulOffset++)
+	{
+		if(FlashSim_Peek(ulOffset) != s_aucPattern[ulOffset])
+		{
+			printf("  data mismatch at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+}
+#endif
+
+/**
+* @brief	This function uses the whole data flash in place through a view, checks it against the pattern, and
+*			checks that the view ends with the next write
+* @param	none
+* @return	none
+*/
+static void FlashBench_View(void)
+{
+	FlashBench_Run tRun;
+	FlashMan_View tView;
+	uint32_t ulOffset;
+	uint16_t uiSize;
+
+	FlashBench_Start(&tRun);
+	if(FlashMan_GetViewDF(FLASHBENCH_DEVICE->ulReadBase, (uint16_t)FLASHBENCH_AREA, &tView) != 0)
+	{
+		printf("  view failed\n");
+		s_ulErrors++;
+		return;
+	}
+	FlashBench_Report(&tRun, "view", FLASHBENCH_AREA, 1, FLASHBENCH_AREA, "bytes/s");
+
+	for(ulOffset = 0; (ulOffset < tView.uiSize) && FlashMan_IsViewValid(&tView); ulOffset++)
+	{
+		if(tView.pucData[ulOffset] != s_aucPattern[ulOffset])
+		{
+			printf("  view mismatch at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			break;
+		}
+	}
+
+	//Misaligned destination, byte path
+	for(uiSize = 1; uiSize < 16; uiSize++)
+	{
+		(void)FlashMan_ReadDF(&s_aucReadBuf[1], FLASHBENCH_DEVICE->ulReadBase, uiSize);
+		if(memcmp((const uint8_t *)&s_aucReadBuf[1], s_aucPattern, uiSize) != 0)
+		{
+			printf("  misaligned read mismatch, %u bytes\n", (unsigned)uiSize);
+			s_ulErrors++;
+			break;
+		}
+	}
+
+	(void)FlashMan_BlockEraseDF(FLASHBENCH_DEVICE->ulWriteBase);
+	if(FlashMan_IsViewValid(&tView))
+	{
+		printf("  view still valid after an erase\n");
+		s_ulErrors++;
+	}
+}
+
+/**
+* @brief	This function measures the write frontier search on block 0 filled with uiWritten bytes
+* @param	uiWritten, bytes written from the start of the block
+* @return	none
+*/
+static void FlashBench_Frontier(uint16_t uiWritten)
+{
+	FlashBench_Run tRun;
+	uint16_t uiOffset = 0xFFFF;
+
+	FlashBench_EraseAll();
+	(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase, uiWritten);
+
+	FlashBench_Start(&tRun);
+	if(	(FlashMan_FindFrontierDF(FLASHBENCH_DEVICE->ulWriteBase, FLASHBENCH_DEVICE->uiBlockSize, &uiOffset) != 0)
+		|| (uiOffset != uiWritten))
+	{
+		printf("  frontier found at %u instead of %u\n", (unsigned)uiOffset, (unsigned)uiWritten);
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "frontier", FLASHBENCH_DEVICE->uiBlockSize, 1, 1, "searches/s");
+	printf("%-14s %6s %6s %lu blank checks\n", "", "", "",
+			(unsigned long)(FlashSim_GetStats()->ulBlankCheckCmds - tRun.tStart.ulBlankCheckCmds));
+}
+
+#ifdef FLASHMAN_DIFF_MAX_SIZE
+/**
+* @brief	This function measures the differential write of a FLASHMAN_DIFF_MAX_SIZE parameter set: unchanged,
+*			with its last quarter still erased, with a written byte changed (which needs an erase), and with its
+*			first byte erased on a model whose erased cells read as that byte
+* @param	none
+* @return	none
+*/
+static void FlashBench_Diff(void)
+{
+	static uint8_t s_aucSet[FLASHMAN_DIFF_MAX_SIZE];
+	FlashSim_Config tConfig = *FLASHBENCH_DEVICE;
+	FlashBench_Run tRun;
+	uint16_t uiProgrammed;
+	uint8_t ucReturn;
+
+	FlashBench_EraseAll();
+	memcpy(s_aucSet, s_aucPattern, sizeof(s_aucSet));
+	(void)FlashMan_WriteDF(s_aucSet, FLASHBENCH_DEVICE->ulWriteBase, (3 * FLASHMAN_DIFF_MAX_SIZE) / 4);
+
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_WriteDiffDF(s_aucSet, FLASHBENCH_DEVICE->ulWriteBase, FLASHMAN_DIFF_MAX_SIZE, &uiProgrammed);
+	if((ucReturn != 0) || (uiProgrammed != (FLASHMAN_DIFF_MAX_SIZE / 4)))
+	{
+		printf("  differential write returned %u, %u bytes programmed\n", (unsigned)ucReturn, (unsigned)uiProgrammed);
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "diff 3/4 same", FLASHMAN_DIFF_MAX_SIZE, 1, FLASHMAN_DIFF_MAX_SIZE, "bytes/s");
+
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_WriteDiffDF(s_aucSet, FLASHBENCH_DEVICE->ulWriteBase, FLASHMAN_DIFF_MAX_SIZE, &uiProgrammed);
+	if((ucReturn != 0) || (uiProgrammed != 0))
+	{
+		printf("  differential write returned %u, %u bytes programmed\n", (unsigned)ucReturn, (unsigned)uiProgrammed);
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "diff same", FLASHMAN_DIFF_MAX_SIZE, 1, FLASHMAN_DIFF_MAX_SIZE, "bytes/s");
+
+	s_aucSet[10] ^= 0x01;
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_WriteDiffDF(s_aucSet, FLASHBENCH_DEVICE->ulWriteBase, FLASHMAN_DIFF_MAX_SIZE, &uiProgrammed);
+	if((ucReturn != ERR_FLASHE2DATA_NEEDERASE) || (uiProgrammed != 0))
+	{
+		printf("  differential write returned %u, %u bytes programmed\n", (unsigned)ucReturn, (unsigned)uiProgrammed);
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "diff changed", FLASHMAN_DIFF_MAX_SIZE, 1, FLASHMAN_DIFF_MAX_SIZE, "bytes/s");
+
+	//An erased cell reading as the new data, before a written one: only a blank check tells it must be programmed
+	tConfig.ucErasedValue = s_aucSet[0];
+	FlashSim_Init(&tConfig);
+	FlashManInit();
+	(void)FlashMan_WriteDF(&s_aucSet[1], FLASHBENCH_DEVICE->ulWriteBase + 1, FLASHMAN_DIFF_MAX_SIZE - 1);
+	ucReturn = FlashMan_WriteDiffDF(s_aucSet, FLASHBENCH_DEVICE->ulWriteBase, FLASHMAN_DIFF_MAX_SIZE, &uiProgrammed);
+	if((ucReturn != 0) || (uiProgrammed != 1) || FlashSim_IsBlank(0))
+	{
+		printf("  differential write returned %u, %u bytes programmed, erased byte %s\n", (unsigned)ucReturn,
+				(unsigned)uiProgrammed, FlashSim_IsBlank(0) ? "lost" : "stored");
+		s_ulErrors++;
+	}
+	FlashSim_Init(FLASHBENCH_DEVICE);
+	FlashManInit();
+}
+#endif
+
+#ifdef FLASHMAN_CRC
+/**
+* @brief	This function measures the block digests on block 0 filled as a log of uiRecords records: the digest kept
+*			while programming against reading the block back to compute its CRC, the verification of a saved
+*			digest and the scan after an out of order write. The CPU time of the CRC is not in the model.
+* @param	uiRecords, number of records
+* @param	uiSize, bytes per record
+* @return	none
+*/
+static void FlashBench_Digest(uint16_t uiRecords, uint16_t uiSize)
+{
+	static const uint8_t s_aucCheck[9] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	FlashBench_Run tRun;
+	FlashMan_Digest tDigest;
+	FlashMan_Digest tSaved;
+	uint16_t uiLength = (uint16_t)(uiRecords * uiSize);
+	uint16_t uiCrc;
+	uint16_t i;
+
+	if(FlashMan_Crc16(FLASHMAN_CRC_INIT, s_aucCheck, sizeof(s_aucCheck)) != 0x29B1)
+	{
+		printf("  wrong CRC-16/CCITT check value\n");
+		s_ulErrors++;
+	}
+
+	FlashBench_EraseAll();
+	for(i = 0; i < uiRecords; i++)
+	{
+		(void)FlashMan_WriteDF(&s_aucPattern[i * uiSize], FLASHBENCH_DEVICE->ulWriteBase + (i * uiSize), uiSize);
+	}
+
+	//What the application did at startup
+	FlashBench_Start(&tRun);
+	(void)FlashMan_ReadDF(s_aucReadBuf, FLASHBENCH_DEVICE->ulReadBase, uiLength);
+	uiCrc = FlashMan_Crc16(FLASHMAN_CRC_INIT, (const uint8_t *)s_aucReadBuf, uiLength);
+	FlashBench_Report(&tRun, "read + crc", uiLength, 1, 1, "checks/s");
+
+	FlashBench_Start(&tRun);
+	if((FlashMan_GetDigestDF(0, &tSaved) != 0) || (tSaved.uiCrc != uiCrc) || (tSaved.uiLength != uiLength))
+	{
+		printf("  digest kept while programming is wrong\n");
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "digest kept", uiLength, 1, 1, "checks/s");
+
+	//Saved digest taken at startup, verified later
+	(void)FlashMan_ClaimDigest(0, &tSaved);
+	FlashBench_Start(&tRun);
+	if((FlashMan_GetDigestDF(0, &tDigest) != 0) || (FlashMan_GetDigestState(0) != FLASHMAN_DIGEST_VALID))
+	{
+		printf("  saved digest not verified\n");
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "digest verify", uiLength, 1, 1, "checks/s");
+
+	//A byte after a hole: the digest has to be scanned again
+	(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase + uiLength + 1, 1);
+	FlashBench_Start(&tRun);
+	if(FlashMan_GetDigestDF(0, &tDigest) != 0)
+	{
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "digest scan", FLASHBENCH_DEVICE->uiBlockSize, 1, 1, "checks/s");
+	for(uiCrc = FLASHMAN_CRC_INIT, i = 0; i < tDigest.uiLength; i++)
+	{
+		uint8_t ucByte = FlashSim_Peek(i);
+
+		uiCrc = FlashMan_Crc16(uiCrc, &ucByte, 1);
+	}
+	if((tDigest.uiLength <= uiLength) || (tDigest.uiCrc != uiCrc))
+	{
+		printf("  scanned digest is wrong, %u bytes\n", (unsigned)tDigest.uiLength);
+		s_ulErrors++;
+	}
+
+	//The old digest no longer matches
+	(void)FlashMan_ClaimDigest(0, &tSaved);
+	if(FlashMan_GetDigestDF(0, &tDigest) != ERR_FLASHE2DATA_CRC)
+	{
+		printf("  stale digest not detected\n");
+		s_ulErrors++;
+	}
+}
+#endif
+
+#ifdef FLASHMAN_STAGE
+/**
+* @brief	This function reads staged data from a 100 us scheduler tick while the data flash is in P/E mode: a
+*			32 byte record of block 0 during the erase of block 2, and a 16 byte range of block 3 while it is
+*			written. The staged reads must see the data being written and never touch the array; reads of data not
+*			staged are rejected as before.
+* @param	none
+* @return	none
+*/
+static void FlashBench_Stage(void)
+{
+	uint32_t ulBlock = FLASHBENCH_DEVICE->uiBlockSize;
+	uint8_t aucRead[32];
+	FlashBench_Run tRun;
+	uint32_t ulReads = 0;
+	uint32_t ulRejected = 0;
+	uint32_t ulMismatches = 0;
+	uint64_t ullEraseNs;
+	uint8_t ucReturn;
+
+	FlashBench_EraseAll();
+	FlashMan_UnstageDF();
+	(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase, 32);
+	(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase + (2 * ulBlock), 1);
+	if(	(FlashMan_StageDF(FLASHBENCH_DEVICE->ulReadBase, 32) != 0)
+		|| (FlashMan_StageDF(FLASHBENCH_DEVICE->ulReadBase + (3 * ulBlock), 16) != 0))
+	{
+		printf("  staging failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_SubmitEraseDF(FLASHBENCH_DEVICE->ulWriteBase + (2 * ulBlock), 0);
+	while((ucReturn == 0) && FlashMan_IsBusy())
+	{
+		FlashSim_Advance(100000);
+		if(FlashMan_ReadDF(aucRead, FLASHBENCH_DEVICE->ulReadBase, 32) == 0)
+		{
+			ulReads++;
+			ulMismatches += (memcmp(aucRead, s_aucPattern, 32) != 0);
+		}
+		ulRejected += (FlashMan_ReadDF(aucRead, FLASHBENCH_DEVICE->ulReadBase + ulBlock, 1) == ERR_FLASHE2DATA_BUSY);
+#ifndef FLASHMAN_USE_FRDYI
+		(void)FlashMan_Poll();
+#endif
+	}
+	ullEraseNs = FlashSim_Now() - tRun.ullStartNs;
+	FlashBench_Report(&tRun, "staged erase", FLASHBENCH_DEVICE->uiBlockSize, 1, 1, "blocks/s");
+
+	FlashBench_Start(&tRun);
+	ucReturn |= FlashMan_SubmitWriteDF(&s_aucPattern[64], FLASHBENCH_DEVICE->ulWriteBase + (3 * ulBlock), 16, 0);
+	while((ucReturn == 0) && FlashMan_IsBusy())
+	{
+		FlashSim_Advance(100000);
+		if(FlashMan_ReadDF(aucRead, FLASHBENCH_DEVICE->ulReadBase + (3 * ulBlock), 16) == 0)
+		{
+			ulReads++;
+			ulMismatches += (memcmp(aucRead, &s_aucPattern[64], 16) != 0);
+		}
+#ifndef FLASHMAN_USE_FRDYI
+		(void)FlashMan_Poll();
+#endif
+	}
+	FlashBench_Report(&tRun, "staged write", 16, 1, 16, "bytes/s");
+
+	printf("%-14s %6s %6s %lu reads from RAM in P/E mode (%lu mismatches), %lu unstaged rejected; "
+			"without staging a read waits up to %.1f us\n", "", "", "", (unsigned long)ulReads,
+			(unsigned long)ulMismatches, (unsigned long)ulRejected, (double)ullEraseNs / 1e3);
+
+	if((ucReturn != 0) || (ulReads == 0) || (ulMismatches != 0) || (ulRejected == 0)
+		|| (FlashMan_ReadDF(aucRead, FLASHBENCH_DEVICE->ulReadBase + (3 * ulBlock), 16) != 0)
+		|| (memcmp(aucRead, &s_aucPattern[64], 16) != 0))
+	{
+		printf("  staged read failed\n");
+		s_ulErrors++;
+	}
+	FlashMan_UnstageDF();
+}
+#endif
+
+#ifdef __FLASHEEPROM_H__
+/**
+* @brief	This function measures the EEPROM emulation: uiUpdates writes of FLASHEEP_MAX_KEYS values with a
+*			skewed key distribution, a remount and a check of every value against a RAM copy. It reports the bytes
+*			programmed per update and how evenly the erases are spread over the blocks.
+* @param	uiUpdates, number of writes
+* @return	none
+*/
+static void FlashBench_Eeprom(uint16_t uiUpdates)
+{
+	static uint8_t s_aucShadow[FLASHEEP_MAX_KEYS][FLASHBENCH_EEP_DATA];
+	FlashBench_Run tRun;
+	uint8_t aucValue[FLASHBENCH_EEP_DATA];
+	uint32_t ulSeed = 12345;
+	uint32_t ulProgrammed;
+	uint32_t ulMin = 0xFFFFFFFFUL;
+	uint32_t ulMax = 0;
+	uint32_t ulErases;
+	uint16_t uiKey;
+	uint16_t i;
+	uint8_t j;
+
+	if((FlashEep_Format() != 0) || (FlashEep_Mount() != 0))
+	{
+		printf("  EEPROM format failed\n");
+		s_ulErrors++;
+		return;
+	}
+	for(uiKey = 0; uiKey < FLASHEEP_MAX_KEYS; uiKey++)
+	{
+		memset(s_aucShadow[uiKey], 0, FLASHBENCH_EEP_DATA);
+		(void)FlashEep_Write(uiKey, s_aucShadow[uiKey], FLASHBENCH_EEP_DATA);
+	}
+
+	FlashSim_ClearStats();
+	FlashBench_Start(&tRun);
+	for(i = 0; i < uiUpdates; i++)
+	{
+		//Half of the updates go to the first 8 keys, as counters and last states usually do
+		ulSeed = (ulSeed * 1103515245UL) + 12345UL;
+		uiKey = (uint16_t)((ulSeed >> 16) % FLASHEEP_MAX_KEYS);
+		if(ulSeed & 0x8000UL)
+		{
+			uiKey &= 0x07;
+		}
+		for(j = 0; j < FLASHBENCH_EEP_DATA; j++)
+		{
+			s_aucShadow[uiKey][j] = (uint8_t)(i + j);
+		}
+		if(FlashEep_Write(uiKey, s_aucShadow[uiKey], FLASHBENCH_EEP_DATA) != 0)
+		{
+			printf("  EEPROM write %u failed\n", (unsigned)i);
+			s_ulErrors++;
+			break;
+		}
+	}
+	ulProgrammed = FlashSim_GetStats()->ulProgramCmds - tRun.tStart.ulProgramCmds;
+	FlashBench_Report(&tRun, "eeprom write", FLASHBENCH_EEP_DATA, uiUpdates, (uint32_t)uiUpdates * FLASHBENCH_EEP_DATA,
+						"bytes/s");
+
+	ulErases = 0;
+	for(j = 0; j < FLASHBENCH_DEVICE->ucBlockNum; j++)
+	{
+		ulErases += FlashSim_GetStats()->aulBlockErases[j];
+		if(FlashSim_GetStats()->aulBlockErases[j] < ulMin)
+		{
+			ulMin = FlashSim_GetStats()->aulBlockErases[j];
+		}
+		if(FlashSim_GetStats()->aulBlockErases[j] > ulMax)
+		{
+			ulMax = FlashSim_GetStats()->aulBlockErases[j];
+		}
+	}
+	printf("%-14s %6s %6s %.2f bytes programmed/update, %lu erases (%lu .. %lu per block)\n", "", "", "",
+			(double)ulProgrammed / uiUpdates, (unsigned long)ulErases, (unsigned long)ulMin, (unsigned long)ulMax);
+
+	FlashBench_Start(&tRun);
+	if(FlashEep_Mount() != 0)
+	{
+		printf("  EEPROM mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+	FlashBench_Report(&tRun, "eeprom mount", FLASHBENCH_AREA, 1, 1, "mounts/s");
+
+	//The key index is built on the first access
+	FlashBench_Start(&tRun);
+	if(FlashEep_Read(0, aucValue, FLASHBENCH_EEP_DATA) != 0)
+	{
+		printf("  EEPROM index failed\n");
+		s_ulErrors++;
+		return;
+	}
+	FlashBench_Report(&tRun, "eeprom index", FLASHBENCH_AREA, 1, 1, "indexes/s");
+
+	//Erase counts kept in the block headers, which include the erases done before the run
+	ulMin = 0xFFFFFFFFUL;
+	ulMax = 0;
+	for(j = 0; j < FLASHBENCH_DEVICE->ucBlockNum; j++)
+	{
+		uint32_t ulCount = FlashBlk_GetInfo(j)->ulEraseCount;
+
+		ulMin = (ulCount < ulMin) ? ulCount : ulMin;
+		ulMax = (ulCount > ulMax) ? ulCount : ulMax;
+	}
+	printf("%-14s %6s %6s block headers: %lu .. %lu erases per block\n", "", "", "", (unsigned long)ulMin,
+			(unsigned long)ulMax);
+
+	for(uiKey = 0; uiKey < FLASHEEP_MAX_KEYS; uiKey++)
+	{
+		if(	(FlashEep_Read(uiKey, aucValue, FLASHBENCH_EEP_DATA) != 0)
+			|| (memcmp(aucValue, s_aucShadow[uiKey], FLASHBENCH_EEP_DATA) != 0))
+		{
+			printf("  EEPROM key %u mismatch\n", (unsigned)uiKey);
+			s_ulErrors++;
+		}
+	}
+}
+#endif
+
+#ifdef __FLASHEEPROM_H__
+/**
+* @brief	This function leaves the data flash of a unit coming back to the station: something in every block
+* @param	none
+* @return	none
+*/
+static void FlashBench_EndOfLineDirty(void)
+{
+	uint32_t ulOffset;
+
+	FlashBench_EraseAll();
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset += FLASHBENCH_DEVICE->uiBlockSize)
+	{
+		(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase + ulOffset + 0x100, 0x40);
+	}
+}
+
+/**
+* @brief	This function measures the end of line programming of the default parameters: first as the firmware
+*			would do it, an erase of every block, an EEPROM format and one write per key, then as one image
+*			captured from that data flash and programmed by FlashMan_ProgramImageDF, both over dirty blocks. The EEPROM is mounted again on the image
+*			and every key is checked.
+* @param	uiKeys, number of keys written
+* @return	none
+*/
+static void FlashBench_EndOfLine(uint16_t uiKeys)
+{
+	static uint8_t s_aucData[FLASHSIM_MAX_SIZE];
+	static uint8_t s_aucProgram[FLASHSIM_MAX_SIZE / 8];
+	FlashMan_Image tImage = { s_aucData, s_aucProgram };
+	FlashBench_Run tRun;
+	uint8_t aucValue[FLASHBENCH_EEP_DATA];
+	uint32_t ulProgrammed = 0;
+	uint32_t ulFailed;
+	uint32_t ulOffset;
+	uint16_t uiKey;
+	uint8_t ucReturn;
+
+	//The whole data flash is erased first, so nothing of the tests done on the unit is left
+	FlashBench_EndOfLineDirty();
+	FlashBench_Start(&tRun);
+	FlashBench_EraseAll();
+	ucReturn = FlashEep_Format();
+	for(uiKey = 0; uiKey < uiKeys; uiKey++)
+	{
+		ucReturn |= FlashEep_Write(uiKey, &s_aucPattern[uiKey], FLASHBENCH_EEP_DATA);
+	}
+	FlashBench_Report(&tRun, "eol records", (uint32_t)uiKeys * FLASHBENCH_EEP_DATA, 1, 1, "images/s");
+	if(ucReturn != 0)
+	{
+		printf("  EEPROM defaults failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	//What FlashImage saves, the data flash holding nothing else
+	memset(s_aucProgram, 0, sizeof(s_aucProgram));
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset++)
+	{
+		s_aucData[ulOffset] = FlashSim_IsBlank(ulOffset) ? 0xFF : FlashSim_Peek(ulOffset);
+		if(!FlashSim_IsBlank(ulOffset))
+		{
+			s_aucProgram[ulOffset >> 3] |= (uint8_t)(1U << (ulOffset & 7));
+			ulProgrammed++;
+		}
+	}
+
+	FlashBench_EndOfLineDirty();
+	FlashBench_Start(&tRun);
+	ucReturn = FlashMan_ProgramImageDF(&tImage, &ulFailed);
+	FlashBench_Report(&tRun, "eol image", ulProgrammed, 1, 1, "images/s");
+	if((ucReturn != 0) || (ulFailed != 0))
+	{
+		printf("  image programming failed (%02X, blocks 0x%02lX)\n", ucReturn, (unsigned long)ulFailed);
+		s_ulErrors++;
+		return;
+	}
+	for(ulOffset = 0; ulOffset < FLASHBENCH_AREA; ulOffset++)
+	{
+		if(	((s_aucProgram[ulOffset >> 3] & (1U << (ulOffset & 7))) != 0)
+			? (FlashSim_IsBlank(ulOffset) || (FlashSim_Peek(ulOffset) != s_aucData[ulOffset]))
+			: !FlashSim_IsBlank(ulOffset))
+		{
+			printf("  image mismatch at offset 0x%04lX\n", (unsigned long)ulOffset);
+			s_ulErrors++;
+			return;
+		}
+	}
+	printf("%-14s %6s %6s %lu bytes programmed, the rest left erased\n", "", "", "", (unsigned long)ulProgrammed);
+
+	if(FlashEep_Mount() != 0)
+	{
+		printf("  EEPROM mount on the image failed\n");
+		s_ulErrors++;
+		return;
+	}
+	for(uiKey = 0; uiKey < uiKeys; uiKey++)
+	{
+		if(	(FlashEep_Read(uiKey, aucValue, FLASHBENCH_EEP_DATA) != 0)
+			|| (memcmp(aucValue, &s_aucPattern[uiKey], FLASHBENCH_EEP_DATA) != 0))
+		{
+			printf("  EEPROM key %u mismatch on the image\n", (unsigned)uiKey);
+			s_ulErrors++;
+			break;
+		}
+	}
+
+	//The EEPROM still works on it
+	if(FlashEep_Write(0, &s_aucPattern[1], FLASHBENCH_EEP_DATA) != 0)
+	{
+		printf("  EEPROM write on the image failed\n");
+		s_ulErrors++;
+	}
+}
+
+/**
+* @brief	This function runs the EEPROM on a model whose erased cells read ucErased instead of 0xFF, as the
+*			erased value of the real device is undefined: uiUpdates random writes with a remount and a check of
+*			every value every 50 writes, so the spare blocks left by each block change are mounted too. The model
+*			is then set back to the bench device.
+* @param	ucErased, value read from erased cells
+* @param	uiUpdates, number of writes
+* @return	none
+*/
+static void FlashBench_ErasedValue(uint8_t ucErased, uint16_t uiUpdates)
+{
+	static uint8_t s_aucShadow[FLASHEEP_MAX_KEYS][FLASHBENCH_EEP_DATA];
+	FlashSim_Config tConfig = *FLASHBENCH_DEVICE;
+	uint8_t aucValue[FLASHBENCH_EEP_DATA];
+	uint32_t ulSeed = 4321;
+	uint32_t ulMounts = 0;
+	uint32_t ulFailed = 0;
+	uint16_t uiKey;
+	uint16_t i;
+
+	tConfig.ucErasedValue = ucErased;
+	FlashSim_Init(&tConfig);
+	FlashManInit();
+	if(FlashEep_Format() != 0)
+	{
+		ulFailed++;
+	}
+	memset(s_aucShadow, 0, sizeof(s_aucShadow));
+	for(uiKey = 0; (uiKey < FLASHEEP_MAX_KEYS) && (ulFailed == 0); uiKey++)
+	{
+		ulFailed += (FlashEep_Write(uiKey, s_aucShadow[uiKey], FLASHBENCH_EEP_DATA) != 0) ? 1U : 0U;
+	}
+
+	for(i = 1; (i <= uiUpdates) && (ulFailed == 0); i++)
+	{
+		ulSeed = (ulSeed * 1103515245UL) + 12345UL;
+		uiKey = (uint16_t)((ulSeed >> 16) % FLASHEEP_MAX_KEYS);
+		memcpy(s_aucShadow[uiKey], &s_aucPattern[(ulSeed >> 4) & 0x3FF], FLASHBENCH_EEP_DATA);
+		ulFailed += (FlashEep_Write(uiKey, s_aucShadow[uiKey], FLASHBENCH_EEP_DATA) != 0) ? 1U : 0U;
+
+		if((i % 50) == 0)
+		{
+			FlashManInit();
+			ulFailed += (FlashEep_Mount() != 0) ? 1U : 0U;
+			ulMounts++;
+			for(uiKey = 0; (uiKey < FLASHEEP_MAX_KEYS) && (ulFailed == 0); uiKey++)
+			{
+				if(	(FlashEep_Read(uiKey, aucValue, FLASHBENCH_EEP_DATA) != 0)
+					|| (memcmp(aucValue, s_aucShadow[uiKey], FLASHBENCH_EEP_DATA) != 0))
+				{
+					printf("  EEPROM key %u lost after %u writes (erased 0x%02X)\n", (unsigned)uiKey, (unsigned)i,
+							(unsigned)ucErased);
+					ulFailed++;
+				}
+			}
+		}
+	}
+	s_ulErrors += ulFailed;
+
+	printf("%-14s %6s %6u writes, erased cells read 0x%02X, %lu remounts, %s\n", "eeprom erased", "",
+			(unsigned)uiUpdates, (unsigned)ucErased, (unsigned long)ulMounts,
+			(ulFailed == 0) ? "values kept" : "FAILED");
+
+	FlashSim_Init(FLASHBENCH_DEVICE);
+	FlashManInit();
+}
+#endif
+
+#ifdef __FLASHQUEUE_H__
+/**
+* @brief	This function measures the write queue on bursts of small writes from three modules, in a new 32 byte
+*			window each: a 8 byte record saved twice (the second one replaces the first one), an adjacent 8 byte
+*			record and a 16 byte record with 4 bytes updated right after. They are first written with one
+*			FlashMan_WriteDF per record, already merged by hand, then posted as they come, with FlashQ_Task
+*			called on every tick, and the data flash is checked against the last data posted.
+* @param	uiBursts, number of bursts
+* @return	none
+*/
+static void FlashBench_Queue(uint16_t uiBursts)
+{
+	static const uint8_t s_aucOfs[] = { 0, 0, 8, 16, 20 };
+	static const uint8_t s_aucLen[] = { 8, 8, 8, 16, 4 };
+	uint8_t aucImage[32];
+	uint8_t aucPost[16];
+	FlashBench_Run tRun;
+	FlashQ_Stats tStats;
+	uint32_t ulBase;
+	uint32_t ulPosts = 0;
+	uint32_t ulProgrammed;
+	uint16_t uiBurst;
+	uint8_t i;
+	uint8_t j;
+
+	//Direct writes, one per record
+	FlashBench_EraseAll();
+	FlashBench_Start(&tRun);
+	for(uiBurst = 0; uiBurst < uiBursts; uiBurst++)
+	{
+		ulBase = (uint32_t)uiBurst * sizeof(aucImage);
+		(void)FlashMan_WriteDF(&s_aucPattern[ulBase], FLASHBENCH_DEVICE->ulWriteBase + ulBase, 8);
+		(void)FlashMan_WriteDF(&s_aucPattern[ulBase + 8], FLASHBENCH_DEVICE->ulWriteBase + ulBase + 8, 8);
+		(void)FlashMan_WriteDF(&s_aucPattern[ulBase + 16], FLASHBENCH_DEVICE->ulWriteBase + ulBase + 16, 16);
+	}
+	ulProgrammed = FlashSim_GetStats()->ulProgramCmds - tRun.tStart.ulProgramCmds;
+	FlashBench_Report(&tRun, "direct writes", 0, (uint32_t)uiBursts * 3, ulProgrammed, "bytes/s");
+
+	//The same records posted as they come
+	FlashBench_EraseAll();
+	FlashQ_Init();
+	FlashBench_Start(&tRun);
+	for(uiBurst = 0; uiBurst < uiBursts; uiBurst++)
+	{
+		ulBase = (uint32_t)uiBurst * sizeof(aucImage);
+		memcpy(aucImage, &s_aucPattern[ulBase], sizeof(aucImage));
+		for(i = 0; i < sizeof(s_aucOfs); i++)
+		{
+			//Older copies of a record hold other data
+			for(j = 0; j < s_aucLen[i]; j++)
+			{
+				aucPost[j] = ((i == 0) || ((i == 3) && (j >= 4) && (j < 8))) ? (uint8_t)~aucImage[s_aucOfs[i] + j]
+																				: aucImage[s_aucOfs[i] + j];
+			}
+			if(FlashQ_Post(aucPost, FLASHBENCH_DEVICE->ulWriteBase + ulBase + s_aucOfs[i], s_aucLen[i]) != 0)
+			{
+				printf("  queue post failed\n");
+				s_ulErrors++;
+			}
+			ulPosts++;
+			(void)FlashQ_Task();
+		}
+		for(i = 0; i <= FLASHQ_HOLD_TICKS; i++)
+		{
+			(void)FlashQ_Task();
+		}
+	}
+	if((FlashQ_Flush() != 0) || FlashQ_IsPending())
+	{
+		printf("  queue flush failed\n");
+		s_ulErrors++;
+	}
+	FlashQ_GetStats(&tStats);
+	ulProgrammed = FlashSim_GetStats()->ulProgramCmds - tRun.tStart.ulProgramCmds;
+	FlashBench_Report(&tRun, "queued writes", 0, ulPosts, ulProgrammed, "bytes/s");
+	printf("%-14s %6s %6s %lu posts, %lu bytes posted, %lu programmed in %lu transactions (%lu failed)\n", "", "", "",
+			(unsigned long)tStats.ulPosts, (unsigned long)tStats.ulBytesPosted, (unsigned long)tStats.ulBytesProgrammed,
+			(unsigned long)tStats.ulDrains, (unsigned long)tStats.ulDrainErrors);
+
+	if(	(tStats.ulPosts != ulPosts) || (tStats.ulBytesProgrammed != ulProgrammed)
+		|| (memcmp(FlashSim_ReadPtr(FLASHBENCH_DEVICE->ulReadBase), s_aucPattern, (size_t)uiBursts * sizeof(aucImage)) != 0))
+	{
+		printf("  queue data mismatch\n");
+		s_ulErrors++;
+	}
+}
+#endif
+
+#ifdef __FLASHCACHE_H__
+/**
+* @brief	This function measures the RAM mirror on a hot parameter: uiUpdates read/modify/write cycles of a 4 byte
+*			counter in the cached range, driven from a scheduler tick, in bursts of 20 followed by enough idle ticks
+*			for a write back. The time covers the write backs, the bytes programmed per update are printed apart.
+*			The mirror is then loaded again and checked.
+* @param	uiUpdates, number of cycles
+* @return	none
+*/
+static void FlashBench_Cache(uint16_t uiUpdates)
+{
+	FlashBench_Run tRun;
+	uint8_t aucValue[4];
+	uint32_t ulCounter;
+	uint32_t ulPrograms;
+	uint16_t uiFlushes = 0;
+	uint16_t i;
+	uint16_t j;
+
+	FlashBench_EraseAll();
+	if(	(FlashCache_Init() != 0) || (FlashCache_Write(s_aucPattern, FLASHCACHE_ADDR_WR, FLASHCACHE_SIZE) != 0)
+		|| (FlashCache_Flush() != 0))
+	{
+		printf("  cache load failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	FlashBench_Start(&tRun);
+	for(i = 0; i < uiUpdates; i++)
+	{
+		(void)FlashCache_Read(aucValue, FLASHCACHE_ADDR_RD + 0x40, sizeof(aucValue));
+		memcpy(&ulCounter, aucValue, sizeof(ulCounter));
+		ulCounter++;
+		memcpy(aucValue, &ulCounter, sizeof(ulCounter));
+		(void)FlashCache_Write(aucValue, FLASHCACHE_ADDR_WR + 0x40, sizeof(aucValue));
+		if(FlashCache_Tick() != 0)
+		{
+			s_ulErrors++;
+		}
+		if((i % 20) == 19)
+		{
+			for(j = 0; j < FLASHCACHE_IDLE_TICKS; j++)
+			{
+				if(FlashCache_Tick() != 0)
+				{
+					s_ulErrors++;
+				}
+			}
+			uiFlushes++;
+		}
+	}
+	FlashBench_Report(&tRun, "cache update", sizeof(aucValue), uiUpdates, (uint32_t)uiUpdates * sizeof(aucValue),
+						"bytes/s");
+	ulPrograms = FlashSim_GetStats()->ulProgramCmds - tRun.tStart.ulProgramCmds;
+	printf("%-14s %6s %6u write backs, %.2f bytes programmed per update, %lu erases\n", "", "",
+			(unsigned)uiFlushes, (double)ulPrograms / uiUpdates,
+			(unsigned long)(FlashSim_GetStats()->ulBlocksErased - tRun.tStart.ulBlocksErased));
+
+	//One last update, written back on the power fail warning
+	ulCounter++;
+	memcpy(aucValue, &ulCounter, sizeof(ulCounter));
+	(void)FlashCache_Write(aucValue, FLASHCACHE_ADDR_WR + 0x40, sizeof(aucValue));
+	FlashBench_Start(&tRun);
+	if(FlashCache_PowerFail() != 0)
+	{
+		printf("  cache write back failed\n");
+		s_ulErrors++;
+	}
+	FlashBench_Report(&tRun, "cache flush", FLASHCACHE_LINE_SIZE, 1, 1, "flushes/s");
+
+	FlashManInit();
+	if(FlashCache_Init() != 0)
+	{
+		printf("  cache reload failed\n");
+		s_ulErrors++;
+		return;
+	}
+	for(i = 0; i < FLASHCACHE_SIZE; i++)
+	{
+		(void)FlashCache_Read(aucValue, FLASHCACHE_ADDR_RD + i, 1);
+		if(aucValue[0] != ((i < 0x40 || i >= 0x44) ? s_aucPattern[i] : (uint8_t)(ulCounter >> ((i - 0x40) * 8))))
+		{
+			s_ulErrors++;
+			printf("  cache write back mismatch at 0x%04X\n", (unsigned)i);
+			break;
+		}
+	}
+}
+
+/**
+* @brief	This function is the cut hook of FlashBench_CacheCut: back to the test, as a reset would
+* @param	none
+* @return	none
+*/
+static void FlashBench_CacheCutHook(void)
+{
+	longjmp(s_tCacheCutJump, 1);
+}
+
+/**
+* @brief	This function changes random lines of the mirror and writes them back until the power is cut
+* @param	uiCut, number of the cut
+* @return	none
+*/
+static void FlashBench_CacheCutFlushes(uint16_t uiCut)
+{
+	uint16_t uiOffset;
+	uint8_t i;
+
+	if(setjmp(s_tCacheCutJump) != 0)
+	{
+		return;
+	}
+
+	for(;;)
+	{
+		memcpy(s_aucCacheValue, s_aucCacheShadow, FLASHCACHE_SIZE);
+		for(i = 0; i < 3; i++)
+		{
+			s_ulCacheSeed = (s_ulCacheSeed * 1103515245UL) + 12345UL;
+			uiOffset = (uint16_t)((s_ulCacheSeed >> 16) % FLASHCACHE_SIZE);
+			s_aucCacheValue[uiOffset] = (uint8_t)(s_ulCacheSeed >> 8);
+			(void)FlashCache_Write(&s_aucCacheValue[uiOffset], FLASHCACHE_ADDR_WR + uiOffset, 1);
+		}
+		if(FlashCache_Flush() != 0)
+		{
+			printf("  cache write back failed before cut %u\n", (unsigned)uiCut);
+			s_ulErrors++;
+			FlashSim_SetPowerCut(0, 0, 0, 0);
+			return;
+		}
+		memcpy(s_aucCacheShadow, s_aucCacheValue, FLASHCACHE_SIZE);
+	}
+}
+
+/**
+* @brief	This function cuts the power at random sequencer steps of cache write backs. After every cut the mirror
+*			is loaded again and every line is checked: it holds the value of the last write back or the one of the
+*			write back cut.
+* @param	uiCuts, number of cuts
+* @return	none
+*/
+static void FlashBench_CacheCut(uint16_t uiCuts)
+{
+	uint8_t aucMirror[FLASHCACHE_SIZE];
+	uint32_t ulFailed = 0;
+	uint16_t uiCut;
+	uint16_t uiLine;
+	uint16_t uiOffset;
+	uint8_t ucReturn;
+
+	FlashBench_EraseAll();
+	(void)FlashCache_Init();
+	memset(s_aucCacheShadow, FLASHCACHE_FILL, FLASHCACHE_SIZE);
+	s_ulCacheSeed = 2025;
+
+	for(uiCut = 0; uiCut < uiCuts; uiCut++)
+	{
+		s_ulCacheSeed = (s_ulCacheSeed * 1103515245UL) + 12345UL;
+		//One cut in four during an erase, they are rare among the commands
+		if((uiCut & 0x03) == 0)
+		{
+			FlashSim_SetPowerCut(FLASHSIM_CMD_ERASE, 1, s_ulCacheSeed, FlashBench_CacheCutHook);
+		}
+		else
+		{
+			FlashSim_SetPowerCut(0, 1 + ((s_ulCacheSeed >> 8) % FLASHBENCH_CUT_CMDS), s_ulCacheSeed,
+									FlashBench_CacheCutHook);
+		}
+		FlashBench_CacheCutFlushes(uiCut);
+
+		//Startup
+		FlashSim_PowerOn();
+		FlashManInit();
+		ucReturn = FlashCache_Init();
+		if(ucReturn == 0)
+		{
+			ucReturn = FlashCache_Read(aucMirror, FLASHCACHE_ADDR_RD, FLASHCACHE_SIZE);
+		}
+		for(uiLine = 0; (uiLine < (FLASHCACHE_SIZE / FLASHCACHE_LINE_SIZE)) && (ucReturn == 0); uiLine++)
+		{
+			uiOffset = uiLine * FLASHCACHE_LINE_SIZE;
+			if(	(memcmp(&aucMirror[uiOffset], &s_aucCacheShadow[uiOffset], FLASHCACHE_LINE_SIZE) != 0)
+				&& (memcmp(&aucMirror[uiOffset], &s_aucCacheValue[uiOffset], FLASHCACHE_LINE_SIZE) != 0))
+			{
+				ucReturn = FLASHBENCH_CUT_MISMATCH;
+			}
+		}
+		if(ucReturn != 0)
+		{
+			if(ulFailed < 4)
+			{
+				printf("  cache cut %u not recovered: line %u (0x%02X)\n", (unsigned)uiCut, (unsigned)(uiLine - 1U),
+						ucReturn);
+			}
+			ulFailed++;
+			s_ulErrors++;
+
+			//Start again from an empty log
+			FlashBench_EraseAll();
+			(void)FlashCache_Init();
+			memset(aucMirror, FLASHCACHE_FILL, FLASHCACHE_SIZE);
+		}
+		memcpy(s_aucCacheShadow, aucMirror, FLASHCACHE_SIZE);
+	}
+	FlashSim_SetPowerCut(0, 0, 0, 0);
+
+	printf("%-14s %6s %6u %lu not recovered\n", "cache cut", "", (unsigned)uiCuts, (unsigned long)ulFailed);
+}
+#endif
+
+#ifdef __FLASHCOUNTER_H__
+/**
+* @brief	This function measures counter increments against rewriting the counter in place (erase and program
+*			4 bytes) on every change, then mounts the counters again and checks the value
+* @param	uiIncrements, increments of counter 0
+* @return	none
+*/
+static void FlashBench_Counter(uint16_t uiIncrements)
+{
+	FlashBench_Run tRun;
+	uint8_t aucValue[4];
+	uint32_t ulValue = 0;
+	uint32_t ulErases;
+	uint16_t i;
+
+	FlashBench_EraseAll();
+	if(FlashCnt_Mount() != 0)
+	{
+		printf("  counter mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	FlashBench_Start(&tRun);
+	for(i = 0; i < uiIncrements; i++)
+	{
+		if(FlashCnt_Add(0, 1) != 0)
+		{
+			printf("  counter increment %u failed\n", (unsigned)i);
+			s_ulErrors++;
+			break;
+		}
+	}
+	ulErases = FlashSim_GetStats()->ulBlocksErased - tRun.tStart.ulBlocksErased;
+	FlashBench_Report(&tRun, "counter +1", 1, uiIncrements, uiIncrements, "incs/s");
+	printf("%-14s %6s %6s %.2f bytes programmed/increment, %lu erases\n", "", "", "",
+			(double)(FlashSim_GetStats()->ulProgramCmds - tRun.tStart.ulProgramCmds) / uiIncrements,
+			(unsigned long)ulErases);
+
+	//What a counter kept with FlashMan_WriteDF costs, a tenth of the increments are enough
+	FlashBench_Start(&tRun);
+	for(i = 0; i < (uiIncrements / 10); i++)
+	{
+		aucValue[0] = (uint8_t)i;
+		aucValue[1] = (uint8_t)(i >> 8);
+		aucValue[2] = 0;
+		aucValue[3] = 0;
+		(void)FlashMan_EraseBlocksDF(FLASHBENCH_DEVICE->ulWriteBase, 1, 0);
+		(void)FlashMan_WriteDF(aucValue, FLASHBENCH_DEVICE->ulWriteBase, sizeof(aucValue));
+	}
+	FlashBench_Report(&tRun, "rewrite +1", 4, uiIncrements / 10, uiIncrements / 10, "incs/s");
+
+	FlashBench_Start(&tRun);
+	if(FlashCnt_Mount() != 0)
+	{
+		printf("  counter mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+	FlashBench_Report(&tRun, "counter mount", 2 * FLASHCNT_COUNTERS * FLASHBENCH_DEVICE->uiBlockSize, 1, 1,
+						"mounts/s");
+
+	if((FlashCnt_Get(0, &ulValue) != 0) || (ulValue != uiIncrements))
+	{
+		printf("  counter 0 is %lu instead of %u\n", (unsigned long)ulValue, (unsigned)uiIncrements);
+		s_ulErrors++;
+	}
+#if FLASHCNT_COUNTERS > 1
+	//A big amount folds at once
+	if((FlashCnt_Add(1, 100000UL) != 0) || (FlashCnt_Get(1, &ulValue) != 0) || (ulValue != 100000UL))
+	{
+		printf("  counter 1 is %lu instead of 100000\n", (unsigned long)ulValue);
+		s_ulErrors++;
+	}
+#endif
+}
+#endif
+
+#ifdef __FLASHJOURNAL_H__
+/**
+* @brief	This function measures journal appends, wrapping around the ring, and the mount that finds the head
+*			again, then checks the entries kept
+* @param	uiEntries, entries to append
+* @return	none
+*/
+static void FlashBench_Journal(uint16_t uiEntries)
+{
+	FlashBench_Run tRun;
+	uint8_t aucEntry[FLASHJRN_ENTRY_DATA];
+	uint16_t uiCount;
+	uint16_t i;
+	uint8_t j;
+
+	FlashBench_EraseAll();
+	if(FlashJrn_Mount() != 0)
+	{
+		printf("  journal mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	FlashBench_Start(&tRun);
+	for(i = 0; i < uiEntries; i++)
+	{
+		for(j = 0; j < FLASHJRN_ENTRY_DATA; j++)
+		{
+			aucEntry[j] = (uint8_t)(i >> (8 * (j & 1)));
+		}
+		if(FlashJrn_Append(aucEntry) != 0)
+		{
+			printf("  journal append %u failed\n", (unsigned)i);
+			s_ulErrors++;
+			break;
+		}
+	}
+	FlashBench_Report(&tRun, "journal append", FLASHJRN_ENTRY_DATA, uiEntries, uiEntries, "entries/s");
+
+	FlashBench_Start(&tRun);
+	if(FlashJrn_Mount() != 0)
+	{
+		printf("  journal mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+	FlashBench_Report(&tRun, "journal mount", FLASHJRN_BLOCKS * FLASHBENCH_DEVICE->uiBlockSize, 1, 1, "mounts/s");
+
+	uiCount = FlashJrn_GetCount();
+	printf("%-14s %6s %6s %u entries kept\n", "", "", "", (unsigned)uiCount);
+	if((uiCount > uiEntries) || (uiCount < ((FLASHJRN_BLOCKS - 1) * FLASHJRN_BLOCK_ENTRIES)))
+	{
+		printf("  journal keeps %u entries\n", (unsigned)uiCount);
+		s_ulErrors++;
+	}
+	for(i = 0; i < uiCount; i++)
+	{
+		uint16_t uiIndex = (uint16_t)(uiEntries - 1 - i);
+
+		if(	(FlashJrn_Read(i, aucEntry) != 0) || (aucEntry[0] != (uint8_t)uiIndex)
+			|| (aucEntry[1] != (uint8_t)(uiIndex >> 8)))
+		{
+			printf("  journal entry %u back mismatch\n", (unsigned)i);
+			s_ulErrors++;
+			break;
+		}
+	}
+}
+#endif
+
+#ifdef __FLASHBLOCK_H__
+/**
+* @brief	This function rewrites a one block record, the way a module with a block of its own does: a block is
+*			activated, filled and retired for every rewrite. The block is block 0 every time, or the one handed out
+*			by FlashBlk_Alloc, and the wear of the data flash is reported from the block headers.
+* @param	uiRewrites, rewrites of the record
+* @param	ucAlloc, 1 to take the block from FlashBlk_Alloc, 0 for block 0
+* @return	none
+*/
+static void FlashBench_Wear(uint16_t uiRewrites, uint8_t ucAlloc)
+{
+	FlashBench_Run tRun;
+	FlashBlk_Wear tWear;
+	uint16_t uiData = (uint16_t)(FLASHBENCH_DEVICE->uiBlockSize - FLASHBLK_HDR_SIZE);
+	uint32_t ulExpect;
+	uint8_t ucBlock = 0;
+	uint8_t ucReturn;
+	uint16_t i;
+
+	FlashBench_EraseAll();
+	if(FlashBlk_Mount() != 0)
+	{
+		printf("  block mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+	memset(s_aucPattern, 0x5A, uiData);
+
+	FlashBench_Start(&tRun);
+	for(i = 0; i < uiRewrites; i++)
+	{
+		ucReturn = ucAlloc ? FlashBlk_Alloc(0, FLASHBENCH_DEVICE->ucBlockNum, &ucBlock) : 0;
+		if(ucReturn == 0)
+		{
+			ucReturn = FlashBlk_Activate(ucBlock, i);
+		}
+		if(ucReturn == 0)
+		{
+			ucReturn = FlashMan_WriteDF(s_aucPattern, mFlashMan_BlockAddrWr(ucBlock) + FLASHBLK_HDR_SIZE, uiData);
+		}
+		if(ucReturn == 0)
+		{
+			ucReturn = FlashBlk_Retire(ucBlock);
+		}
+		if(ucReturn != 0)
+		{
+			printf("  rewrite %u failed (%02X)\n", (unsigned)i, ucReturn);
+			s_ulErrors++;
+			break;
+		}
+	}
+	FlashBench_Report(&tRun, ucAlloc ? "wear alloc" : "wear fixed", uiData, uiRewrites, uiRewrites, "rewrites/s");
+
+	//The counts must survive a reset
+	if((FlashBlk_Mount() != 0) || (FlashBlk_GetWear(&tWear) != 0))
+	{
+		printf("  block mount failed\n");
+		s_ulErrors++;
+		return;
+	}
+	printf("%-14s %6s %6s %lu .. %lu erases per block, block %u has %lu left (%u%% of %lu)\n", "", "", "",
+			(unsigned long)tWear.ulMin, (unsigned long)tWear.ulMax, (unsigned)tWear.ucMaxBlock,
+			(unsigned long)tWear.ulLeft, (unsigned)tWear.ucMarginPct, (unsigned long)FLASHMAN_PE_CYCLES);
+
+	//Every rewrite erases one block, which the allocator spreads evenly; the blocks never used are dirty and
+	//given the highest count at mount
+	ulExpect = ucAlloc ? ((uiRewrites + FLASHBENCH_DEVICE->ucBlockNum - 1UL) / FLASHBENCH_DEVICE->ucBlockNum) : uiRewrites;
+	if(	(tWear.ulMax != ulExpect)
+		|| (ucAlloc && ((tWear.ulTotal != uiRewrites) || ((tWear.ulMax - tWear.ulMin) > 1))))
+	{
+		printf("  %lu erases in total, %lu .. %lu per block\n", (unsigned long)tWear.ulTotal,
+				(unsigned long)tWear.ulMin, (unsigned long)tWear.ulMax);
+		s_ulErrors++;
+	}
+}
+#endif
+
+#ifdef __FLASHTABLE_H__
+/**
+* @brief	This function measures variant table lookups in place, all the keys and as many keys not in the table,
+*			against the copy and linear scan of the table for every lookup, and checks that a table view ended by
+*			a write is renewed by the next lookup. The lookups only read the memory mapped data flash, so they are
+*			timed on the host over FLASHBENCH_TBL_ROUNDS rounds.
+* @param	uiCount, entries of the table
+* @param	ucKind, FLASHTBL_KIND_xxx
+* @return	none
+*/
+static void FlashBench_Table(uint16_t uiCount, uint8_t ucKind)
+{
+	static uint32_t s_aulKeys[FLASHSIM_MAX_SIZE / 4];
+	static uint8_t s_aucValues[FLASHSIM_MAX_SIZE];
+	FlashTbl_Table tTable;
+	const uint8_t *pucValue;
+	uint64_t ullNs;
+	uint32_t ulSize;
+	uint32_t ulKey;
+	uint32_t ulFound = 0;
+	uint8_t ucReturn;
+	uint16_t uiMisses = 0;
+	uint16_t i;
+	uint16_t j;
+	uint16_t k;
+
+	for(i = 0; i < uiCount; i++)
+	{
+		s_aulKeys[i] = FLASHBENCH_TBL_KEY(i);
+		for(j = 0; j < FLASHBENCH_TBL_VALUE; j++)
+		{
+			s_aucValues[(i * FLASHBENCH_TBL_VALUE) + j] = (uint8_t)(s_aulKeys[i] >> (j & 3)) ^ (uint8_t)j;
+		}
+	}
+	ulSize = FlashTblGen_Build(ucKind, s_aulKeys, s_aucValues, uiCount, FLASHBENCH_TBL_VALUE, s_aucPattern,
+								FLASHBENCH_AREA);
+	if(ulSize == 0)
+	{
+		printf("  table build failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	FlashBench_EraseAll();
+	if(FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase, (uint16_t)ulSize) != 0)
+	{
+		printf("  table write failed\n");
+		s_ulErrors++;
+		return;
+	}
+
+	ullNs = FlashBench_HostNs();
+	ucReturn = FlashTbl_Open(FLASHBENCH_DEVICE->ulReadBase, &tTable);
+	FlashBench_ReportHost("table open", ulSize, 1, FlashBench_HostNs() - ullNs, "opens/s");
+	if(ucReturn != 0)
+	{
+		printf("  table open failed (%02X)\n", ucReturn);
+		s_ulErrors++;
+		return;
+	}
+
+	//Check pass, then the timed rounds
+	for(i = 0; i < (2U * uiCount); i++)
+	{
+		//Keys not in the table are even
+		ulKey = (i < uiCount) ? s_aulKeys[i] : (FLASHBENCH_TBL_KEY(i - uiCount) + 1U);
+		ucReturn = FlashTbl_Find(&tTable, ulKey, &pucValue);
+		if(i >= uiCount)
+		{
+			uiMisses = (uint16_t)(uiMisses + (ucReturn == ERR_FLASHTBL_NOTFOUND));
+		}
+		else if((ucReturn != 0) || (memcmp(pucValue, &s_aucValues[i * FLASHBENCH_TBL_VALUE], FLASHBENCH_TBL_VALUE) != 0))
+		{
+			printf("  table key 0x%08lX mismatch\n", (unsigned long)ulKey);
+			s_ulErrors++;
+			break;
+		}
+		else
+		{
+			// Empty
+		}
+	}
+	if(uiMisses != uiCount)
+	{
+		printf("  %u keys not in the table found\n", (unsigned)(uiCount - uiMisses));
+		s_ulErrors++;
+	}
+
+	ullNs = FlashBench_HostNs();
+	for(j = 0; j < FLASHBENCH_TBL_ROUNDS; j++)
+	{
+		for(i = 0; i < (2U * uiCount); i++)
+		{
+			ulKey = (i < uiCount) ? s_aulKeys[i] : (FLASHBENCH_TBL_KEY(i - uiCount) + 1U);
+			ulFound += (FlashTbl_Find(&tTable, ulKey, &pucValue) == 0);
+		}
+	}
+	FlashBench_ReportHost((ucKind == FLASHTBL_KIND_HASH) ? "table hash" : "table sorted", FLASHBENCH_TBL_VALUE,
+							2UL * uiCount * FLASHBENCH_TBL_ROUNDS, FlashBench_HostNs() - ullNs, "lookups/s");
+
+	//What the variant modules did: copy the table to RAM and scan it, for every lookup
+	if(ucKind == FLASHTBL_KIND_SORTED)
+	{
+		ullNs = FlashBench_HostNs();
+		for(k = 0; k < FLASHBENCH_TBL_ROUNDS; k++)
+		{
+			for(i = 0; i < uiCount; i++)
+			{
+				(void)FlashMan_ReadDF(s_aucReadBuf, FLASHBENCH_DEVICE->ulReadBase, (uint16_t)ulSize);
+				for(j = 0; j < uiCount; j++)
+				{
+					const volatile uint8_t *pucKey = &s_aucReadBuf[FLASHTBL_HDR_SIZE + (4U * j)];
+
+					if(	((uint32_t)pucKey[0] | ((uint32_t)pucKey[1] << 8) | ((uint32_t)pucKey[2] << 16)
+						| ((uint32_t)pucKey[3] << 24)) == s_aulKeys[i])
+					{
+						break;
+					}
+				}
+				if(j == uiCount)
+				{
+					printf("  table scan missed key 0x%08lX\n", (unsigned long)s_aulKeys[i]);
+					s_ulErrors++;
+					break;
+				}
+			}
+		}
+		FlashBench_ReportHost("table scan", ulSize, (uint32_t)uiCount * FLASHBENCH_TBL_ROUNDS,
+								FlashBench_HostNs() - ullNs, "lookups/s");
+	}
+	printf("%-14s %6s %6s %u entries in %lu bytes, no RAM copy (the scan copies %lu bytes per lookup)\n", "", "", "",
+			(unsigned)uiCount, (unsigned long)ulSize, (unsigned long)ulSize);
+	if(ulFound != ((uint32_t)uiCount * FLASHBENCH_TBL_ROUNDS))
+	{
+		printf("  table lookups found %lu keys\n", (unsigned long)ulFound);
+		s_ulErrors++;
+	}
+
+	//A write elsewhere ends the view, the next lookup renews it
+	(void)FlashMan_WriteDF(s_aucPattern, FLASHBENCH_DEVICE->ulWriteBase + FLASHBENCH_AREA - 1, 1);
+	if((FlashTbl_Find(&tTable, s_aulKeys[0], &pucValue) != 0) || !FlashMan_IsViewValid(&tTable.tView))
+	{
+		printf("  table lookup after a write failed\n");
+		s_ulErrors++;
+	}
+
+	//No table at all
+	if(FlashTbl_Open(FLASHBENCH_DEVICE->ulReadBase + FLASHBENCH_DEVICE->uiBlockSize, &tTable) != ERR_FLASHTBL_FORMAT)
+	{
+		printf("  table found in an erased block\n");
+		s_ulErrors++;
+	}
+}
+#endif
+
+#ifdef __FLASHCODEC_H__
+/**
+* @brief	This function loads the parameter image from a file, or builds the sample one: a header, a table of
+*			channel settings that mostly repeat, a calibration curve, a reserved (zero) area and unused 0xFF fill
+* @param	pcFile, captured image, 0 for the sample
+* @return	image size, 0 if the file cannot be read
+*/
+static uint16_t FlashBench_Image(const char *pcFile)
+{
+	FILE *ptFile;
+	uint16_t uiSize;
+	uint16_t i;
+
+	if(pcFile != 0)
+	{
+		ptFile = fopen(pcFile, "rb");
+		if(ptFile == 0)
+		{
+			return 0;
+		}
+		uiSize = (uint16_t)fread(s_aucImage, 1, FLASHBENCH_IMG_MAX, ptFile);
+		fclose(ptFile);
+		return uiSize;
+	}
+
+	memset(s_aucImage, 0, FLASHBENCH_IMG_SIZE);
+	memcpy(s_aucImage, "PSET", 4);
+	s_aucImage[4] = 3;										//Version
+	for(i = 0; i < 32; i++)									//Channels 64 .. 319
+	{
+		s_aucImage[64 + (i * 8) + 0] = (uint8_t)(i < 24);	//Enabled
+		s_aucImage[64 + (i * 8) + 2] = 0x00;				//Gain 0x0100
+		s_aucImage[64 + (i * 8) + 3] = 0x01;
+		s_aucImage[64 + (i * 8) + 6] = 0xE8;				//Limit 1000
+		s_aucImage[64 + (i * 8) + 7] = 0x03;
+	}
+	for(i = 0; i < 128; i++)								//Calibration 320 .. 575
+	{
+		s_aucImage[320 + (i * 2)] = (uint8_t)((i * i) >> 3);
+		s_aucImage[321 + (i * 2)] = (uint8_t)((i * i) >> 11);
+	}
+	memset(&s_aucImage[832], 0xFF, FLASHBENCH_IMG_SIZE - 832);
+	memcpy(&s_aucImage[832], "HOB-4Z", 6);
+
+	return FLASHBENCH_IMG_SIZE;
+}
+
+/**
+* @brief	This function saves the parameter image as records of FLASHBENCH_IMG_REC bytes, each one programmed
+*			as [len][data], raw or packed by FlashCodec_Pack when that makes it smaller, and reads it back. The
+*			time taken by FlashCodec_Pack itself is not modeled.
+* @param	uiSize, image size
+* @param	ucPack, 1 to pack the records
+* @return	none
+*/
+static void FlashBench_Codec(uint16_t uiSize, uint8_t ucPack)
+{
+	FlashBench_Run tRun;
+	uint8_t aucRec[1 + FLASHBENCH_IMG_REC];
+	uint8_t aucValue[FLASHBENCH_IMG_REC];
+	uint32_t ulOffset = 0;
+	uint32_t ulCalls = 0;
+	uint16_t uiImg;
+	uint16_t uiLen;
+	uint16_t uiRec;
+
+	FlashBench_EraseAll();
+
+	FlashBench_Start(&tRun);
+	for(uiImg = 0; uiImg < uiSize; uiImg = (uint16_t)(uiImg + uiRec))
+	{
+		uiRec = (uint16_t)(((uiSize - uiImg) < FLASHBENCH_IMG_REC) ? (uiSize - uiImg) : FLASHBENCH_IMG_REC);
+		uiLen = 0;
+		if(ucPack && (uiRec >= FLASHCODEC_RUN_MIN))
+		{
+			uiLen = FlashCodec_Pack(&s_aucImage[uiImg], uiRec, &aucRec[1], (uint16_t)(uiRec - 1));
+		}
+		if(uiLen != 0)
+		{
+			aucRec[0] = (uint8_t)(uiLen | FLASHBENCH_IMG_PACKED);
+		}
+		else
+		{
+			uiLen = uiRec;
+			aucRec[0] = (uint8_t)uiRec;
+			memcpy(&aucRec[1], &s_aucImage[uiImg], uiRec);
+		}
+		if(FlashMan_WriteDF(aucRec, FLASHBENCH_DEVICE->ulWriteBase + ulOffset, (uint16_t)(uiLen + 1)) != 0)
+		{
+			printf("  image save failed\n");
+			s_ulErrors++;
+			return;
+		}
+		ulOffset += uiLen + 1U;
+		ulCalls++;
+	}
+	FlashBench_Report(&tRun, ucPack ? "save packed" : "save raw", FLASHBENCH_IMG_REC, ulCalls, uiSize, "bytes/s");
+	printf("%-14s %6s %6s %lu bytes programmed for a %u byte image (%.1f %%), %.1f us per save\n", "", "", "",
+			(unsigned long)ulOffset, (unsigned)uiSize, 100.0 * (double)ulOffset / uiSize,
+			(double)(FlashSim_Now() - tRun.ullStartNs) / 1e3);
+
+	//Read back
+	ulOffset = 0;
+	for(uiImg = 0; uiImg < uiSize; uiImg = (uint16_t)(uiImg + uiRec))
+	{
+		uiRec = (uint16_t)(((uiSize - uiImg) < FLASHBENCH_IMG_REC) ? (uiSize - uiImg) : FLASHBENCH_IMG_REC);
+		(void)FlashMan_ReadDF(aucRec, FLASHBENCH_DEVICE->ulReadBase + ulOffset, 1);
+		uiLen = (uint16_t)(aucRec[0] & ~FLASHBENCH_IMG_PACKED);
+		(void)FlashMan_ReadDF(&aucRec[1], FLASHBENCH_DEVICE->ulReadBase + ulOffset + 1, uiLen);
+		if((aucRec[0] & FLASHBENCH_IMG_PACKED) != 0)
+		{
+			if(FlashCodec_Unpack(&aucRec[1], uiLen, aucValue, FLASHBENCH_IMG_REC) != uiRec)
+			{
+				memset(aucValue, ~s_aucImage[uiImg], sizeof(aucValue));
+			}
+		}
+		else
+		{
+			memcpy(aucValue, &aucRec[1], uiLen);
+		}
+		if(memcmp(aucValue, &s_aucImage[uiImg], uiRec) != 0)
+		{
+			printf("  image mismatch in the record at 0x%04X\n", (unsigned)uiImg);
+			s_ulErrors++;
+			break;
+		}
+		ulOffset += uiLen + 1U;
+	}
+}
+#endif
+
+#ifndef FLASHMAN_NO_STATS
+/**
+* @brief	This function prints the driver statistics of the benchmark so far and checks its counters against the
+*			ones of the model, which must not have been cleared
+* @param	none
+* @return	none
+*/
+static void FlashBench_Stats(void)
+{
+	static const char * const apcOps[FLASHMAN_STATS_OPS] = { "read", "write", "erase", "blank check", "diff write" };
+	const FlashSim_Stats *ptSim = FlashSim_GetStats();
+	FlashMan_Stats tStats;
+	uint8_t i;
+
+	FlashMan_GetStats(&tStats);
+
+	printf("\n%-14s %8s %8s %10s %12s %12s %12s\n", "driver stats", "calls", "errors", "polls/call",
+			"min cycles", "avg cycles", "max cycles");
+	for(i = 0; i < FLASHMAN_STATS_OPS; i++)
+	{
+		const FlashMan_OpStats *ptOp = &tStats.atOp[i];
+
+		if(ptOp->ulCalls == 0)
+		{
+			continue;
+		}
+		printf("%-14s %8lu %8lu %10.1f %12lu %12.0f %12lu\n", apcOps[i], (unsigned long)ptOp->ulCalls,
+				(unsigned long)ptOp->ulErrors, (double)ptOp->ulFrdyPolls / ptOp->ulCalls,
+				(unsigned long)ptOp->ulCyclesMin, (double)ptOp->ullCyclesTotal / ptOp->ulCalls,
+				(unsigned long)ptOp->ulCyclesMax);
+	}
+	printf("%lu bytes programmed, %lu blocks erased, %lu blank checks, %lu/%lu P/E/read mode entries, "
+			"%lu error resets, longest FlashMan_Poll %lu cycles\n",
+			(unsigned long)tStats.ulBytesProgrammed, (unsigned long)tStats.ulBlocksErased,
+			(unsigned long)tStats.ulBlankChecks, (unsigned long)tStats.ulToPEMode, (unsigned long)tStats.ulToReadMode,
+			(unsigned long)tStats.ulErrorResets, (unsigned long)tStats.ulPollCyclesMax);
+
+	//The driver counts the same commands and transitions the model executed
+	if((tStats.ulBytesProgrammed != (ptSim->ulProgramCmds * FLASHMAN_PROGRAM_UNIT))
+		|| (tStats.ulBlocksErased != ptSim->ulBlocksErased)
+		|| (tStats.ulBlankChecks != ptSim->ulBlankCheckCmds)
+		|| (tStats.ulToPEMode != ptSim->ulToPEMode)
+		|| (tStats.ulToReadMode != ptSim->ulToReadMode)
+		|| (tStats.ulErrorResets > ptSim->ulSeqResets))	//Not blank results are reset too
+	{
+		printf("  driver statistics differ from the model\n");
+		s_ulErrors++;
+	}
+}
+#endif
+
+#ifdef __FLASHEEPROM_H__
+/**
+* @brief	This function is the cut hook of FlashBench_PowerCut: back to the test, as a reset would
+* @param	none
+* @return	none
+*/
+static void FlashBench_CutHook(void)
+{
+	longjmp(s_tCutJump, 1);
+}
+
+/**
+* @brief	This function updates random keys until the power is cut
+* @param	uiCut, number of the cut
+* @return	none
+*/
+static void FlashBench_CutUpdates(uint16_t uiCut)
+{
+	if(setjmp(s_tCutJump) != 0)
+	{
+		return;
+	}
+
+	for(;;)
+	{
+		s_ulCutSeed = (s_ulCutSeed * 1103515245UL) + 12345UL;
+		s_uiCutKey = (uint16_t)((s_ulCutSeed >> 16) % FLASHEEP_MAX_KEYS);
+		memcpy(s_aucCutValue, &s_aucPattern[(s_ulCutSeed >> 4) & 0x3FF], FLASHBENCH_EEP_DATA);
+		if(FlashEep_Write(s_uiCutKey, s_aucCutValue, FLASHBENCH_EEP_DATA) != 0)
+		{
+			printf("  EEPROM write failed before cut %u\n", (unsigned)uiCut);
+			s_ulErrors++;
+			FlashSim_SetPowerCut(0, 0, 0, 0);
+			return;
+		}
+		memcpy(s_aucCutShadow[s_uiCutKey], s_aucCutValue, FLASHBENCH_EEP_DATA);
+	}
+}
+
+/**
+* @brief	This function compares two recovery times, for qsort
+* @param	pvA, time
+* @param	pvB, time
+* @return	<0, 0, >0
+*/
+static int FlashBench_CompareUs(const void *pvA, const void *pvB)
+{
+	uint32_t ulA = *(const uint32_t *)pvA;
+	uint32_t ulB = *(const uint32_t *)pvB;
+
+	return (ulA > ulB) - (ulA < ulB);
+}
+
+/**
+* @brief	This function cuts the power at random sequencer steps of EEPROM updates. After every cut the startup
+*			runs again (FlashManInit, FlashEep_Mount and the first read, which builds the key index) and every key
+*			is checked: it holds its last value, but the key being written, which may hold its previous one.
+*			The time and the flash operations of each recovery are kept for their distribution.
+* @param	uiCuts, number of cuts, up to FLASHBENCH_CUTS
+* @return	none
+*/
+static void FlashBench_PowerCut(uint16_t uiCuts)
+{
+	static uint32_t s_aulUs[FLASHBENCH_CUTS];
+	FlashSim_Stats tStart;
+	const FlashSim_Stats *ptNow;
+	uint8_t aucValue[FLASHBENCH_EEP_DATA];
+	uint64_t ullStartNs;
+	uint32_t ulErases = 0;
+	uint32_t ulErasesMax = 0;
+	uint32_t ulPrograms = 0;
+	uint32_t ulProgramsMax = 0;
+	uint32_t ulOld = 0;
+	uint32_t ulFailed = 0;
+	uint32_t ulCount;
+	uint16_t uiCut;
+	uint16_t uiKey;
+	uint8_t ucReturn;
+
+	uiCuts = (uiCuts > FLASHBENCH_CUTS) ? FLASHBENCH_CUTS : uiCuts;
+	FlashBench_EraseAll();
+	if(FlashEep_Format() != 0)
+	{
+		printf("  EEPROM format failed\n");
+		s_ulErrors++;
+		return;
+	}
+	memset(s_aucCutShadow, 0, sizeof(s_aucCutShadow));
+	for(uiKey = 0; uiKey < FLASHEEP_MAX_KEYS; uiKey++)
+	{
+		(void)FlashEep_Write(uiKey, s_aucCutShadow[uiKey], FLASHBENCH_EEP_DATA);
+	}
+	s_uiCutKey = 0;
+	s_ulCutSeed = 2024;
+
+	for(uiCut = 0; uiCut < uiCuts; uiCut++)
+	{
+		s_ulCutSeed = (s_ulCutSeed * 1103515245UL) + 12345UL;
+		//One cut in four during an erase, they are rare among the commands
+		if((uiCut & 0x03) == 0)
+		{
+			FlashSim_SetPowerCut(FLASHSIM_CMD_ERASE, 1 + ((s_ulCutSeed >> 8) % 2), s_ulCutSeed, FlashBench_CutHook);
+		}
+		else
+		{
+			FlashSim_SetPowerCut(0, 1 + ((s_ulCutSeed >> 8) % FLASHBENCH_CUT_CMDS), s_ulCutSeed, FlashBench_CutHook);
+		}
+		FlashBench_CutUpdates(uiCut);
+
+		//Startup
+		tStart = *FlashSim_GetStats();
+		ullStartNs = FlashSim_Now();
+		FlashSim_PowerOn();
+		FlashManInit();
+		ucReturn = FlashEep_Mount();
+		if(ucReturn == 0)
+		{
+			ucReturn = FlashEep_Read(0, aucValue, FLASHBENCH_EEP_DATA);
+		}
+		ptNow = FlashSim_GetStats();
+		s_aulUs[uiCut] = (uint32_t)((FlashSim_Now() - ullStartNs) / 1000U);
+		ulCount = ptNow->ulBlocksErased - tStart.ulBlocksErased;
+		ulErases += ulCount;
+		ulErasesMax = (ulCount > ulErasesMax) ? ulCount : ulErasesMax;
+		ulCount = ptNow->ulProgramCmds - tStart.ulProgramCmds;
+		ulPrograms += ulCount;
+		ulProgramsMax = (ulCount > ulProgramsMax) ? ulCount : ulProgramsMax;
+		s_ulErrors += (ptNow->ulIllegalCmds - tStart.ulIllegalCmds) + (ptNow->ulProtectErrors - tStart.ulProtectErrors)
+					+ (ptNow->ulReadViolations - tStart.ulReadViolations)
+					+ (ptNow->ulTimingViolations - tStart.ulTimingViolations)
+					+ (ptNow->ulOverwrites - tStart.ulOverwrites);
+
+		for(uiKey = 0; (uiKey < FLASHEEP_MAX_KEYS) && (ucReturn == 0); uiKey++)
+		{
+			ucReturn = FlashEep_Read(uiKey, aucValue, FLASHBENCH_EEP_DATA);
+			if(memcmp(aucValue, s_aucCutShadow[uiKey], FLASHBENCH_EEP_DATA) == 0)
+			{
+				ulOld += (uiKey == s_uiCutKey) ? 1U : 0U;
+			}
+			else if((uiKey != s_uiCutKey) || (memcmp(aucValue, s_aucCutValue, FLASHBENCH_EEP_DATA) != 0))
+			{
+				ucReturn = FLASHBENCH_CUT_MISMATCH;
+			}
+			else
+			{
+				memcpy(s_aucCutShadow[uiKey], aucValue, FLASHBENCH_EEP_DATA);
+			}
+		}
+		if(ucReturn != 0)
+		{
+			if(ulFailed < 4)
+			{
+				printf("  cut %u not recovered: key %u (0x%02X)\n", (unsigned)uiCut, (unsigned)(uiKey - 1U), ucReturn);
+			}
+			ulFailed++;
+			s_ulErrors++;
+
+			//Start again from a clean EEPROM
+			(void)FlashEep_Format();
+			for(uiKey = 0; uiKey < FLASHEEP_MAX_KEYS; uiKey++)
+			{
+				(void)FlashEep_Write(uiKey, s_aucCutShadow[uiKey], FLASHBENCH_EEP_DATA);
+			}
+		}
+	}
+	FlashSim_SetPowerCut(0, 0, 0, 0);
+
+	if(uiCuts == 0)
+	{
+		return;
+	}
+	qsort(s_aulUs, uiCuts, sizeof(s_aulUs[0]), FlashBench_CompareUs);
+	ptNow = FlashSim_GetStats();
+	printf("%-14s %6s %6u %lu in program, %lu in erase, %lu not recovered, %lu updates kept the old value\n",
+			"power cut", "", (unsigned)uiCuts, (unsigned long)ptNow->ulCutsInProgram,
+			(unsigned long)ptNow->ulCutsInErase, (unsigned long)ulFailed, (unsigned long)ulOld);
+	printf("%-14s %6s %6s recovery us min %lu, 50%% %lu, 90%% %lu, 99%% %lu, max %lu\n", "", "", "",
+			(unsigned long)s_aulUs[0], (unsigned long)s_aulUs[uiCuts / 2], (unsigned long)s_aulUs[(uiCuts * 9U) / 10U],
+			(unsigned long)s_aulUs[(uiCuts * 99U) / 100U], (unsigned long)s_aulUs[uiCuts - 1]);
+	printf("%-14s %6s %6s recovery blocks erased %.2f (max %lu), bytes programmed %.2f (max %lu)\n", "", "", "",
+			(double)ulErases / uiCuts, (unsigned long)ulErasesMax, (double)ulPrograms / uiCuts,
+			(unsigned long)ulProgramsMax);
+}
+#endif
+
+#ifdef FLASHMAN_TRACE
+/**
+* @brief	This function saves the trace ring as the target would dump it
+* @param	pcFile, dump file
+* @return	none
+*/
+static void FlashBench_Trace(const char *pcFile)
+{
+	const FlashMan_Trace *ptTrace = FlashMan_GetTrace();
+	FILE *pfDump = fopen(pcFile, "wb");
+
+	if((pfDump == NULL) || (fwrite(ptTrace, sizeof(*ptTrace), 1, pfDump) != 1) || (ptTrace->ulCount == 0))
+	{
+		printf("  trace not saved\n");
+		s_ulErrors++;
+	}
+	else
+	{
+		printf("%lu trace events, last %u saved to %s\n", (unsigned long)ptTrace->ulCount,
+				(unsigned)((ptTrace->ulCount < ptTrace->uiSize) ? ptTrace->ulCount : ptTrace->uiSize), pcFile);
+	}
+	if(pfDump != NULL)
+	{
+		fclose(pfDump);
+	}
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	static const uint16_t auiSizes[] = { 1, 16, 64, 256, 1024 };
+	uint32_t i;
+#ifdef __FLASHCODEC_H__
+	uint16_t uiImage;
+#endif
+
+	for(i = 0; i < sizeof(s_aucPattern); i++)
+	{
+		s_aucPattern[i] = (uint8_t)((i * 7) ^ (i >> 8));
+	}
+
+	FlashSim_Init(FLASHBENCH_DEVICE);
+#ifdef FLASHMAN_USE_FRDYI
+	FlashSim_SetFrdyIsr(FlashBench_FrdyIsr);
+#endif
+	FlashManInit();
+#ifdef FLASHMAN_CLOCK_RUNTIME
+	//ICLK of the model from the cost of a delay loop iteration (4 cycles)
+	(void)FlashMan_SetClockDF(4000000000UL / FLASHBENCH_DEVICE->ulDelayLoopNs,
+								(uint32_t)FLASHBENCH_DEVICE->ucFclkMHz * 1000000UL);
+#endif
+
+	printf("FlashManager benchmark on the %s model (FCLK %u MHz)\n", FLASHBENCH_DEVICE->pcName,
+			(unsigned)FLASHBENCH_DEVICE->ucFclkMHz);
+	printf("%-14s %6s %6s %21s %10s %12s %8s %10s %8s %8s\n", "operation", "size", "calls", "throughput",
+			"us/call", "ovh us/call", "modes", "polls", "illegal", "viol");
+
+	FlashBench_Erase(0);
+	FlashBench_Erase(1);
+	FlashBench_EraseRange(0xFFFFFFFFUL, "range all");
+	FlashBench_EraseRange(0x55555555UL, "range 1 of 2");
+	FlashBench_EraseRange(0, "range blank");
+#ifdef FLASHMAN_TRANS_NO_FAIL
+	FlashBench_Transaction(64, 1);
+	FlashBench_Transaction(64, 16);
+#endif
+#ifdef FLASHMAN_ASYNC_BUSY
+	FlashBench_Async(0);
+	FlashBench_Async(16);
+#endif
+#ifdef FLASHMAN_USE_FRDYI
+	FlashBench_Interrupt(64);
+#endif
+#ifndef FLASHMAN_USE_FRDYI
+	FlashBench_Budget(1024, 100, 0);
+	FlashBench_Budget(1024, 0, 16);
+	FlashBench_Budget(1024, 0x10000000UL, 0);		//2^28 us, a multiple of 2^32 cycles at 32 and 48 MHz
+#endif
+	//The last write leaves the whole pattern in flash for the reads
+	for(i = 0; i < (sizeof(auiSizes) / sizeof(auiSizes[0])); i++)
+	{
+		FlashBench_Write(auiSizes[i]);
+	}
+	for(i = 0; i < (sizeof(auiSizes) / sizeof(auiSizes[0])); i++)
+	{
+		FlashBench_Read(auiSizes[i]);
+	}
+	FlashBench_View();
+	FlashBench_Frontier(0);
+	FlashBench_Frontier(333);
+	FlashBench_Frontier(1024);
+#ifdef FLASHMAN_DIFF_MAX_SIZE
+	FlashBench_Diff();
+#endif
+#ifdef FLASHMAN_CRC
+	FlashBench_Digest(16, 32);
+#endif
+#ifdef FLASHMAN_STAGE
+	FlashBench_Stage();
+#endif
+#ifndef FLASHMAN_NO_STATS
+	FlashBench_Stats();
+#endif
+#ifdef __FLASHEEPROM_H__
+	FlashBench_Eeprom(2000);
+	FlashBench_EndOfLine(FLASHEEP_MAX_KEYS);
+#endif
+#ifdef __FLASHCACHE_H__
+	FlashBench_Cache(2000);
+	FlashBench_CacheCut(500);
+#endif
+#ifdef __FLASHQUEUE_H__
+	FlashBench_Queue(64);
+#endif
+#ifdef __FLASHCOUNTER_H__
+	FlashBench_Counter(3000);
+#endif
+#ifdef __FLASHJOURNAL_H__
+	FlashBench_Journal(1000);
+#endif
+#ifdef __FLASHBLOCK_H__
+	FlashBench_Wear(400, 0);
+	FlashBench_Wear(400, 1);
+#endif
+#ifdef __FLASHTABLE_H__
+	FlashBench_Table(400, FLASHTBL_KIND_SORTED);
+	FlashBench_Table(400, FLASHTBL_KIND_HASH);
+#endif
+#ifdef __FLASHCODEC_H__
+	uiImage = FlashBench_Image((argc > 1) ? argv[1] : 0);
+	if(uiImage == 0)
+	{
+		printf("  no parameter image\n");
+		s_ulErrors++;
+	}
+	else
+	{
+		FlashBench_Codec(uiImage, 0);
+		FlashBench_Codec(uiImage, 1);
+	}
+#endif
+#ifdef __FLASHEEPROM_H__
+	FlashBench_ErasedValue(0x00, 1000);
+	FlashBench_ErasedValue(0x3C, 1000);
+	FlashBench_PowerCut(FLASHBENCH_CUTS);
+#endif
+#ifdef FLASHMAN_TRACE
+	FlashBench_Trace("flashbench.trace");
+#endif
+
+	printf("%lu errors\n", (unsigned long)s_ulErrors);
+
+	return (s_ulErrors != 0) ? 1 : 0;
+}
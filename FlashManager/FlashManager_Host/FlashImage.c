@@ -0,0 +1,243 @@
+/**
+* @brief Builder of the data flash image programmed at the end of line by FlashMan_ProgramImageDF. The default
+* parameters are written by the Flash EEPROM module itself, built for the host and running on the FlashSim model,
+* so the block headers, the records and their sums are the ones the firmware writes. The parameter file has one
+* value per line:
+*	key value_byte value_byte ...
+* numbers in C notation (e.g. 0x1A or 42), '#' up to the end of the line is a comment. The image file holds
+* FLASHMAN_AREA_SIZE bytes of data followed by the FLASHMAN_AREA_SIZE / 8 bytes of the program bitmap, as in
+* FlashMan_Image.
+*
+* Build from the project root, e.g. for the eSTB (RX140) driver:
+*	cc -DFLASHMAN_HOST -IDrivers/FlashManager/FlashManager_Host -IDrivers/FlashManager/FlashManager_eSTB/FlashManager
+*	   Drivers/FlashManager/FlashManager_Host/FlashSim.c Drivers/FlashManager/FlashManager_Host/FlashImage.c
+*	   Drivers/FlashManager/FlashManager_Common/FlashManager/FlashManager.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashBlock.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashEeprom.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashCodec.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashSum.c -o flashimage
+* with the same -D options as the firmware (-DFLASHMAN_TARGET_RX130, -DFLASHEEP_CODEC) and, for Gaya, the include path
+* of FlashManager_Gaya_RX130/FlashManager in front of the eSTB one, and run:
+*	flashimage defaults.txt defaults.img
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FlashSim.h"
+#include "FlashManager.h"
+#include "FlashEeprom.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#ifdef FLASHMAN_TARGET_RX130
+#define FLASHIMAGE_DEVICE	(&g_tFlashSim_RX130)
+#else
+#define FLASHIMAGE_DEVICE	(&g_tFlashSim_RX140)
+#endif
+
+#define FLASHIMAGE_LINE		1024
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static uint8_t s_aucFlashImageData[FLASHMAN_AREA_SIZE];
+static uint8_t s_aucFlashImageProgram[FLASHMAN_AREA_SIZE / 8];
+
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function writes the values of a parameter file through the Flash EEPROM module
+* @param	pcFile, parameter file
+* @return	number of values, -1 on error
+*/
+static int FlashImage_Load(const char *pcFile)
+{
+	char acLine[FLASHIMAGE_LINE];
+	uint8_t aucValue[FLASHEEP_MAX_DATA];
+	unsigned long ulKey;
+	unsigned long ulByte;
+	uint32_t ulLine = 0;
+	uint8_t ucSize;
+	uint8_t ucReturn;
+	int iValues = 0;
+	char *pcPos;
+	char *pcEnd;
+	FILE *pfIn;
+
+	pfIn = fopen(pcFile, "r");
+	if(pfIn == 0)
+	{
+		fprintf(stderr, "cannot open %s\n", pcFile);
+		return -1;
+	}
+	while(fgets(acLine, sizeof(acLine), pfIn) != 0)
+	{
+		ulLine++;
+		pcPos = strchr(acLine, '#');
+		if(pcPos != 0)
+		{
+			*pcPos = '\0';
+		}
+		ulKey = strtoul(acLine, &pcEnd, 0);
+		if(pcEnd == acLine)
+		{
+			if(acLine[strspn(acLine, " \t\r\n")] == '\0')
+			{
+				continue;
+			}
+			ulKey = FLASHEEP_MAX_KEYS;
+		}
+
+		ucSize = 0;
+		for(;;)
+		{
+			pcPos = pcEnd;
+			ulByte = strtoul(pcPos, &pcEnd, 0);
+			if(pcEnd == pcPos)
+			{
+				break;
+			}
+			if((ulByte > 0xFF) || (ucSize == FLASHEEP_MAX_DATA))
+			{
+				ulKey = FLASHEEP_MAX_KEYS;
+				break;
+			}
+			aucValue[ucSize++] = (uint8_t)ulByte;
+		}
+		if((ulKey >= FLASHEEP_MAX_KEYS) || (ucSize == 0) || (pcPos[strspn(pcPos, " \t\r\n")] != '\0'))
+		{
+			fprintf(stderr, "%s:%lu: bad value (keys 0 .. %u, 1 .. %u bytes)\n", pcFile, (unsigned long)ulLine,
+					FLASHEEP_MAX_KEYS - 1, FLASHEEP_MAX_DATA);
+			fclose(pfIn);
+			return -1;
+		}
+
+		ucReturn = FlashEep_Write((uint16_t)ulKey, aucValue, ucSize);
+		if(ucReturn != 0)
+		{
+			fprintf(stderr, "%s:%lu: EEPROM write failed (0x%02X)\n", pcFile, (unsigned long)ulLine, ucReturn);
+			fclose(pfIn);
+			return -1;
+		}
+		iValues++;
+	}
+	fclose(pfIn);
+
+	return iValues;
+}
+
+/**
+* @brief	This function computes the CRC-16/CCITT of the image file, for the station log
+* @param	pucData, bytes
+* @param	ulSize, number of bytes
+* @param	uiCrc, CRC so far
+* @return	CRC
+*/
+static uint16_t FlashImage_Crc(const uint8_t *pucData, uint32_t ulSize, uint16_t uiCrc)
+{
+	uint32_t i;
+	uint8_t b;
+
+	for(i = 0; i < ulSize; i++)
+	{
+		uiCrc ^= (uint16_t)((uint16_t)pucData[i] << 8);
+		for(b = 0; b < 8; b++)
+		{
+			uiCrc = (uint16_t)(((uiCrc & 0x8000U) != 0U) ? ((uint16_t)(uiCrc << 1) ^ 0x1021U) : (uint16_t)(uiCrc << 1));
+		}
+	}
+
+	return uiCrc;
+}
+
+/**
+* @brief	This function formats the data flash of the model, writes the parameters and saves the image
+* @param	argc, number of arguments
+* @param	argv, defaults.txt defaults.img
+* @return	0 if OK, 1 otherwise
+*/
+int main(int argc, char *argv[])
+{
+	uint32_t ulOffset;
+	uint32_t ulProgrammed = 0;
+	uint32_t ulBlocks = 0;
+	int iValues;
+	FILE *pfOut;
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: flashimage defaults.txt defaults.img\n");
+		return 1;
+	}
+
+	FlashSim_Init(FLASHIMAGE_DEVICE);
+	FlashManInit();
+	if(FlashEep_Format() != 0)
+	{
+		fprintf(stderr, "EEPROM format failed\n");
+		return 1;
+	}
+	iValues = FlashImage_Load(argv[1]);
+	if(iValues < 0)
+	{
+		return 1;
+	}
+
+	//The image is what the firmware left in the data flash: erased cells are not programmed
+	for(ulOffset = 0; ulOffset < FLASHMAN_AREA_SIZE; ulOffset++)
+	{
+		if(!FlashSim_IsBlank(ulOffset))
+		{
+			s_aucFlashImageData[ulOffset] = FlashSim_Peek(ulOffset);
+			s_aucFlashImageProgram[ulOffset >> 3] |= (uint8_t)(1U << (ulOffset & 7));
+			ulProgrammed++;
+		}
+		else
+		{
+			s_aucFlashImageData[ulOffset] = 0xFF;
+		}
+	}
+	for(ulOffset = 0; ulOffset < (FLASHMAN_AREA_SIZE / 8); ulOffset += (FLASHMAN_BLOCK_SIZE / 8))
+	{
+		uint32_t i;
+
+		for(i = 0; (i < (FLASHMAN_BLOCK_SIZE / 8)) && (s_aucFlashImageProgram[ulOffset + i] == 0); i++)
+		{
+		}
+		ulBlocks += (i < (FLASHMAN_BLOCK_SIZE / 8)) ? 1U : 0U;
+	}
+
+	pfOut = fopen(argv[2], "wb");
+	if(	(pfOut == 0) || (fwrite(s_aucFlashImageData, 1, sizeof(s_aucFlashImageData), pfOut) != sizeof(s_aucFlashImageData))
+		|| (fwrite(s_aucFlashImageProgram, 1, sizeof(s_aucFlashImageProgram), pfOut) != sizeof(s_aucFlashImageProgram)))
+	{
+		fprintf(stderr, "cannot write %s\n", argv[2]);
+		if(pfOut != 0)
+		{
+			fclose(pfOut);
+		}
+		return 1;
+	}
+	fclose(pfOut);
+
+	printf("%s: %d values, %lu bytes to program in %lu of %u blocks, CRC-16 0x%04X\n", FLASHIMAGE_DEVICE->pcName,
+			iValues, (unsigned long)ulProgrammed, (unsigned long)ulBlocks, FLASHMAN_BLOCK_NUM,
+			FlashImage_Crc(s_aucFlashImageProgram, sizeof(s_aucFlashImageProgram),
+							FlashImage_Crc(s_aucFlashImageData, sizeof(s_aucFlashImageData), 0xFFFF)));
+
+	return 0;
+}
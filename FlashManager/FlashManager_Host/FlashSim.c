@@ -0,0 +1,879 @@
+/**
+* @brief Host model of the RX130/RX140 FLASH sequencer and data flash array.
+*
+* Time only advances through the model: every register access costs ulRegAccessNs, software delay loops
+* cost ulDelayLoopNs per iteration and a command keeps the sequencer busy until the virtual time reaches
+* its completion time. Commands take effect on the array when they complete, which the driver observes
+* by polling FSTATR1.FRDY.
+*
+* A power cut is armed on a command count and placed, when that command starts, at a random time of its execution
+* (one time in eight at its very start). It fires on the first model access at or after that time: the part of the
+* command done by then is applied to the array, and the cut hook is called.
+*
+* The FRDY interrupt is raised when a command ends with FRDYIE set and taken at once unless interrupts are masked
+* (FlashSim_IntSave), in which case it is taken by the FlashSim_IntRestore that unmasks them. The handler runs with
+* interrupts masked, as after the RX interrupt entry.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <string.h>
+
+#include "FlashSim.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHSIM_HCOVF		0x08
+
+//Mode reached by the last register write
+#define FLASHSIM_MODE_OTHER	0
+#define FLASHSIM_MODE_READ	1
+#define FLASHSIM_MODE_PE	2
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+typedef struct
+{
+	FlashSim_Config tCfg;
+	FlashSim_Stats tStats;
+	uint8_t aucArray[FLASHSIM_MAX_SIZE];
+	uint8_t aucBlank[FLASHSIM_MAX_SIZE];
+
+	uint16_t auiReg[FLASHSIM_REG_NUM];
+	uint8_t ucProtectStep;			//Position inside the FPR/FPMCR key sequence
+	uint8_t ucProtectValue;
+	uint8_t ucMode;
+	uint8_t ucFwb;					//Last byte written to FWB0 (RX140) or FWBL (RX130)
+
+	uint64_t ullDfAccessAt;			//DFLEN set + tDSTOP
+	uint64_t ullReadModeAt;			//FPMCR read mode + tMS
+
+	uint8_t ucBusy;
+	uint8_t ucCmd;
+	uint32_t ulOpStart;				//Array offsets of the command in progress
+	uint32_t ulOpEnd;
+	uint8_t ucOpData;
+	uint8_t ucOpError;
+	uint64_t ullOpStartAt;
+	uint64_t ullOpDoneAt;
+
+	uint32_t ulCutCommand;			//Commands to start until the one cut, 0 if no cut is armed
+	uint8_t ucCutCmd;				//FCR.CMD of the commands counted, 0 for all of them
+	uint32_t ulCutRand;				//Random generator of the cut
+	uint64_t ullCutAt;				//Time of the cut, when ucCutArmed
+	uint8_t ucCutArmed;
+	uint8_t ucPowerOff;				//The cut hook returned: nothing runs until FlashSim_PowerOn
+	FlashSim_CutHook pfnCut;
+
+	uint8_t ucIntMasked;			//PSW I flag clear
+	uint8_t ucIntPending;			//FRDY interrupt raised and not taken yet
+} FlashSim_State;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static FlashSim_State s_tSim;
+static FlashSim_Isr s_pfnFlashSimIsr = 0;		//Kept by FlashSim_Init, as an interrupt vector
+
+/***********************************************************************************************************************
+* Declarations of Public Variables
+***********************************************************************************************************************/
+const FlashSim_Config g_tFlashSim_RX140 =
+{
+	"RX140",
+	0x00100000, 0xFE000000, 0x400, 8, 0xFF, 32,
+	50, 83,
+	52000, 6300000, 16000, 250,
+	250, 2000
+};
+
+const FlashSim_Config g_tFlashSim_RX130 =
+{
+	"RX130",
+	0x00100000, 0x000F1000, 0x400, 8, 0xFF, 32,
+	50, 125,
+	52000, 6300000, 16000, 250,
+	250, 2000
+};
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static void FlashSim_Reset(void);
+static void FlashSim_Tick(uint64_t ullNs);
+static void FlashSim_Complete(void);
+static void FlashSim_Interrupt(void);
+static uint8_t FlashSim_Rand(void);
+static void FlashSim_Cut(void);
+static void FlashSim_UpdateMode(void);
+static void FlashSim_StartCmd(uint8_t ucCmd);
+static uint8_t FlashSim_IsPEMode(void);
+static uint32_t FlashSim_ScaledNs(uint32_t ulNs);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function sets the registers and the sequencer to their reset state, the array is not changed
+* @param	none
+* @return	none
+*/
+static void FlashSim_Reset(void)
+{
+	memset(s_tSim.auiReg, 0, sizeof(s_tSim.auiReg));
+	s_tSim.auiReg[FLASHSIM_REG_FPMCR] = FLASHSIM_FPMCR_READMODE;
+	s_tSim.auiReg[FLASHSIM_REG_OSCOVFSR] = FLASHSIM_HCOVF;
+	s_tSim.ucProtectStep = 0;
+	s_tSim.ucMode = FLASHSIM_MODE_READ;
+	s_tSim.ullDfAccessAt = 0;
+	s_tSim.ullReadModeAt = 0;
+	s_tSim.ucBusy = 0;
+
+	s_tSim.ulCutCommand = 0;
+	s_tSim.ucCutArmed = 0;
+	s_tSim.ucPowerOff = 0;
+
+	s_tSim.ucIntMasked = 0;
+	s_tSim.ucIntPending = 0;
+}
+
+/**
+* @brief	This function advances the virtual time and completes the command in progress when it is due
+* @param	ullNs, nanoseconds to advance
+* @return	none
+*/
+static void FlashSim_Tick(uint64_t ullNs)
+{
+	s_tSim.tStats.ullTimeNs += ullNs;
+
+	//The cut time is always before the end of its command
+	if(s_tSim.ucCutArmed && (s_tSim.tStats.ullTimeNs >= s_tSim.ullCutAt))
+	{
+		FlashSim_Cut();
+	}
+	else if(s_tSim.ucBusy && (s_tSim.tStats.ullTimeNs >= s_tSim.ullOpDoneAt))
+	{
+		FlashSim_Complete();
+		FlashSim_Interrupt();
+	}
+}
+
+/**
+* @brief	This function applies the effect of the command in progress on the array and raises FRDY
+* @param	none
+* @return	none
+*/
+static void FlashSim_Complete(void)
+{
+	uint32_t i;
+	uint16_t uiErr = 0;
+
+	switch(s_tSim.ucCmd)
+	{
+		case FLASHSIM_CMD_PROGRAM:
+			if(s_tSim.ucOpError)
+			{
+				uiErr = FLASHSIM_FSTATR0_PRGERR;
+				break;
+			}
+			if(s_tSim.aucBlank[s_tSim.ulOpStart])
+			{
+				s_tSim.aucArray[s_tSim.ulOpStart] = s_tSim.ucOpData;
+				s_tSim.aucBlank[s_tSim.ulOpStart] = 0;
+			}
+			else
+			{
+				//Programming over a written cell: only the bits to zero can be trusted
+				s_tSim.aucArray[s_tSim.ulOpStart] &= s_tSim.ucOpData;
+				s_tSim.tStats.ulOverwrites++;
+			}
+			break;
+
+		case FLASHSIM_CMD_ERASE:
+			if(s_tSim.ucOpError)
+			{
+				uiErr = FLASHSIM_FSTATR0_ERERR;
+				break;
+			}
+			memset(&s_tSim.aucArray[s_tSim.ulOpStart], s_tSim.tCfg.ucErasedValue, s_tSim.ulOpEnd - s_tSim.ulOpStart);
+			memset(&s_tSim.aucBlank[s_tSim.ulOpStart], 1, s_tSim.ulOpEnd - s_tSim.ulOpStart);
+			s_tSim.tStats.ulBlocksErased += (s_tSim.ulOpEnd - s_tSim.ulOpStart) / s_tSim.tCfg.uiBlockSize;
+			for(i = s_tSim.ulOpStart; i < s_tSim.ulOpEnd; i += s_tSim.tCfg.uiBlockSize)
+			{
+				s_tSim.tStats.aulBlockErases[(i / s_tSim.tCfg.uiBlockSize) % FLASHSIM_MAX_BLOCKS]++;
+			}
+			break;
+
+		case FLASHSIM_CMD_BLANKCHECK:
+			for(i = s_tSim.ulOpStart; i < s_tSim.ulOpEnd; i++)
+			{
+				if(!s_tSim.aucBlank[i])
+				{
+					uiErr = FLASHSIM_FSTATR0_BCERR;
+					break;
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	s_tSim.auiReg[FLASHSIM_REG_FSTATR0] |= uiErr;
+	s_tSim.auiReg[FLASHSIM_REG_FSTATR1] |= FLASHSIM_FSTATR1_FRDY;
+	s_tSim.ucBusy = 0;
+	if(s_tSim.auiReg[FLASHSIM_REG_FRDYIE] & 1)
+	{
+		s_tSim.ucIntPending = 1;
+		s_tSim.tStats.ulDeferredInts += s_tSim.ucIntMasked;
+	}
+}
+
+/**
+* @brief	This function takes the FRDY interrupt if it is raised, interrupts are not masked and a handler is set
+* @param	none
+* @return	none
+*/
+static void FlashSim_Interrupt(void)
+{
+	//Raised again while the handler ran: taken again after its return
+	while(s_tSim.ucIntPending && !s_tSim.ucIntMasked && (s_pfnFlashSimIsr != 0) && !s_tSim.ucPowerOff)
+	{
+		s_tSim.ucIntPending = 0;
+		s_tSim.tStats.ulInterrupts++;
+		s_tSim.ucIntMasked = 1;
+		s_pfnFlashSimIsr();
+		s_tSim.ucIntMasked = 0;
+	}
+}
+
+/**
+* @brief	This function draws a random byte for the power cuts
+* @param	none
+* @return	random byte
+*/
+static uint8_t FlashSim_Rand(void)
+{
+	s_tSim.ulCutRand = (s_tSim.ulCutRand * 1103515245UL) + 12345UL;
+
+	return (uint8_t)(s_tSim.ulCutRand >> 16);
+}
+
+/**
+* @brief	This function cuts the power: the part of the command in progress done by now is applied to the array,
+*			then the cut hook is called. A cell being programmed gets each of its bits to program with a probability
+*			that grows with the time programmed, and passes the blank check until half of that time. The blocks
+*			an erase is done with are erased; in the block being erased each cell is erased with a probability that
+*			grows with the time erased, the others get random bits set and fail the blank check.
+* @param	none
+* @return	none
+*/
+static void FlashSim_Cut(void)
+{
+	uint64_t ullDoneNs = s_tSim.tStats.ullTimeNs - s_tSim.ullOpStartAt;
+	uint64_t ullOpNs = s_tSim.ullOpDoneAt - s_tSim.ullOpStartAt;
+	uint32_t ulBlocks;
+	uint32_t ulBlock;
+	uint32_t ulEnd;
+	uint32_t i;
+	uint16_t uiProgress;
+	uint8_t ucBits;
+	uint8_t b;
+
+	s_tSim.ucCutArmed = 0;
+	s_tSim.tStats.ulPowerCuts++;
+
+	if(s_tSim.ucBusy && (s_tSim.ucCmd == FLASHSIM_CMD_PROGRAM) && !s_tSim.ucOpError)
+	{
+		uiProgress = (uint16_t)((ullDoneNs * 256U) / ullOpNs);
+		ucBits = (uint8_t)(s_tSim.aucArray[s_tSim.ulOpStart] & ~s_tSim.ucOpData);
+		for(b = 0x01; b != 0; b = (uint8_t)(b << 1))
+		{
+			if((ucBits & b) && (FlashSim_Rand() < uiProgress))
+			{
+				s_tSim.aucArray[s_tSim.ulOpStart] &= (uint8_t)~b;
+			}
+		}
+		if(uiProgress >= 128)
+		{
+			s_tSim.aucBlank[s_tSim.ulOpStart] = 0;
+		}
+		s_tSim.tStats.ulCutsInProgram++;
+	}
+	else if(s_tSim.ucBusy && (s_tSim.ucCmd == FLASHSIM_CMD_ERASE) && !s_tSim.ucOpError)
+	{
+		//The blocks are erased one after the other
+		ulBlocks = (s_tSim.ulOpEnd - s_tSim.ulOpStart) / s_tSim.tCfg.uiBlockSize;
+		ulBlock = (uint32_t)((ullDoneNs * ulBlocks) / ullOpNs);
+		uiProgress = (uint16_t)((((ullDoneNs * ulBlocks) % ullOpNs) * 256U) / ullOpNs);
+		ulEnd = s_tSim.ulOpStart + (ulBlock * s_tSim.tCfg.uiBlockSize);
+		memset(&s_tSim.aucArray[s_tSim.ulOpStart], s_tSim.tCfg.ucErasedValue, ulEnd - s_tSim.ulOpStart);
+		memset(&s_tSim.aucBlank[s_tSim.ulOpStart], 1, ulEnd - s_tSim.ulOpStart);
+		for(i = s_tSim.ulOpStart; i < ulEnd; i += s_tSim.tCfg.uiBlockSize)
+		{
+			s_tSim.tStats.aulBlockErases[(i / s_tSim.tCfg.uiBlockSize) % FLASHSIM_MAX_BLOCKS]++;
+		}
+		s_tSim.tStats.ulBlocksErased += ulBlock;
+
+		for(i = ulEnd; i < (ulEnd + s_tSim.tCfg.uiBlockSize); i++)
+		{
+			if(FlashSim_Rand() < uiProgress)
+			{
+				s_tSim.aucArray[i] = s_tSim.tCfg.ucErasedValue;
+				s_tSim.aucBlank[i] = 1;
+			}
+			else
+			{
+				s_tSim.aucArray[i] |= FlashSim_Rand();
+				s_tSim.aucBlank[i] = 0;
+			}
+		}
+		s_tSim.tStats.aulBlockErases[(ulEnd / s_tSim.tCfg.uiBlockSize) % FLASHSIM_MAX_BLOCKS]++;
+		s_tSim.tStats.ulCutsInErase++;
+	}
+	else
+	{
+		// Empty
+	}
+
+	s_tSim.ucBusy = 0;
+	s_tSim.ucPowerOff = 1;
+	if(s_tSim.pfnCut != 0)
+	{
+		s_tSim.pfnCut();
+	}
+
+	//The hook returned: the driver gets an error on every command instead of waiting for ever
+	s_tSim.auiReg[FLASHSIM_REG_FSTATR0] = FLASHSIM_FSTATR0_ILGLERR;
+	s_tSim.auiReg[FLASHSIM_REG_FSTATR1] = FLASHSIM_FSTATR1_FRDY;
+}
+
+/**
+* @brief	This function tracks the read mode / P/E mode transitions
+* @param	none
+* @return	none
+*/
+static void FlashSim_UpdateMode(void)
+{
+	uint8_t ucMode = FLASHSIM_MODE_OTHER;
+
+	if(FlashSim_IsPEMode())
+	{
+		ucMode = FLASHSIM_MODE_PE;
+	}
+	else if((s_tSim.auiReg[FLASHSIM_REG_FENTRYR] == 0) && !(s_tSim.auiReg[FLASHSIM_REG_FPMCR] & FLASHSIM_FPMCR_PEMODE))
+	{
+		ucMode = FLASHSIM_MODE_READ;
+	}
+
+	if(ucMode != FLASHSIM_MODE_OTHER && ucMode != s_tSim.ucMode)
+	{
+		if(ucMode == FLASHSIM_MODE_PE)	{ s_tSim.tStats.ulToPEMode++;	}
+		else							{ s_tSim.tStats.ulToReadMode++;	}
+		s_tSim.ucMode = ucMode;
+	}
+}
+
+/**
+* @brief	This function tells whether the data flash is enabled and in P/E mode
+* @param	none
+* @return	1 in P/E mode, 0 otherwise
+*/
+static uint8_t FlashSim_IsPEMode(void)
+{
+	return (uint8_t)(s_tSim.auiReg[FLASHSIM_REG_DFLCTL]
+			&& (s_tSim.auiReg[FLASHSIM_REG_FENTRYR] == FLASHSIM_FENTRYR_FENTRYD)
+			&& (s_tSim.auiReg[FLASHSIM_REG_FPMCR] == FLASHSIM_FPMCR_PEMODE));
+}
+
+/**
+* @brief	This function scales a sequencer time with the FISR.PCKA setting. A PCKA above FCLK - 1 makes the
+*			sequencer wait longer than needed, a PCKA below it is reported as a program/erase error.
+* @param	ulNs, sequencer time with the right PCKA
+* @return	sequencer time with the current PCKA
+*/
+static uint32_t FlashSim_ScaledNs(uint32_t ulNs)
+{
+	uint32_t ulPcka = (uint32_t)s_tSim.auiReg[FLASHSIM_REG_FISR] + 1;
+
+	if(ulPcka <= s_tSim.tCfg.ucFclkMHz)
+	{
+		return ulNs;
+	}
+	return (uint32_t)(((uint64_t)ulNs * ulPcka) / s_tSim.tCfg.ucFclkMHz);
+}
+
+/**
+* @brief	This function starts a sequencer command
+* @param	ucCmd, FCR.CMD value
+* @return	none
+*/
+static void FlashSim_StartCmd(uint8_t ucCmd)
+{
+	uint32_t ulSize = (uint32_t)s_tSim.tCfg.uiBlockSize * s_tSim.tCfg.ucBlockNum;
+	uint32_t ulStart = (((uint32_t)s_tSim.auiReg[FLASHSIM_REG_FSARH] << 16) | s_tSim.auiReg[FLASHSIM_REG_FSARL]) - s_tSim.tCfg.ulWriteBase;
+	uint32_t ulEnd = (((uint32_t)s_tSim.auiReg[FLASHSIM_REG_FEARH] << 16) | s_tSim.auiReg[FLASHSIM_REG_FEARL]) - s_tSim.tCfg.ulWriteBase;
+	uint32_t ulNs = 0;
+
+	//A latched ILGLERR blocks the sequencer until FRESETR
+	if(	s_tSim.ucBusy || !FlashSim_IsPEMode() || (s_tSim.tStats.ullTimeNs < s_tSim.ullDfAccessAt)
+		|| (s_tSim.auiReg[FLASHSIM_REG_FSTATR0] & FLASHSIM_FSTATR0_ILGLERR) || (ulStart >= ulSize))
+	{
+		ucCmd = 0;
+	}
+
+	s_tSim.ucCmd = ucCmd;
+	s_tSim.ucOpError = (uint8_t)(((uint32_t)s_tSim.auiReg[FLASHSIM_REG_FISR] + 1) < s_tSim.tCfg.ucFclkMHz);
+
+	switch(ucCmd)
+	{
+		case FLASHSIM_CMD_PROGRAM:
+			s_tSim.ulOpStart = ulStart;
+			s_tSim.ulOpEnd = ulStart + 1;
+			s_tSim.ucOpData = s_tSim.ucFwb;
+			ulNs = FlashSim_ScaledNs(s_tSim.tCfg.ulProgramByteNs);
+			s_tSim.tStats.ulProgramCmds++;
+			break;
+
+		case FLASHSIM_CMD_ERASE:
+		case FLASHSIM_CMD_BLANKCHECK:
+			if((ulEnd < ulStart) || (ulEnd >= ulSize))
+			{
+				ucCmd = 0;
+				break;
+			}
+			if(ucCmd == FLASHSIM_CMD_ERASE)
+			{
+				//Every block touched by FSAR..FEAR is erased
+				s_tSim.ulOpStart = ulStart - (ulStart % s_tSim.tCfg.uiBlockSize);
+				s_tSim.ulOpEnd = ulEnd - (ulEnd % s_tSim.tCfg.uiBlockSize) + s_tSim.tCfg.uiBlockSize;
+				ulNs = FlashSim_ScaledNs(s_tSim.tCfg.ulEraseBlockNs
+						* ((s_tSim.ulOpEnd - s_tSim.ulOpStart) / s_tSim.tCfg.uiBlockSize));
+				s_tSim.tStats.ulEraseCmds++;
+			}
+			else
+			{
+				s_tSim.ulOpStart = ulStart;
+				s_tSim.ulOpEnd = ulEnd + 1;
+				ulNs = s_tSim.tCfg.ulBlankCheckNs + (s_tSim.tCfg.ulBlankCheckByteNs * (ulEnd + 1 - ulStart));
+				s_tSim.ucOpError = 0;
+				s_tSim.tStats.ulBlankCheckCmds++;
+			}
+			break;
+
+		default:
+			ucCmd = 0;
+			break;
+	}
+
+	if(ucCmd == 0)
+	{
+		s_tSim.auiReg[FLASHSIM_REG_FSTATR0] |= FLASHSIM_FSTATR0_ILGLERR;
+		s_tSim.auiReg[FLASHSIM_REG_FSTATR1] |= FLASHSIM_FSTATR1_FRDY;
+		s_tSim.tStats.ulIllegalCmds++;
+		return;
+	}
+
+	s_tSim.ucBusy = 1;
+	s_tSim.ullOpStartAt = s_tSim.tStats.ullTimeNs;
+	s_tSim.ullOpDoneAt = s_tSim.tStats.ullTimeNs + ulNs;
+	s_tSim.tStats.ullBusyNs += ulNs;
+
+	if(	(s_tSim.ulCutCommand != 0) && ((s_tSim.ucCutCmd == 0) || (s_tSim.ucCutCmd == ucCmd))
+		&& (--s_tSim.ulCutCommand == 0))
+	{
+		s_tSim.ullCutAt = s_tSim.ullOpStartAt;
+		if((FlashSim_Rand() & 0x07) != 0)
+		{
+			s_tSim.ullCutAt += (((uint32_t)FlashSim_Rand() << 16) | ((uint32_t)FlashSim_Rand() << 8) | FlashSim_Rand())
+								% ulNs;
+		}
+		s_tSim.ucCutArmed = 1;
+	}
+}
+
+/**
+* @brief	This function resets the model: registers to their reset value and the array erased
+* @param	ptConfig, device description and timing
+* @return	none
+*/
+void FlashSim_Init(const FlashSim_Config *ptConfig)
+{
+	memset(&s_tSim, 0, sizeof(s_tSim));
+	s_tSim.tCfg = *ptConfig;
+	if(((uint32_t)s_tSim.tCfg.uiBlockSize * s_tSim.tCfg.ucBlockNum) > FLASHSIM_MAX_SIZE)
+	{
+		s_tSim.tCfg.ucBlockNum = (uint8_t)(FLASHSIM_MAX_SIZE / s_tSim.tCfg.uiBlockSize);
+	}
+
+	memset(s_tSim.aucArray, s_tSim.tCfg.ucErasedValue, sizeof(s_tSim.aucArray));
+	memset(s_tSim.aucBlank, 1, sizeof(s_tSim.aucBlank));
+
+	FlashSim_Reset();
+}
+
+/**
+* @brief	This function arms a power cut, or disarms it
+* @param	ucCmd, FLASHSIM_CMD_xxx to cut only that kind of command, 0 for any
+* @param	ulCommand, the power is cut during the ulCommand-th command (of that kind) started from now, 1 for the
+*			next one; 0 to disarm
+* @param	ulSeed, seed of the time of the cut in the command and of the cells it leaves undefined
+* @param	pfnCut, called at the cut
+* @return	none
+*/
+void FlashSim_SetPowerCut(uint8_t ucCmd, uint32_t ulCommand, uint32_t ulSeed, FlashSim_CutHook pfnCut)
+{
+	s_tSim.ucCutCmd = ucCmd;
+	s_tSim.ulCutCommand = ulCommand;
+	s_tSim.ulCutRand = ulSeed;
+	s_tSim.ucCutArmed = 0;
+	s_tSim.pfnCut = pfnCut;
+}
+
+/**
+* @brief	This function powers the model on again after a cut: registers and sequencer as after a reset, the array
+*			as the cut left it, the virtual time and the counters keep running
+* @param	none
+* @return	none
+*/
+void FlashSim_PowerOn(void)
+{
+	FlashSim_Reset();
+}
+
+/**
+* @brief	This function gives the configuration of the model
+* @param	none
+* @return	configuration in use
+*/
+const FlashSim_Config *FlashSim_GetConfig(void)
+{
+	return &s_tSim.tCfg;
+}
+
+/**
+* @brief	This function advances the virtual time, e.g. to account for CPU work done between polls
+* @param	ullNs, nanoseconds to advance
+* @return	none
+*/
+void FlashSim_Advance(uint64_t ullNs)
+{
+	uint64_t ullEnd = s_tSim.tStats.ullTimeNs + ullNs;
+
+	//Through every command end on the way, so an interrupt handler starts the next command on time
+	while(	s_tSim.ucBusy && !s_tSim.ucCutArmed && (s_tSim.ullOpDoneAt < ullEnd)
+			&& (s_tSim.ullOpDoneAt > s_tSim.tStats.ullTimeNs))
+	{
+		FlashSim_Tick(s_tSim.ullOpDoneAt - s_tSim.tStats.ullTimeNs);
+	}
+	FlashSim_Tick((ullEnd > s_tSim.tStats.ullTimeNs) ? (ullEnd - s_tSim.tStats.ullTimeNs) : 0);
+}
+
+/**
+* @brief	This function gives the virtual time
+* @param	none
+* @return	nanoseconds since FlashSim_Init
+*/
+uint64_t FlashSim_Now(void)
+{
+	return s_tSim.tStats.ullTimeNs;
+}
+
+/**
+* @brief	This function reads the cycle counter of the target (a CMT or MTU channel), at the cost of one register
+*			access: a command can end and its interrupt be taken in the middle of the code that takes a timestamp
+* @param	none
+* @return	nanoseconds since FlashSim_Init
+*/
+uint64_t FlashSim_ReadClock(void)
+{
+	s_tSim.tStats.ulRegAccesses++;
+	FlashSim_Tick(s_tSim.tCfg.ulRegAccessNs);
+
+	return s_tSim.tStats.ullTimeNs;
+}
+
+/**
+* @brief	This function sets the FRDY interrupt handler, kept by FlashSim_Init and FlashSim_PowerOn
+* @param	pfnIsr, handler, 0 for none
+* @return	none
+*/
+void FlashSim_SetFrdyIsr(FlashSim_Isr pfnIsr)
+{
+	s_pfnFlashSimIsr = pfnIsr;
+}
+
+/**
+* @brief	This function masks the interrupts, as clearing the PSW I flag
+* @param	none
+* @return	1 if they were enabled, to be given to FlashSim_IntRestore
+*/
+uint32_t FlashSim_IntSave(void)
+{
+	uint32_t ulEnabled = !s_tSim.ucIntMasked;
+
+	s_tSim.ucIntMasked = 1;
+
+	return ulEnabled;
+}
+
+/**
+* @brief	This function unmasks the interrupts if they were enabled at the matching FlashSim_IntSave, taking the
+*			FRDY interrupt raised meanwhile
+* @param	ulEnabled, value given by FlashSim_IntSave
+* @return	none
+*/
+void FlashSim_IntRestore(uint32_t ulEnabled)
+{
+	if(ulEnabled)
+	{
+		s_tSim.ucIntMasked = 0;
+		FlashSim_Interrupt();
+	}
+}
+
+/**
+* @brief	This function gives the counters of the model
+* @param	none
+* @return	counters
+*/
+const FlashSim_Stats *FlashSim_GetStats(void)
+{
+	return &s_tSim.tStats;
+}
+
+/**
+* @brief	This function clears the counters of the model. The virtual time keeps running.
+* @param	none
+* @return	none
+*/
+void FlashSim_ClearStats(void)
+{
+	uint64_t ullNow = s_tSim.tStats.ullTimeNs;
+
+	memset(&s_tSim.tStats, 0, sizeof(s_tSim.tStats));
+	s_tSim.tStats.ullTimeNs = ullNow;
+}
+
+/**
+* @brief	This function emulates a write access to a FLASH or SYSTEM register
+* @param	eReg, register
+* @param	uiValue, value written
+* @return	none
+*/
+void FlashSim_RegWrite(FlashSim_Reg eReg, uint16_t uiValue)
+{
+	s_tSim.tStats.ulRegAccesses++;
+	FlashSim_Tick(s_tSim.tCfg.ulRegAccessNs);
+	if(s_tSim.ucPowerOff)
+	{
+		return;
+	}
+
+	switch(eReg)
+	{
+		case FLASHSIM_REG_DFLCTL:
+			if(uiValue && !s_tSim.auiReg[FLASHSIM_REG_DFLCTL])
+			{
+				s_tSim.ullDfAccessAt = s_tSim.tStats.ullTimeNs + s_tSim.tCfg.ulDstopNs;
+			}
+			s_tSim.auiReg[FLASHSIM_REG_DFLCTL] = (uint16_t)(uiValue & 1);
+			break;
+
+		case FLASHSIM_REG_FENTRYR:
+			//Writes without the FEKEY are ignored, so is any change while the sequencer is busy
+			if(((uiValue & 0xFF00) != FLASHSIM_FENTRYR_KEY) || s_tSim.ucBusy)
+			{
+				s_tSim.tStats.ulProtectErrors++;
+				break;
+			}
+			if(((uiValue & 0x00FF) == 0) && (s_tSim.tStats.ullTimeNs < s_tSim.ullReadModeAt))
+			{
+				s_tSim.tStats.ulTimingViolations++;
+			}
+			s_tSim.auiReg[FLASHSIM_REG_FENTRYR] = (uint16_t)(uiValue & 0x00FF);
+			break;
+
+		case FLASHSIM_REG_FPR:
+			s_tSim.ucProtectStep = (uint8_t)((uiValue == FLASHSIM_FPR_KEY) ? 1 : 0);
+			break;
+
+		case FLASHSIM_REG_FPMCR:
+			//FPR = 0xA5, then FPMCR = value, ~value, value
+			if(	(s_tSim.ucProtectStep == 1)
+				|| ((s_tSim.ucProtectStep == 2) && ((uint8_t)uiValue == (uint8_t)~s_tSim.ucProtectValue))
+				|| ((s_tSim.ucProtectStep == 3) && ((uint8_t)uiValue == s_tSim.ucProtectValue)))
+			{
+				if(s_tSim.ucProtectStep == 1)
+				{
+					s_tSim.ucProtectValue = (uint8_t)uiValue;
+				}
+				s_tSim.ucProtectStep++;
+			}
+			else
+			{
+				s_tSim.ucProtectStep = 0;
+				s_tSim.auiReg[FLASHSIM_REG_FPSR] |= FLASHSIM_FPSR_PERR;
+				s_tSim.tStats.ulProtectErrors++;
+				break;
+			}
+			if(s_tSim.ucProtectStep == 4)
+			{
+				s_tSim.ucProtectStep = 0;
+				if(s_tSim.ucBusy)
+				{
+					s_tSim.tStats.ulProtectErrors++;
+					break;
+				}
+				if(	(s_tSim.auiReg[FLASHSIM_REG_FPMCR] & FLASHSIM_FPMCR_PEMODE)
+					&& !(uiValue & FLASHSIM_FPMCR_PEMODE))
+				{
+					s_tSim.ullReadModeAt = s_tSim.tStats.ullTimeNs + s_tSim.tCfg.ulTmsNs;
+				}
+				s_tSim.auiReg[FLASHSIM_REG_FPMCR] = (uint16_t)(uiValue & 0x00FF);
+			}
+			break;
+
+		case FLASHSIM_REG_FISR:
+			s_tSim.auiReg[FLASHSIM_REG_FISR] = (uint16_t)(uiValue & 0x3F);
+			break;
+
+		case FLASHSIM_REG_FWB0:
+		case FLASHSIM_REG_FWBL:
+			s_tSim.auiReg[eReg] = uiValue;
+			s_tSim.ucFwb = (uint8_t)uiValue;
+			break;
+
+		case FLASHSIM_REG_FCR:
+			if(uiValue & FLASHSIM_FCR_OPST)
+			{
+				s_tSim.auiReg[FLASHSIM_REG_FCR] = uiValue;
+				FlashSim_StartCmd((uint8_t)(uiValue & FLASHSIM_FCR_CMD));
+			}
+			else
+			{
+				//Clearing OPST before FRDY does not stop the command
+				if(s_tSim.ucBusy)
+				{
+					s_tSim.tStats.ulTimingViolations++;
+				}
+				s_tSim.auiReg[FLASHSIM_REG_FCR] = 0;
+				s_tSim.auiReg[FLASHSIM_REG_FSTATR1] &= (uint16_t)~FLASHSIM_FSTATR1_FRDY;
+			}
+			break;
+
+		case FLASHSIM_REG_FRESETR:
+			if(uiValue & 1)
+			{
+				s_tSim.ucBusy = 0;
+				s_tSim.auiReg[FLASHSIM_REG_FCR] = 0;
+				s_tSim.auiReg[FLASHSIM_REG_FSTATR0] = 0;
+				s_tSim.auiReg[FLASHSIM_REG_FSTATR1] = 0;
+				s_tSim.tStats.ulSeqResets++;
+			}
+			s_tSim.auiReg[FLASHSIM_REG_FRESETR] = (uint16_t)(uiValue & 1);
+			break;
+
+		case FLASHSIM_REG_FSTATR0:
+		case FLASHSIM_REG_FSTATR1:
+		case FLASHSIM_REG_FPSR:
+			//Read only
+			break;
+
+		default:
+			s_tSim.auiReg[eReg] = uiValue;
+			break;
+	}
+
+	FlashSim_UpdateMode();
+}
+
+/**
+* @brief	This function emulates a read access to a FLASH or SYSTEM register
+* @param	eReg, register
+* @return	register value
+*/
+uint16_t FlashSim_RegRead(FlashSim_Reg eReg)
+{
+	s_tSim.tStats.ulRegAccesses++;
+	if(eReg == FLASHSIM_REG_FSTATR1)
+	{
+		s_tSim.tStats.ulFrdyPolls++;
+	}
+	FlashSim_Tick(s_tSim.tCfg.ulRegAccessNs);
+
+	return s_tSim.auiReg[eReg];
+}
+
+/**
+* @brief	This function emulates a software delay loop
+* @param	ulLoops, number of iterations
+* @return	none
+*/
+void FlashSim_Delay(uint32_t ulLoops)
+{
+	uint64_t ullNs = (uint64_t)ulLoops * s_tSim.tCfg.ulDelayLoopNs;
+
+	s_tSim.tStats.ullDelayNs += ullNs;
+	FlashSim_Tick(ullNs);
+}
+
+/**
+* @brief	This function maps a data flash read address to the simulated array, at the cost of one bus access.
+*			Mapping the array while it is not readable (access disabled, P/E mode or tDSTOP/tMS not elapsed)
+*			is counted as a violation.
+* @param	ulAddr, read address
+* @return	pointer to the simulated cell, or to a scratch cell if ulAddr is not data flash
+*/
+const uint8_t *FlashSim_ReadPtr(uint32_t ulAddr)
+{
+	static const uint8_t ucScratch = 0;
+	uint32_t ulOffset = ulAddr - s_tSim.tCfg.ulReadBase;
+
+	s_tSim.tStats.ulRegAccesses++;
+	FlashSim_Tick(s_tSim.tCfg.ulRegAccessNs);
+
+	if(	!s_tSim.auiReg[FLASHSIM_REG_DFLCTL] || (s_tSim.ucMode != FLASHSIM_MODE_READ)
+		|| (s_tSim.tStats.ullTimeNs < s_tSim.ullDfAccessAt) || (s_tSim.tStats.ullTimeNs < s_tSim.ullReadModeAt))
+	{
+		s_tSim.tStats.ulReadViolations++;
+	}
+
+	if(ulOffset >= ((uint32_t)s_tSim.tCfg.uiBlockSize * s_tSim.tCfg.ucBlockNum))
+	{
+		s_tSim.tStats.ulReadViolations++;
+		return &ucScratch;
+	}
+	return &s_tSim.aucArray[ulOffset];
+}
+
+/**
+* @brief	This function reads a cell of the array without any mode check, for test code
+* @param	ulOffset, offset from the start of the data flash
+* @return	cell value
+*/
+uint8_t FlashSim_Peek(uint32_t ulOffset)
+{
+	return s_tSim.aucArray[ulOffset % FLASHSIM_MAX_SIZE];
+}
+
+/**
+* @brief	This function tells whether a cell of the array is erased, for test code
+* @param	ulOffset, offset from the start of the data flash
+* @return	1 if erased, 0 if programmed
+*/
+uint8_t FlashSim_IsBlank(uint32_t ulOffset)
+{
+	return s_tSim.aucBlank[ulOffset % FLASHSIM_MAX_SIZE];
+}
@@ -0,0 +1,181 @@
+/**
+* @brief Host model of the RX130/RX140 FLASH sequencer and data flash array. It emulates the registers
+* used by the Flash Manager module (DFLCTL, FENTRYR, FPR/FPMCR, FISR, FASR, FSAR, FEAR, FWB, FCR,
+* FSTATR0, FSTATR1 and FRESETR) on top of a simulated array, with a virtual clock that models the
+* program, erase and mode transition times. Illegal sequences are rejected the way the sequencer does
+* (ILGLERR, FPSR.PERR) and counted, so driver changes can be measured and regression tested on a PC.
+*
+* The driver is built against this model by defining FLASHMAN_HOST (see FlashManagerHw.h).
+*
+* Power cuts: FlashSim_SetPowerCut cuts the power during a given sequencer command (any one, or only erases, ...),
+* at its start or anywhere while it runs. A program cut leaves the cell partly programmed and an erase cut leaves
+* the block with undefined cells, which may pass the blank check or not. The test code gets control back from the
+* cut hook (longjmp), restarts the model with FlashSim_PowerOn, the array kept, and runs its startup again.
+*
+* Interrupts: with a handler given to FlashSim_SetFrdyIsr, FRDY rising while FRDYIE is set calls it at the model
+* access where the command ends, as the FRDYI vector would run between two instructions. FlashSim_IntSave and
+* FlashSim_IntRestore model the PSW I flag: an interrupt raised while it is clear waits for the restore.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHSIM_H__
+#define __FLASHSIM_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <stdint.h>
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHSIM_MAX_SIZE			0x2000		//Largest data flash array the model can hold
+#define FLASHSIM_MAX_BLOCKS			32			//Largest number of blocks the model can count erases of
+
+//FENTRYR
+#define FLASHSIM_FENTRYR_KEY		0xAA00
+#define FLASHSIM_FENTRYR_FENTRYD	0x0080
+
+//FPMCR
+#define FLASHSIM_FPR_KEY			0xA5
+#define FLASHSIM_FPMCR_PEMODE		0x10
+#define FLASHSIM_FPMCR_READMODE		0x08
+
+//FCR
+#define FLASHSIM_FCR_OPST			0x80
+#define FLASHSIM_FCR_CMD			0x0F
+#define FLASHSIM_CMD_PROGRAM		0x01
+#define FLASHSIM_CMD_BLANKCHECK		0x03
+#define FLASHSIM_CMD_ERASE			0x04
+
+//FSTATR0
+#define FLASHSIM_FSTATR0_ERERR		0x01
+#define FLASHSIM_FSTATR0_PRGERR		0x02
+#define FLASHSIM_FSTATR0_BCERR		0x08
+#define FLASHSIM_FSTATR0_ILGLERR	0x10
+
+//FSTATR1
+#define FLASHSIM_FSTATR1_FRDY		0x40
+
+//FPSR
+#define FLASHSIM_FPSR_PERR			0x01
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+typedef enum
+{
+	FLASHSIM_REG_DFLCTL = 0,
+	FLASHSIM_REG_FENTRYR,
+	FLASHSIM_REG_FPR,
+	FLASHSIM_REG_FPSR,
+	FLASHSIM_REG_FPMCR,
+	FLASHSIM_REG_FISR,
+	FLASHSIM_REG_FASR,
+	FLASHSIM_REG_FSARH,
+	FLASHSIM_REG_FSARL,
+	FLASHSIM_REG_FEARH,
+	FLASHSIM_REG_FEARL,
+	FLASHSIM_REG_FWB0,
+	FLASHSIM_REG_FWBH,
+	FLASHSIM_REG_FWBL,
+	FLASHSIM_REG_FCR,
+	FLASHSIM_REG_FSTATR0,
+	FLASHSIM_REG_FSTATR1,
+	FLASHSIM_REG_FRESETR,
+	FLASHSIM_REG_FRDYIE,
+	FLASHSIM_REG_OSCOVFSR,		//SYSTEM.OSCOVFSR, bit 3 = HCOVF
+	FLASHSIM_REG_SOPCCR,		//SYSTEM.SOPCCR, bit 0 = SOPCM
+	FLASHSIM_REG_NUM
+} FlashSim_Reg;
+
+typedef struct
+{
+	const char *pcName;
+	uint32_t ulReadBase;			//Data flash address in read mode
+	uint32_t ulWriteBase;			//Data flash address as seen by the sequencer (FSAR/FEAR)
+	uint16_t uiBlockSize;
+	uint8_t  ucBlockNum;
+	uint8_t  ucErasedValue;			//Value returned by erased cells (undefined on the real device)
+	uint8_t  ucFclkMHz;				//FCLK, FISR.PCKA must be set to FCLK - 1
+	uint32_t ulRegAccessNs;			//Cost of one peripheral register access
+	uint32_t ulDelayLoopNs;			//Cost of one iteration of a software delay loop
+	uint32_t ulProgramByteNs;		//Program time of one byte
+	uint32_t ulEraseBlockNs;		//Erase time of one block
+	uint32_t ulBlankCheckNs;		//Blank check setup time
+	uint32_t ulBlankCheckByteNs;	//Blank check time per byte
+	uint32_t ulDstopNs;				//tDSTOP, DFLEN set to data flash accessible
+	uint32_t ulTmsNs;				//tMS, FPMCR read mode to FENTRYR clear / array access
+} FlashSim_Config;
+
+typedef struct
+{
+	uint64_t ullTimeNs;				//Virtual time
+	uint64_t ullBusyNs;				//Time the sequencer spent executing commands
+	uint64_t ullDelayNs;			//Time spent in software delay loops
+	uint32_t ulRegAccesses;
+	uint32_t ulFrdyPolls;
+	uint32_t ulProgramCmds;
+	uint32_t ulEraseCmds;
+	uint32_t ulBlocksErased;
+	uint32_t ulBlankCheckCmds;
+	uint32_t ulToPEMode;			//Read mode to P/E mode transitions
+	uint32_t ulToReadMode;			//P/E mode to read mode transitions
+	uint32_t ulSeqResets;			//FRESETR pulses
+	uint32_t ulIllegalCmds;			//Commands rejected with ILGLERR
+	uint32_t ulProtectErrors;		//FPMCR writes outside of the FPR key sequence
+	uint32_t ulReadViolations;		//Array reads outside of a settled read mode
+	uint32_t ulTimingViolations;	//Mode transitions done before the required wait
+	uint32_t ulOverwrites;			//Bytes programmed without a previous erase
+	uint32_t ulPowerCuts;			//See FlashSim_SetPowerCut
+	uint32_t ulCutsInProgram;		//Power cuts while a program command was running
+	uint32_t ulCutsInErase;			//Power cuts while an erase command was running
+	uint32_t ulInterrupts;			//FRDY interrupts taken, see FlashSim_SetFrdyIsr
+	uint32_t ulDeferredInts;		//Of them, raised while interrupts were masked
+	uint32_t aulBlockErases[FLASHSIM_MAX_BLOCKS];	//Erase cycles of each block
+} FlashSim_Stats;
+
+//Called when the power is cut, must not return to the driver: without power no code runs on
+typedef void (*FlashSim_CutHook)(void);
+
+//FRDY interrupt handler, see FlashSim_SetFrdyIsr
+typedef void (*FlashSim_Isr)(void);
+
+
+/***********************************************************************************************************************
+* Declarations of Public Variables
+***********************************************************************************************************************/
+extern const FlashSim_Config g_tFlashSim_RX140;
+extern const FlashSim_Config g_tFlashSim_RX130;
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+void FlashSim_Init(const FlashSim_Config *ptConfig);
+const FlashSim_Config *FlashSim_GetConfig(void);
+void FlashSim_Advance(uint64_t ullNs);
+uint64_t FlashSim_Now(void);
+uint64_t FlashSim_ReadClock(void);
+const FlashSim_Stats *FlashSim_GetStats(void);
+void FlashSim_ClearStats(void);
+
+void FlashSim_RegWrite(FlashSim_Reg eReg, uint16_t uiValue);
+uint16_t FlashSim_RegRead(FlashSim_Reg eReg);
+void FlashSim_Delay(uint32_t ulLoops);
+const uint8_t *FlashSim_ReadPtr(uint32_t ulAddr);
+
+uint8_t FlashSim_Peek(uint32_t ulOffset);
+uint8_t FlashSim_IsBlank(uint32_t ulOffset);
+
+void FlashSim_SetPowerCut(uint8_t ucCmd, uint32_t ulCommand, uint32_t ulSeed, FlashSim_CutHook pfnCut);
+void FlashSim_PowerOn(void);
+
+void FlashSim_SetFrdyIsr(FlashSim_Isr pfnIsr);
+uint32_t FlashSim_IntSave(void);
+void FlashSim_IntRestore(uint32_t ulEnabled);
+
+
+#endif // __FLASHSIM_H__
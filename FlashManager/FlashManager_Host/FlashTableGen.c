@@ -0,0 +1,416 @@
+/**
+* @brief Generator of the Flash Table images looked up in place by the Flash Table module (FlashTable.h). It reads a
+* text table, one entry per line:
+*	key value_byte value_byte ...
+* numbers in C notation (e.g. 0x1A2B or 42), the same number of value bytes on every line, '#' up to the end of the
+* line is a comment; and writes the image, to be programmed at a data flash address given to FlashTbl_Open.
+* A minimal perfect hash table is built by default, a sorted one with -s.
+*
+* Build from the project root, with the check of the driver (FlashSum):
+*	cc -IDrivers/FlashManager/FlashManager_eSTB/FlashManager Drivers/FlashManager/FlashManager_Host/FlashTableGen.c
+*	   Drivers/FlashManager/FlashManager_eSTB/FlashManager/FlashSum.c -o flashtablegen
+* and run:
+*	flashtablegen [-s] variants.txt variants.bin
+* FlashBench links the builder with -DFLASHTBLGEN_NO_MAIN.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FlashTableGen.h"
+#include "FlashSum.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Image layout, see FlashTable.h; hash and displacement seed, see FlashTable.c
+#define FLASHTBLGEN_MAGIC		0x4C425446UL
+#define FLASHTBLGEN_HDR_SIZE	16
+#define mFlashTblGen_DispSeed(ulSeed, uiDisp)	( (ulSeed) + (0x9E3779B9UL * ((uint32_t)(uiDisp) + 1U)) )
+
+#define FLASHTBLGEN_MAX_IMAGE	0xFFFF	//FlashTbl_Open takes up to 64 KB
+#define FLASHTBLGEN_MAX_ENTRIES	( FLASHTBLGEN_MAX_IMAGE / 4 )
+#define FLASHTBLGEN_MAX_DISP	0xFFFF	//Displacements tried per bucket
+#define FLASHTBLGEN_SEEDS		64		//Seeds tried before giving up
+#define FLASHTBLGEN_LINE		1024
+
+#define mFlashTblGen_Put16(puc, ui)	{ (puc)[0] = (uint8_t)(ui); (puc)[1] = (uint8_t)((ui) >> 8); }
+#define mFlashTblGen_Put32(puc, ul)	{ mFlashTblGen_Put16(puc, ul); mFlashTblGen_Put16(&(puc)[2], (ul) >> 16); }
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static const uint32_t *s_pulFlashTblGenKeys;		//Keys sorted by FlashTblGen_CompareKeys
+
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function mixes a key with a seed, as FlashTbl_Hash does
+* @param	ulKey, key
+* @param	ulSeed, seed
+* @return	hash
+*/
+static uint32_t FlashTblGen_Hash(uint32_t ulKey, uint32_t ulSeed)
+{
+	ulKey ^= ulSeed;
+	ulKey ^= ulKey >> 16;
+	ulKey *= 0x7FEB352DUL;
+	ulKey ^= ulKey >> 15;
+	ulKey *= 0x846CA68BUL;
+	ulKey ^= ulKey >> 16;
+
+	return ulKey;
+}
+
+/**
+* @brief	This function orders two entry indexes by key, for qsort
+* @param	pvA, index
+* @param	pvB, index
+* @return	<0, 0 or >0
+*/
+static int FlashTblGen_CompareKeys(const void *pvA, const void *pvB)
+{
+	uint32_t ulA = s_pulFlashTblGenKeys[*(const uint16_t *)pvA];
+	uint32_t ulB = s_pulFlashTblGenKeys[*(const uint16_t *)pvB];
+
+	return (ulA > ulB) - (ulA < ulB);
+}
+
+/**
+* @brief	This function places the keys of a hash table: the buckets are taken from the biggest one, and every
+*			bucket gets the first displacement that sends all its keys to free slots
+* @param	pulKeys, keys
+* @param	uiCount, number of keys
+* @param	uiBuckets, number of buckets
+* @param	ulSeed, seed of the table
+* @param	puiDisp, displacement of every bucket
+* @param	puiSlotEntry, entry placed in every slot
+* @return	1 if every key has a slot, 0 otherwise
+*/
+static int FlashTblGen_Place(const uint32_t *pulKeys, uint16_t uiCount, uint16_t uiBuckets, uint32_t ulSeed,
+								uint16_t *puiDisp, uint16_t *puiSlotEntry)
+{
+	uint16_t *puiBucket = malloc(uiCount * sizeof(uint16_t));
+	uint16_t *puiSize = calloc(uiBuckets, sizeof(uint16_t));
+	uint16_t *puiSlots = malloc(uiCount * sizeof(uint16_t));
+	uint8_t *pucUsed = calloc(uiCount, 1);
+	uint16_t uiMaxSize = 0;
+	uint16_t uiSize;
+	uint16_t uiBucket;
+	uint16_t uiKeys;
+	uint32_t ulDisp;
+	uint32_t i;
+	uint32_t j;
+	int iOk = 1;
+
+	if((puiBucket == 0) || (puiSize == 0) || (puiSlots == 0) || (pucUsed == 0))
+	{
+		iOk = 0;
+	}
+	for(i = 0; iOk && (i < uiCount); i++)
+	{
+		puiBucket[i] = (uint16_t)(FlashTblGen_Hash(pulKeys[i], ulSeed) % uiBuckets);
+		uiSize = ++puiSize[puiBucket[i]];
+		uiMaxSize = (uiSize > uiMaxSize) ? uiSize : uiMaxSize;
+	}
+	for(i = 0; iOk && (i < uiCount); i++)
+	{
+		puiSlotEntry[i] = 0xFFFF;
+	}
+	for(i = 0; i < uiBuckets; i++)
+	{
+		puiDisp[i] = 0;
+	}
+
+	for(uiSize = uiMaxSize; iOk && (uiSize > 0); uiSize--)
+	{
+		for(uiBucket = 0; iOk && (uiBucket < uiBuckets); uiBucket++)
+		{
+			if(puiSize[uiBucket] != uiSize)
+			{
+				continue;
+			}
+			for(ulDisp = 0; ulDisp <= FLASHTBLGEN_MAX_DISP; ulDisp++)
+			{
+				uiKeys = 0;
+				for(i = 0; i < uiCount; i++)
+				{
+					if(puiBucket[i] != uiBucket)
+					{
+						continue;
+					}
+					puiSlots[uiKeys] = (uint16_t)(FlashTblGen_Hash(pulKeys[i], mFlashTblGen_DispSeed(ulSeed, ulDisp))
+													% uiCount);
+					if(pucUsed[puiSlots[uiKeys]])
+					{
+						break;
+					}
+					for(j = 0; (j < uiKeys) && (puiSlots[j] != puiSlots[uiKeys]); j++)
+					{
+					}
+					if(j < uiKeys)
+					{
+						break;
+					}
+					uiKeys++;
+				}
+				if(uiKeys == uiSize)
+				{
+					break;
+				}
+			}
+			if(ulDisp > FLASHTBLGEN_MAX_DISP)
+			{
+				iOk = 0;
+				break;
+			}
+
+			puiDisp[uiBucket] = (uint16_t)ulDisp;
+			for(i = 0, uiKeys = 0; i < uiCount; i++)
+			{
+				if(puiBucket[i] == uiBucket)
+				{
+					pucUsed[puiSlots[uiKeys]] = 1;
+					puiSlotEntry[puiSlots[uiKeys]] = (uint16_t)i;
+					uiKeys++;
+				}
+			}
+		}
+	}
+
+	free(puiBucket);
+	free(puiSize);
+	free(puiSlots);
+	free(pucUsed);
+
+	return iOk;
+}
+
+/**
+* @brief	This function builds a table image
+* @param	ucKind, FLASHTBLGEN_SORTED or FLASHTBLGEN_HASH
+* @param	pulKeys, keys, all different
+* @param	pucValues, values, ucValueSize bytes each in the order of the keys
+* @param	uiCount, number of entries
+* @param	ucValueSize, bytes per value
+* @param	pucImage, image
+* @param	ulMax, size of pucImage
+* @return	image size, 0 if the keys are not all different, the image does not fit or no hash was found
+*/
+uint32_t FlashTblGen_Build(uint8_t ucKind, const uint32_t *pulKeys, const uint8_t *pucValues, uint16_t uiCount,
+							uint8_t ucValueSize, uint8_t *pucImage, uint32_t ulMax)
+{
+	uint16_t uiBuckets = (ucKind == FLASHTBLGEN_HASH) ? (uint16_t)((uiCount / 2U) + 1U) : 0;
+	uint16_t *puiOrder = malloc(((uint32_t)uiCount + 1) * sizeof(uint16_t));
+	uint16_t *puiDisp = malloc(((uint32_t)uiBuckets + 1) * sizeof(uint16_t));
+	uint32_t ulKeysOfs = FLASHTBLGEN_HDR_SIZE + (2UL * uiBuckets);
+	uint32_t ulValuesOfs = ulKeysOfs + (4UL * uiCount);
+	uint32_t ulSize = ulValuesOfs + ((uint32_t)uiCount * ucValueSize);
+	uint32_t ulSeed = 0;
+	uint32_t i;
+
+	if(	(puiOrder == 0) || (puiDisp == 0) || (ulSize > ulMax) || (ucKind > FLASHTBLGEN_HASH)
+		|| ((ucKind == FLASHTBLGEN_HASH) && !uiCount))
+	{
+		free(puiOrder);
+		free(puiDisp);
+		return 0;
+	}
+
+	//Sorted order, also to find repeated keys
+	for(i = 0; i < uiCount; i++)
+	{
+		puiOrder[i] = (uint16_t)i;
+	}
+	s_pulFlashTblGenKeys = pulKeys;
+	qsort(puiOrder, uiCount, sizeof(uint16_t), FlashTblGen_CompareKeys);
+	for(i = 1; i < uiCount; i++)
+	{
+		if(pulKeys[puiOrder[i]] == pulKeys[puiOrder[i - 1]])
+		{
+			free(puiOrder);
+			free(puiDisp);
+			return 0;
+		}
+	}
+
+	if(ucKind == FLASHTBLGEN_HASH)
+	{
+		for(ulSeed = 0; ulSeed < FLASHTBLGEN_SEEDS; ulSeed++)
+		{
+			if(FlashTblGen_Place(pulKeys, uiCount, uiBuckets, ulSeed, puiDisp, puiOrder))
+			{
+				break;
+			}
+		}
+		if(ulSeed == FLASHTBLGEN_SEEDS)
+		{
+			free(puiOrder);
+			free(puiDisp);
+			return 0;
+		}
+		for(i = 0; i < uiBuckets; i++)
+		{
+			mFlashTblGen_Put16(&pucImage[FLASHTBLGEN_HDR_SIZE + (2 * i)], puiDisp[i]);
+		}
+	}
+
+	for(i = 0; i < uiCount; i++)
+	{
+		mFlashTblGen_Put32(&pucImage[ulKeysOfs + (4 * i)], pulKeys[puiOrder[i]]);
+		memcpy(&pucImage[ulValuesOfs + (i * ucValueSize)], &pucValues[(uint32_t)puiOrder[i] * ucValueSize], ucValueSize);
+	}
+	free(puiOrder);
+	free(puiDisp);
+
+	mFlashTblGen_Put32(&pucImage[0], FLASHTBLGEN_MAGIC);
+	mFlashTblGen_Put16(&pucImage[4], uiCount);
+	mFlashTblGen_Put16(&pucImage[6], uiBuckets);
+	mFlashTblGen_Put32(&pucImage[8], ulSeed);
+	pucImage[12] = ucKind;
+	pucImage[13] = ucValueSize;
+	mFlashTblGen_Put16(&pucImage[14],
+						FlashSum_Fletcher16(&pucImage[FLASHTBLGEN_HDR_SIZE], (uint16_t)(ulSize - FLASHTBLGEN_HDR_SIZE)));
+
+	return ulSize;
+}
+
+#ifndef FLASHTBLGEN_NO_MAIN
+/**
+* @brief	This function reads the text table, builds the image and writes it
+* @param	argc, number of arguments
+* @param	argv, [-s] table.txt table.bin
+* @return	0 if OK, 1 otherwise
+*/
+int main(int argc, char *argv[])
+{
+	static uint32_t s_aulKeys[FLASHTBLGEN_MAX_ENTRIES];
+	static uint8_t s_aucValues[FLASHTBLGEN_MAX_IMAGE];
+	static uint8_t s_aucImage[FLASHTBLGEN_MAX_IMAGE];
+	char acLine[FLASHTBLGEN_LINE];
+	uint8_t aucValue[255];
+	uint8_t ucKind = FLASHTBLGEN_HASH;
+	uint32_t ulLine = 0;
+	uint32_t ulSize;
+	uint16_t uiCount = 0;
+	uint16_t uiBytes;
+	int iValueSize = -1;
+	unsigned long ulByte;
+	char *pcPos;
+	char *pcEnd;
+	FILE *pfIn;
+	FILE *pfOut;
+
+	if((argc > 1) && (strcmp(argv[1], "-s") == 0))
+	{
+		ucKind = FLASHTBLGEN_SORTED;
+		argc--;
+		argv++;
+	}
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: flashtablegen [-s] table.txt table.bin\n");
+		return 1;
+	}
+
+	pfIn = fopen(argv[1], "r");
+	if(pfIn == 0)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+	while(fgets(acLine, sizeof(acLine), pfIn) != 0)
+	{
+		ulLine++;
+		pcPos = strchr(acLine, '#');
+		if(pcPos != 0)
+		{
+			*pcPos = '\0';
+		}
+
+		//Key and value bytes, up to the end of the line
+		uiBytes = 0;
+		ulByte = strtoul(acLine, &pcEnd, 0);
+		if(pcEnd == acLine)
+		{
+			if(acLine[strspn(acLine, " \t\r\n")] == '\0')
+			{
+				continue;
+			}
+			uiBytes = 0xFFFF;
+		}
+		s_aulKeys[uiCount] = (uint32_t)ulByte;
+		while(uiBytes <= sizeof(aucValue))
+		{
+			pcPos = pcEnd;
+			ulByte = strtoul(pcPos, &pcEnd, 0);
+			if(pcEnd == pcPos)
+			{
+				break;
+			}
+			if((ulByte > 0xFF) || (uiBytes == sizeof(aucValue)))
+			{
+				uiBytes = 0xFFFF;
+				break;
+			}
+			aucValue[uiBytes++] = (uint8_t)ulByte;
+		}
+		if(	(uiBytes == 0xFFFF) || (pcPos[strspn(pcPos, " \t\r\n")] != '\0')
+			|| ((iValueSize >= 0) && (uiBytes != (uint16_t)iValueSize)))
+		{
+			fprintf(stderr, "%s:%lu: bad entry\n", argv[1], (unsigned long)ulLine);
+			fclose(pfIn);
+			return 1;
+		}
+		if((uiCount == FLASHTBLGEN_MAX_ENTRIES) || ((((uint32_t)uiCount + 1) * uiBytes) > sizeof(s_aucValues)))
+		{
+			fprintf(stderr, "%s:%lu: table bigger than %u bytes\n", argv[1], (unsigned long)ulLine,
+					FLASHTBLGEN_MAX_IMAGE);
+			fclose(pfIn);
+			return 1;
+		}
+		iValueSize = uiBytes;
+		memcpy(&s_aucValues[(uint32_t)uiCount * uiBytes], aucValue, uiBytes);
+		uiCount++;
+	}
+	fclose(pfIn);
+
+	ulSize = FlashTblGen_Build(ucKind, s_aulKeys, s_aucValues, uiCount, (uint8_t)((iValueSize < 0) ? 0 : iValueSize),
+								s_aucImage, sizeof(s_aucImage));
+	if(ulSize == 0)
+	{
+		fprintf(stderr, "%s: repeated keys, table too big or no hash found\n", argv[1]);
+		return 1;
+	}
+
+	pfOut = fopen(argv[2], "wb");
+	if((pfOut == 0) || (fwrite(s_aucImage, 1, ulSize, pfOut) != ulSize))
+	{
+		fprintf(stderr, "cannot write %s\n", argv[2]);
+		if(pfOut != 0)
+		{
+			fclose(pfOut);
+		}
+		return 1;
+	}
+	fclose(pfOut);
+
+	printf("%u entries of %d bytes, %s table of %lu bytes\n", (unsigned)uiCount, (iValueSize < 0) ? 0 : iValueSize,
+			(ucKind == FLASHTBLGEN_HASH) ? "hash" : "sorted", (unsigned long)ulSize);
+
+	return 0;
+}
+#endif
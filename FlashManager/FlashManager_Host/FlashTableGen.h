@@ -0,0 +1,31 @@
+/**
+* @brief Builder of the Flash Table images, for the FlashTableGen tool and for FlashBench. See FlashTable.h for the
+* image layout.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHTABLEGEN_H__
+#define __FLASHTABLEGEN_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <stdint.h>
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Table kinds, FLASHTBL_KIND_xxx in FlashTable.h
+#define FLASHTBLGEN_SORTED		0
+#define FLASHTBLGEN_HASH		1
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint32_t FlashTblGen_Build(uint8_t ucKind, const uint32_t *pulKeys, const uint8_t *pucValues, uint16_t uiCount,
+							uint8_t ucValueSize, uint8_t *pucImage, uint32_t ulMax);
+
+
+#endif // __FLASHTABLEGEN_H__
@@ -0,0 +1,207 @@
+/**
+* @brief Converter of a Flash Manager trace dump to the Chrome trace event format, to be opened in Perfetto
+* (ui.perfetto.dev) or chrome://tracing. The dump is the FlashMan_Trace ring as it is in the target RAM
+* (sizeof(FlashMan_Trace) bytes from FlashMan_GetTrace, e.g. saved by the debugger or sent through a serial port),
+* little endian. Operations and mode transitions become nested slices, calls rejected because the driver was busy
+* become instant events.
+*
+* Build from the project root:
+*	cc Drivers/FlashManager/FlashManager_Host/FlashTrace.c -o flashtrace
+* and run:
+*	flashtrace trace.bin trace.json
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Dump layout, see FlashMan_Trace and FlashMan_TraceEvent in FlashManager.h
+#define FLASHTRACE_MAGIC		0x52544D46UL
+#define FLASHTRACE_HEADER_SIZE	16
+#define FLASHTRACE_EVENT_SIZE	12
+
+//FlashMan_TraceEvent.ucKind
+#define FLASHTRACE_BEGIN		0
+#define FLASHTRACE_END			1
+#define FLASHTRACE_REJECT		2
+
+//Deepest nesting of operations expected: operation, mode transition
+#define FLASHTRACE_MAX_DEPTH	8
+
+#define mFlashTrace_Get16(puc)	((uint16_t)((puc)[0] | ((uint16_t)(puc)[1] << 8)))
+#define mFlashTrace_Get32(puc)	((uint32_t)(puc)[0] | ((uint32_t)(puc)[1] << 8) | ((uint32_t)(puc)[2] << 16)	\
+								| ((uint32_t)(puc)[3] << 24))
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+//Names of the FLASHMAN_TR_xxx events
+static const char * const s_apcFlashTraceEvents[] =
+{
+	"read", "write", "erase", "blank check", "frontier", "diff write", "transaction", "append",
+	"to P/E mode", "to read mode", "enable", "disable", "image"
+};
+
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function gives the name of an event
+* @param	ucEvent, FLASHMAN_TR_xxx
+* @return	name
+*/
+static const char *FlashTrace_Name(uint8_t ucEvent)
+{
+	if(ucEvent < (sizeof(s_apcFlashTraceEvents) / sizeof(s_apcFlashTraceEvents[0])))
+	{
+		return s_apcFlashTraceEvents[ucEvent];
+	}
+
+	return "unknown";
+}
+
+/**
+* @brief	This function converts the events kept in a dump, oldest first. Timestamps are made monotonic across
+*			the wrap around of the 32-bit counter, so events must not be more than 2^32 cycles apart. Ends whose
+*			begin was overwritten are dropped, so the slices always nest.
+* @param	pucDump, dump
+* @param	ulDumpSize, bytes of the dump
+* @param	pfOut, JSON output
+* @return	0 if OK, 1 if the dump is not a Flash Manager trace
+*/
+static int FlashTrace_Convert(const uint8_t *pucDump, uint32_t ulDumpSize, FILE *pfOut)
+{
+	uint8_t aucStack[FLASHTRACE_MAX_DEPTH];
+	uint32_t ulClockHz, ulCount, ulFirst, n;
+	uint16_t uiSize;
+	uint64_t ullTime = 0;
+	uint32_t ulLast = 0;
+	uint8_t ucDepth = 0;
+	const char *pcSep = "";
+
+	if((ulDumpSize < FLASHTRACE_HEADER_SIZE) || (mFlashTrace_Get32(&pucDump[0]) != FLASHTRACE_MAGIC)
+		|| (mFlashTrace_Get16(&pucDump[14]) != FLASHTRACE_EVENT_SIZE))
+	{
+		return 1;
+	}
+	ulClockHz = mFlashTrace_Get32(&pucDump[4]);
+	ulCount = mFlashTrace_Get32(&pucDump[8]);
+	uiSize = mFlashTrace_Get16(&pucDump[12]);
+	if((ulClockHz == 0) || (uiSize == 0)
+		|| (ulDumpSize < (FLASHTRACE_HEADER_SIZE + ((uint32_t)uiSize * FLASHTRACE_EVENT_SIZE))))
+	{
+		return 1;
+	}
+
+	ulFirst = (ulCount > uiSize) ? (ulCount - uiSize) : 0;
+	fprintf(pfOut, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"events\":%lu,\"lost\":%lu},\"traceEvents\":[\n",
+			(unsigned long)ulCount, (unsigned long)ulFirst);
+
+	for(n = ulFirst; n != ulCount; n++)
+	{
+		const uint8_t *pucEvent = &pucDump[FLASHTRACE_HEADER_SIZE + ((n % uiSize) * FLASHTRACE_EVENT_SIZE)];
+		uint32_t ulTime = mFlashTrace_Get32(&pucEvent[0]);
+		uint32_t ulAddr = mFlashTrace_Get32(&pucEvent[4]);
+		uint16_t uiArg = mFlashTrace_Get16(&pucEvent[8]);
+		uint8_t ucEvent = pucEvent[10];
+		uint8_t ucKind = pucEvent[11];
+		double dUs;
+
+		ullTime = (n == ulFirst) ? 0 : (ullTime + (uint32_t)(ulTime - ulLast));
+		ulLast = ulTime;
+		dUs = ((double)ullTime * 1e6) / ulClockHz;
+
+		if(ucKind == FLASHTRACE_BEGIN)
+		{
+			if(ucDepth < FLASHTRACE_MAX_DEPTH)
+			{
+				aucStack[ucDepth] = ucEvent;
+			}
+			ucDepth++;
+			fprintf(pfOut, "%s{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+					"\"args\":{\"addr\":\"0x%08lX\",\"size\":%u}}", pcSep, FlashTrace_Name(ucEvent), dUs,
+					(unsigned long)ulAddr, (unsigned)uiArg);
+		}
+		else if(ucKind == FLASHTRACE_END)
+		{
+			if((ucDepth == 0) || ((ucDepth <= FLASHTRACE_MAX_DEPTH) && (aucStack[ucDepth - 1] != ucEvent)))
+			{
+				continue;
+			}
+			ucDepth--;
+			fprintf(pfOut, "%s{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+					"\"args\":{\"status\":%u}}", pcSep, FlashTrace_Name(ucEvent), dUs, (unsigned)uiArg);
+		}
+		else
+		{
+			fprintf(pfOut, "%s{\"name\":\"%s rejected\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":1,"
+					"\"args\":{\"addr\":\"0x%08lX\",\"status\":%u}}", pcSep, FlashTrace_Name(ucEvent), dUs,
+					(unsigned long)ulAddr, (unsigned)uiArg);
+		}
+		pcSep = ",\n";
+	}
+
+	fprintf(pfOut, "\n]}\n");
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static uint8_t s_aucDump[1UL << 20];
+	FILE *pfIn;
+	FILE *pfOut = stdout;
+	size_t ulRead;
+	int iReturn;
+
+	if((argc < 2) || (argc > 3))
+	{
+		fprintf(stderr, "usage: %s dump.bin [trace.json]\n", argv[0]);
+		return 2;
+	}
+
+	pfIn = fopen(argv[1], "rb");
+	if(pfIn == NULL)
+	{
+		perror(argv[1]);
+		return 2;
+	}
+	ulRead = fread(s_aucDump, 1, sizeof(s_aucDump), pfIn);
+	fclose(pfIn);
+
+	if(argc == 3)
+	{
+		pfOut = fopen(argv[2], "w");
+		if(pfOut == NULL)
+		{
+			perror(argv[2]);
+			return 2;
+		}
+	}
+
+	iReturn = FlashTrace_Convert(s_aucDump, (uint32_t)ulRead, pfOut);
+	if(iReturn != 0)
+	{
+		fprintf(stderr, "%s: not a Flash Manager trace dump\n", argv[1]);
+	}
+
+	if(pfOut != stdout)
+	{
+		fclose(pfOut);
+	}
+
+	return iReturn;
+}
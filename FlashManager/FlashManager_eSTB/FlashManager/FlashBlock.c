@@ -0,0 +1,440 @@
+/**
+* @brief The Flash Block module keeps the header of every data flash block.
+*
+* Block header, FLASHBLK_HDR_SIZE bytes. Data flash bytes can only be programmed once between erases, so every
+* state change programs its own slot, in this order:
+*	0	[FLASHBLK_MAGIC][erase count L][M][H][check][reserved x 3]	right after the erase	-> SPARE
+*	8	[seq L][seq H][check][reserved]								FlashBlk_Activate		-> ACTIVE
+*	12	[FLASHBLK_FULL_0][FLASHBLK_FULL_1]							FlashBlk_MarkFull		-> FULL
+*	14	[FLASHBLK_ERASING_0][FLASHBLK_ERASING_1]					FlashBlk_Retire			-> ERASING
+* A slot is taken as programmed when its bytes check, as the erased value of the cells is undefined. A block whose
+* first slot does not check is DIRTY: its erase count is lost, so the highest one of the other blocks is taken.
+* The sequence slot is only 3 bytes with a 1-byte check, which an erased slot may pass (e.g. cells reading 0x3C), so
+* the mount also blank checks the sequence slot of every block it would take as ACTIVE or FULL.
+* Erase counts are 24-bit, well above FLASHMAN_PE_CYCLES, so the wear of a block is known for its whole life.
+* An interrupted slot program or erase leaves, at worst, a block that has to be erased again.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashBlock.h"
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHBLK_MAGIC			0xB5
+#define FLASHBLK_SEQ_KEY		0x3C	//An erased slot (all 1s or all 0s) does not check
+#define FLASHBLK_FULL_0			0xF0
+#define FLASHBLK_FULL_1			0x0F
+#define FLASHBLK_ERASING_0		0xE1
+#define FLASHBLK_ERASING_1		0x1E
+
+//Header slots
+#define FLASHBLK_OFS_SPARE		0
+#define FLASHBLK_OFS_SEQ		8
+#define FLASHBLK_OFS_FULL		12
+#define FLASHBLK_OFS_ERASING	14
+#define FLASHBLK_SPARE_SIZE		5
+#define FLASHBLK_SEQ_SIZE		3
+#define FLASHBLK_COUNT_MAX		0xFFFFFFUL
+
+#define mFlashBlk_SlotWr(ucBlock, ucOfs)	(mFlashMan_BlockAddrWr(ucBlock) + (ucOfs))
+
+typedef char FlashBlk_CheckBlocks[(FLASHMAN_BLOCK_NUM < 0xFF) ? 1 : -1];
+typedef char FlashBlk_CheckHdr[((FLASHBLK_OFS_ERASING + 2) <= FLASHBLK_HDR_SIZE) ? 1 : -1];
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static FlashBlk_Info s_atFlashBlk[FLASHMAN_BLOCK_NUM];
+static uint8_t s_ucFlashBlkMounted = 0;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static void FlashBlk_Decode(const uint8_t *pucHdr, FlashBlk_Info *ptInfo);
+static uint8_t FlashBlk_IsValid(uint8_t ucBlock);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function decodes a block header read from the data flash
+* @param	pucHdr, header
+* @param	ptInfo, RAM view of the header
+* @return	none
+*/
+static void FlashBlk_Decode(const uint8_t *pucHdr, FlashBlk_Info *ptInfo)
+{
+	const uint8_t *pucSeq = &pucHdr[FLASHBLK_OFS_SEQ];
+
+	ptInfo->uiSeq = 0;
+	ptInfo->ulEraseCount = 0;
+	ptInfo->ucState = FLASHBLK_ST_DIRTY;
+
+	if(	(pucHdr[0] != FLASHBLK_MAGIC)
+		|| (pucHdr[4] != (uint8_t)~(FLASHBLK_MAGIC ^ pucHdr[1] ^ pucHdr[2] ^ pucHdr[3])))
+	{
+		return;
+	}
+	ptInfo->ulEraseCount = (uint32_t)pucHdr[1] | ((uint32_t)pucHdr[2] << 8) | ((uint32_t)pucHdr[3] << 16);
+	ptInfo->ucState = FLASHBLK_ST_SPARE;
+
+	if((pucHdr[FLASHBLK_OFS_ERASING] == FLASHBLK_ERASING_0) && (pucHdr[FLASHBLK_OFS_ERASING + 1] == FLASHBLK_ERASING_1))
+	{
+		ptInfo->ucState = FLASHBLK_ST_ERASING;
+	}
+	else if(pucSeq[2] == (uint8_t)(pucSeq[0] ^ pucSeq[1] ^ FLASHBLK_SEQ_KEY))
+	{
+		ptInfo->uiSeq = (uint16_t)(pucSeq[0] | ((uint16_t)pucSeq[1] << 8));
+		ptInfo->ucState = FLASHBLK_ST_ACTIVE;
+		if((pucHdr[FLASHBLK_OFS_FULL] == FLASHBLK_FULL_0) && (pucHdr[FLASHBLK_OFS_FULL + 1] == FLASHBLK_FULL_1))
+		{
+			ptInfo->ucState = FLASHBLK_ST_FULL;
+		}
+	}
+	else
+	{
+		// Empty
+	}
+}
+
+/**
+* @brief	This function checks that the module is mounted and the block is in range
+* @param	ucBlock, block index
+* @return	1 if OK, 0 otherwise
+*/
+static uint8_t FlashBlk_IsValid(uint8_t ucBlock)
+{
+	return (uint8_t)(s_ucFlashBlkMounted && (ucBlock < FLASHMAN_BLOCK_NUM));
+}
+
+/**
+* @brief	This function builds the RAM view of the blocks from their headers only. It has to be called once at
+*			start up, after FlashManInit; it reads FLASHBLK_HDR_SIZE bytes per block and blank checks the sequence
+*			slot of the blocks in use, so its duration does not depend on the data stored nor on where a power loss
+*			interrupted the last run. A block whose sequence slot is blank is SPARE whatever the slot reads, or
+*			DIRTY if its full marker checks.
+* @param	none
+* @return	0 if OK, Flash Manager error otherwise
+*/
+uint8_t FlashBlk_Mount(void)
+{
+	uint8_t aucHdr[FLASHBLK_HDR_SIZE];
+	uint32_t ulMaxCount = 0;
+	uint8_t ucBlank = 0;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	s_ucFlashBlkMounted = 0;
+
+	for(i = 0; i < FLASHMAN_BLOCK_NUM; i++)
+	{
+		ucReturn = FlashMan_ReadDF(aucHdr, mFlashMan_BlockAddrRd(i), FLASHBLK_HDR_SIZE);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		FlashBlk_Decode(aucHdr, &s_atFlashBlk[i]);
+		if((s_atFlashBlk[i].ucState == FLASHBLK_ST_ACTIVE) || (s_atFlashBlk[i].ucState == FLASHBLK_ST_FULL))
+		{
+			ucReturn = FlashMan_BlankCheckDF(mFlashBlk_SlotWr(i, FLASHBLK_OFS_SEQ), FLASHBLK_SEQ_SIZE, &ucBlank);
+			if(ucReturn != 0)
+			{
+				return ucReturn;
+			}
+			if(ucBlank)
+			{
+				s_atFlashBlk[i].uiSeq = 0;
+				s_atFlashBlk[i].ucState = (s_atFlashBlk[i].ucState == FLASHBLK_ST_ACTIVE) ? FLASHBLK_ST_SPARE
+																						: FLASHBLK_ST_DIRTY;
+			}
+		}
+		if((s_atFlashBlk[i].ucState != FLASHBLK_ST_DIRTY) && (s_atFlashBlk[i].ulEraseCount > ulMaxCount))
+		{
+			ulMaxCount = s_atFlashBlk[i].ulEraseCount;
+		}
+	}
+
+	//Lost erase counts: never less than the most worn block
+	for(i = 0; i < FLASHMAN_BLOCK_NUM; i++)
+	{
+		if(s_atFlashBlk[i].ucState == FLASHBLK_ST_DIRTY)
+		{
+			s_atFlashBlk[i].ulEraseCount = ulMaxCount;
+		}
+	}
+
+	s_ucFlashBlkMounted = 1;
+
+	return 0;
+}
+
+/**
+* @brief	This function gives the RAM view of a block header
+* @param	ucBlock, block index
+* @return	header, 0 if not mounted or out of range
+*/
+const FlashBlk_Info *FlashBlk_GetInfo(uint8_t ucBlock)
+{
+	if(!FlashBlk_IsValid(ucBlock))
+	{
+		return 0;
+	}
+
+	return &s_atFlashBlk[ucBlock];
+}
+
+/**
+* @brief	This function makes a block SPARE: it is erased, unless it is already spare, and its first header
+*			slot is programmed with the new erase count
+* @param	ucBlock, block index
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashBlk_Prepare(uint8_t ucBlock)
+{
+	FlashBlk_Info *ptInfo;
+	uint8_t aucSlot[FLASHBLK_SPARE_SIZE];
+	uint32_t ulCount;
+	uint8_t ucReturn;
+
+	if(!FlashBlk_IsValid(ucBlock))
+	{
+		return (ucBlock < FLASHMAN_BLOCK_NUM) ? ERR_FLASHBLK_NOTMOUNTED : ERR_FLASHBLK_PARAM;
+	}
+	ptInfo = &s_atFlashBlk[ucBlock];
+	if(ptInfo->ucState == FLASHBLK_ST_SPARE)
+	{
+		return 0;
+	}
+
+	//Until the first slot is programmed the block has no valid header
+	ptInfo->ucState = FLASHBLK_ST_DIRTY;
+	ucReturn = FlashMan_BlockEraseDF(mFlashMan_BlockAddrWr(ucBlock));
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	ulCount = (ptInfo->ulEraseCount < FLASHBLK_COUNT_MAX) ? (ptInfo->ulEraseCount + 1) : FLASHBLK_COUNT_MAX;
+	aucSlot[0] = FLASHBLK_MAGIC;
+	aucSlot[1] = (uint8_t)ulCount;
+	aucSlot[2] = (uint8_t)(ulCount >> 8);
+	aucSlot[3] = (uint8_t)(ulCount >> 16);
+	aucSlot[4] = (uint8_t)~(FLASHBLK_MAGIC ^ aucSlot[1] ^ aucSlot[2] ^ aucSlot[3]);
+	ptInfo->ulEraseCount = ulCount;
+
+	ucReturn = FlashMan_WriteDF(aucSlot, mFlashBlk_SlotWr(ucBlock, FLASHBLK_OFS_SPARE), sizeof(aucSlot));
+	if(ucReturn == 0)
+	{
+		ptInfo->ucState = FLASHBLK_ST_SPARE;
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function makes a block ACTIVE with the given sequence number, preparing it first if it is not
+*			spare. The sequence slot is blank checked first, so a slot left half programmed by a power loss makes
+*			the block be erased again instead of programmed over.
+* @param	ucBlock, block index
+* @param	uiSeq, sequence number
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashBlk_Activate(uint8_t ucBlock, uint16_t uiSeq)
+{
+	FlashBlk_Info *ptInfo;
+	uint8_t aucSlot[FLASHBLK_SEQ_SIZE];
+	uint8_t ucBlank = 0;
+	uint8_t ucReturn;
+
+	ucReturn = FlashBlk_Prepare(ucBlock);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+	ptInfo = &s_atFlashBlk[ucBlock];
+
+	ucReturn = FlashMan_BlankCheckDF(mFlashBlk_SlotWr(ucBlock, FLASHBLK_OFS_SEQ), FLASHBLK_SEQ_SIZE, &ucBlank);
+	if((ucReturn == 0) && !ucBlank)
+	{
+		ptInfo->ucState = FLASHBLK_ST_DIRTY;
+		ucReturn = FlashBlk_Prepare(ucBlock);
+	}
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	aucSlot[0] = (uint8_t)uiSeq;
+	aucSlot[1] = (uint8_t)(uiSeq >> 8);
+	aucSlot[2] = (uint8_t)(aucSlot[0] ^ aucSlot[1] ^ FLASHBLK_SEQ_KEY);
+
+	ucReturn = FlashMan_WriteDF(aucSlot, mFlashBlk_SlotWr(ucBlock, FLASHBLK_OFS_SEQ), sizeof(aucSlot));
+	if(ucReturn != 0)
+	{
+		ptInfo->ucState = FLASHBLK_ST_DIRTY;
+		return ucReturn;
+	}
+
+	ptInfo->uiSeq = uiSeq;
+	ptInfo->ucState = FLASHBLK_ST_ACTIVE;
+
+	return 0;
+}
+
+/**
+* @brief	This function marks an ACTIVE block as FULL
+* @param	ucBlock, block index
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashBlk_MarkFull(uint8_t ucBlock)
+{
+	static const uint8_t s_aucFull[2] = { FLASHBLK_FULL_0, FLASHBLK_FULL_1 };
+	uint8_t ucReturn;
+
+	if(!FlashBlk_IsValid(ucBlock) || (s_atFlashBlk[ucBlock].ucState != FLASHBLK_ST_ACTIVE))
+	{
+		return s_ucFlashBlkMounted ? ERR_FLASHBLK_PARAM : ERR_FLASHBLK_NOTMOUNTED;
+	}
+
+	ucReturn = FlashMan_WriteDF(s_aucFull, mFlashBlk_SlotWr(ucBlock, FLASHBLK_OFS_FULL), sizeof(s_aucFull));
+	if(ucReturn == 0)
+	{
+		s_atFlashBlk[ucBlock].ucState = FLASHBLK_ST_FULL;
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function marks a block whose data is no longer needed as ERASING, so it is not taken as valid
+*			data whatever happens before it is erased by FlashBlk_Prepare / FlashBlk_Activate. Spare and dirty
+*			blocks are left as they are.
+* @param	ucBlock, block index
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashBlk_Retire(uint8_t ucBlock)
+{
+	static const uint8_t s_aucErasing[2] = { FLASHBLK_ERASING_0, FLASHBLK_ERASING_1 };
+	uint8_t ucReturn;
+
+	if(!FlashBlk_IsValid(ucBlock))
+	{
+		return s_ucFlashBlkMounted ? ERR_FLASHBLK_PARAM : ERR_FLASHBLK_NOTMOUNTED;
+	}
+	if((s_atFlashBlk[ucBlock].ucState != FLASHBLK_ST_ACTIVE) && (s_atFlashBlk[ucBlock].ucState != FLASHBLK_ST_FULL))
+	{
+		return 0;
+	}
+
+	ucReturn = FlashMan_WriteDF(s_aucErasing, mFlashBlk_SlotWr(ucBlock, FLASHBLK_OFS_ERASING), sizeof(s_aucErasing));
+
+	//Even a half programmed marker leaves the block to be erased
+	s_atFlashBlk[ucBlock].ucState = (ucReturn == 0) ? FLASHBLK_ST_ERASING : FLASHBLK_ST_DIRTY;
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function hands out the least worn free (SPARE, ERASING or DIRTY) block of a range, prepared so it
+*			is SPARE. Spare blocks win ties, as they need no erase. Blocks worn up to FLASHMAN_PE_CYCLES are not
+*			handed out, as their data retention is no longer guaranteed.
+* @param	ucFirst, first block of the range
+* @param	ucBlocks, blocks in the range
+* @param	pucBlock, block handed out
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashBlk_Alloc(uint8_t ucFirst, uint8_t ucBlocks, uint8_t *pucBlock)
+{
+	const FlashBlk_Info *ptInfo;
+	const FlashBlk_Info *ptBest = 0;
+	uint8_t ucBest = 0;
+	uint8_t i;
+
+	if(!s_ucFlashBlkMounted)
+	{
+		return ERR_FLASHBLK_NOTMOUNTED;
+	}
+	if((ucBlocks == 0) || (ucFirst >= FLASHMAN_BLOCK_NUM) || (ucBlocks > (FLASHMAN_BLOCK_NUM - ucFirst)))
+	{
+		return ERR_FLASHBLK_PARAM;
+	}
+
+	for(i = ucFirst; i < (ucFirst + ucBlocks); i++)
+	{
+		ptInfo = &s_atFlashBlk[i];
+		if((ptInfo->ucState == FLASHBLK_ST_ACTIVE) || (ptInfo->ucState == FLASHBLK_ST_FULL))
+		{
+			continue;
+		}
+		if(	(ptBest == 0)
+			|| (ptInfo->ulEraseCount < ptBest->ulEraseCount)
+			|| (	(ptInfo->ulEraseCount == ptBest->ulEraseCount)
+					&& (ptInfo->ucState == FLASHBLK_ST_SPARE) && (ptBest->ucState != FLASHBLK_ST_SPARE)))
+		{
+			ptBest = ptInfo;
+			ucBest = i;
+		}
+	}
+
+	if((ptBest == 0) || (ptBest->ulEraseCount >= FLASHMAN_PE_CYCLES))
+	{
+		return ERR_FLASHBLK_NOFREE;
+	}
+
+	*pucBlock = ucBest;
+
+	return FlashBlk_Prepare(ucBest);
+}
+
+/**
+* @brief	This function gives the wear of the data flash and the margin left to FLASHMAN_PE_CYCLES. The erase
+*			count of a dirty block is estimated at mount, so the figures are never below the real wear.
+* @param	ptWear, wear
+* @return	0 if OK, ERR_FLASHBLK_NOTMOUNTED otherwise
+*/
+uint8_t FlashBlk_GetWear(FlashBlk_Wear *ptWear)
+{
+	uint32_t ulCount;
+	uint8_t i;
+
+	if(!s_ucFlashBlkMounted)
+	{
+		return ERR_FLASHBLK_NOTMOUNTED;
+	}
+
+	ptWear->ulTotal = 0;
+	ptWear->ulMin = FLASHBLK_COUNT_MAX;
+	ptWear->ulMax = 0;
+	ptWear->ucMaxBlock = 0;
+
+	for(i = 0; i < FLASHMAN_BLOCK_NUM; i++)
+	{
+		ulCount = s_atFlashBlk[i].ulEraseCount;
+		ptWear->ulTotal += ulCount;
+		if(ulCount < ptWear->ulMin)
+		{
+			ptWear->ulMin = ulCount;
+		}
+		if(ulCount > ptWear->ulMax)
+		{
+			ptWear->ulMax = ulCount;
+			ptWear->ucMaxBlock = i;
+		}
+	}
+
+	ptWear->ulLeft = (ptWear->ulMax < FLASHMAN_PE_CYCLES) ? (FLASHMAN_PE_CYCLES - ptWear->ulMax) : 0;
+	ptWear->ucMarginPct = (uint8_t)((ptWear->ulLeft * 100UL) / FLASHMAN_PE_CYCLES);
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/**
+* @brief The Flash Block module keeps a small header at the start of every FLASHMAN_BLOCK_SIZE block of the data flash
+* with the state, sequence number and erase count of the block, so the users of the data flash (e.g. the Flash
+* EEPROM module) rebuild their view of it at start up from the headers alone: FlashBlk_Mount reads
+* FLASHBLK_HDR_SIZE bytes and blank checks at most one slot per block, whatever the amount of data stored.
+* Users that do not need a fixed order of blocks take them from FlashBlk_Alloc, which hands out the least worn free
+* one, so the erases are spread over their range; FlashBlk_GetWear gives the margin left to the rated P/E cycles.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHBLOCK_H__
+#define __FLASHBLOCK_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHBLK_HDR_SIZE		16		//Data of a block starts after its header
+
+//Block states, FlashBlk_Info.ucState
+#define FLASHBLK_ST_DIRTY		0		//No valid header (never used, interrupted erase or header): erase before use
+#define FLASHBLK_ST_SPARE		1		//Erased, ready to be activated
+#define FLASHBLK_ST_ACTIVE		2		//Being filled
+#define FLASHBLK_ST_FULL		3		//Filled, read only
+#define FLASHBLK_ST_ERASING		4		//Data no longer needed, to be erased
+
+//Errors, the Flash Manager ones (ERR_FLASHE2DATA_xxx, FLASHMAN_STATUS_ERROR) are passed through
+#define ERR_FLASHBLK_NOTMOUNTED	0x20
+#define ERR_FLASHBLK_PARAM		0x21	//Block out of range or not in the state the call needs
+#define ERR_FLASHBLK_NOFREE		0x22	//No free block left below FLASHMAN_PE_CYCLES in the range
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+//RAM view of a block header
+typedef struct
+{
+	uint16_t uiSeq;				//Sequence number given by FlashBlk_Activate, ACTIVE and FULL blocks only
+	uint32_t ulEraseCount;		//Erases of the block; for a DIRTY block, estimated from the other blocks
+	uint8_t ucState;			//FLASHBLK_ST_xxx
+} FlashBlk_Info;
+
+//Wear of the data flash, from the erase counts of all the blocks
+typedef struct
+{
+	uint32_t ulTotal;			//Erases of all the blocks
+	uint32_t ulMin;				//Erases of the least worn block
+	uint32_t ulMax;				//Erases of the most worn block
+	uint32_t ulLeft;			//Erases left to the most worn block before FLASHMAN_PE_CYCLES
+	uint8_t ucMaxBlock;			//Most worn block
+	uint8_t ucMarginPct;		//ulLeft in % of FLASHMAN_PE_CYCLES
+} FlashBlk_Wear;
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint8_t FlashBlk_Mount(void);
+const FlashBlk_Info *FlashBlk_GetInfo(uint8_t ucBlock);
+uint8_t FlashBlk_Prepare(uint8_t ucBlock);
+uint8_t FlashBlk_Activate(uint8_t ucBlock, uint16_t uiSeq);
+uint8_t FlashBlk_MarkFull(uint8_t ucBlock);
+uint8_t FlashBlk_Retire(uint8_t ucBlock);
+uint8_t FlashBlk_Alloc(uint8_t ucFirst, uint8_t ucBlocks, uint8_t *pucBlock);
+uint8_t FlashBlk_GetWear(FlashBlk_Wear *ptWear);
+
+
+#endif // __FLASHBLOCK_H__
@@ -0,0 +1,509 @@
+/**
+* @brief The Flash Cache module keeps a RAM mirror of parameters stored in a log, see FlashCache.h.
+*
+* Data flash layout, per FLASHMAN_BLOCK_SIZE block of the range:
+*	header	FLASHBLK_HDR_SIZE bytes kept by the Flash Block module (state, sequence number, erase count)
+*	records	FLASHCACHE_BLOCK_SLOTS x [line][data 0 .. FLASHCACHE_LINE_SIZE - 1][sum L][sum H], sum = Fletcher-16
+*			of line and data
+* A write back appends one record per dirty line to the active block (head); the newest record of a line holds its
+* value, lines without a record read FLASHCACHE_FILL. The erased cells of the blocks are never programmed but by a
+* record. When the head has no room left the log moves to the least worn free block of the range: the lines stored
+* are copied there first, then the other blocks are retired. The blocks are replayed by sequence number at start up,
+* so a power loss during the move leaves, at worst, a new head holding part of the lines, the older block still
+* holding the others; the move is then finished by FlashCache_Init.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <string.h>
+
+#include "FlashCache.h"
+#include "FlashBlock.h"
+#include "FlashManager.h"
+#include "FlashSum.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHCACHE_LINES			( FLASHCACHE_SIZE / FLASHCACHE_LINE_SIZE )
+#define FLASHCACHE_REC_SIZE			( 1 + FLASHCACHE_LINE_SIZE + 2 )
+#define FLASHCACHE_BLOCK_SLOTS		( (FLASHMAN_BLOCK_SIZE - FLASHBLK_HDR_SIZE) / FLASHCACHE_REC_SIZE )
+#define FLASHCACHE_NONE				0xFF
+
+#define FLASHCACHE_BLOCK(r)			( (uint8_t)(FLASHCACHE_FIRST_BLOCK + (r)) )			//Range index to block
+
+#define mFlashCache_SlotRd(r, uiSlot)	\
+	( mFlashMan_BlockAddrRd(FLASHCACHE_BLOCK(r)) + FLASHBLK_HDR_SIZE + ((uint32_t)(uiSlot) * FLASHCACHE_REC_SIZE) )
+#define mFlashCache_SlotWr(r, uiSlot)	\
+	( mFlashMan_BlockAddrWr(FLASHCACHE_BLOCK(r)) + FLASHBLK_HDR_SIZE + ((uint32_t)(uiSlot) * FLASHCACHE_REC_SIZE) )
+
+#define mFlashCache_Is(auc, l)		( ((auc)[(l) >> 3] & (1U << ((l) & 7))) != 0 )
+#define mFlashCache_Set(auc, l)		( (auc)[(l) >> 3] |= (uint8_t)(1U << ((l) & 7)) )
+#define mFlashCache_Clear(auc, l)	( (auc)[(l) >> 3] &= (uint8_t)~(1U << ((l) & 7)) )
+
+typedef char FlashCache_CheckRange[(	(FLASHCACHE_BLOCKS >= 2) && (FLASHCACHE_BLOCKS <= 16)
+									&& ((FLASHCACHE_FIRST_BLOCK + FLASHCACHE_BLOCKS) <= FLASHMAN_BLOCK_NUM)) ? 1 : -1];
+typedef char FlashCache_CheckLines[(	((FLASHCACHE_SIZE % FLASHCACHE_LINE_SIZE) == 0) && (FLASHCACHE_LINES >= 1)
+									&& (FLASHCACHE_LINES < FLASHCACHE_NONE)) ? 1 : -1];
+typedef char FlashCache_CheckRoom[(FLASHCACHE_LINES <= (FLASHCACHE_BLOCK_SLOTS / 2)) ? 1 : -1];	//Room after a move
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static uint8_t s_aucFlashCache[FLASHCACHE_SIZE];					//Mirror
+static uint8_t s_aucFlashCacheDirty[(FLASHCACHE_LINES + 7) / 8];	//Lines written since the last write back
+static uint8_t s_aucFlashCacheStored[(FLASHCACHE_LINES + 7) / 8];	//Lines with a record in the log
+static uint8_t s_aucFlashCacheInHead[(FLASHCACHE_LINES + 7) / 8];	//Lines whose newest record is in the head
+static uint8_t s_ucFlashCacheValid = 0;
+static uint8_t s_ucFlashCacheHead;									//Active block, range index
+static uint16_t s_uiFlashCacheNext;									//Next record slot of the active block
+static uint16_t s_uiFlashCacheIdle;									//FlashCache_Tick calls since the last write
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static uint8_t FlashCache_IsLogBlock(uint8_t ucRange);
+static uint8_t FlashCache_Replay(uint8_t ucRange);
+static uint8_t FlashCache_Append(uint16_t uiLine);
+static uint8_t FlashCache_Settle(void);
+static uint8_t FlashCache_Move(void);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function tells if a block of the range holds part of the log
+* @param	ucRange, range index
+* @return	1 if the block is ACTIVE or FULL, 0 otherwise
+*/
+static uint8_t FlashCache_IsLogBlock(uint8_t ucRange)
+{
+	const FlashBlk_Info *ptInfo = FlashBlk_GetInfo(FLASHCACHE_BLOCK(ucRange));
+
+	return (uint8_t)((ptInfo->ucState == FLASHBLK_ST_ACTIVE) || (ptInfo->ucState == FLASHBLK_ST_FULL));
+}
+
+/**
+* @brief	This function loads the records of a block into the mirror and makes it the head. Erased cells read as
+*			undefined values, so the records in use are found by blank checks; an interrupted record still uses its
+*			slot and does not check.
+* @param	ucRange, range index
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashCache_Replay(uint8_t ucRange)
+{
+	uint8_t aucRec[FLASHCACHE_REC_SIZE];
+	uint16_t uiSlots;
+	uint16_t uiSlot;
+	uint16_t uiSum;
+	uint16_t uiEnd;
+	uint8_t ucReturn;
+
+	ucReturn = FlashMan_FindFrontierDF(mFlashCache_SlotWr(ucRange, 0), FLASHCACHE_BLOCK_SLOTS * FLASHCACHE_REC_SIZE,
+										&uiEnd);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+	uiSlots = (uint16_t)((uiEnd + FLASHCACHE_REC_SIZE - 1) / FLASHCACHE_REC_SIZE);
+
+	memset(s_aucFlashCacheInHead, 0, sizeof(s_aucFlashCacheInHead));
+	for(uiSlot = 0; uiSlot < uiSlots; uiSlot++)
+	{
+		ucReturn = FlashMan_ReadDF(aucRec, mFlashCache_SlotRd(ucRange, uiSlot), FLASHCACHE_REC_SIZE);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		uiSum = (uint16_t)(aucRec[FLASHCACHE_REC_SIZE - 2] | ((uint16_t)aucRec[FLASHCACHE_REC_SIZE - 1] << 8));
+		if((aucRec[0] < FLASHCACHE_LINES) && (uiSum == FlashSum_Fletcher16(aucRec, FLASHCACHE_REC_SIZE - 2)))
+		{
+			memcpy(&s_aucFlashCache[aucRec[0] * FLASHCACHE_LINE_SIZE], &aucRec[1], FLASHCACHE_LINE_SIZE);
+			mFlashCache_Set(s_aucFlashCacheStored, aucRec[0]);
+			mFlashCache_Set(s_aucFlashCacheInHead, aucRec[0]);
+		}
+	}
+
+	s_ucFlashCacheHead = ucRange;
+	s_uiFlashCacheNext = uiSlots;
+
+	return 0;
+}
+
+/**
+* @brief	This function appends the record of a line of the mirror to the head
+* @param	uiLine, line
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashCache_Append(uint16_t uiLine)
+{
+	uint8_t aucRec[FLASHCACHE_REC_SIZE];
+	uint16_t uiSum;
+	uint8_t ucReturn;
+
+	aucRec[0] = (uint8_t)uiLine;
+	memcpy(&aucRec[1], &s_aucFlashCache[uiLine * FLASHCACHE_LINE_SIZE], FLASHCACHE_LINE_SIZE);
+	uiSum = FlashSum_Fletcher16(aucRec, FLASHCACHE_REC_SIZE - 2);
+	aucRec[FLASHCACHE_REC_SIZE - 2] = (uint8_t)uiSum;
+	aucRec[FLASHCACHE_REC_SIZE - 1] = (uint8_t)(uiSum >> 8);
+
+	ucReturn = FlashMan_WriteDF(aucRec, mFlashCache_SlotWr(s_ucFlashCacheHead, s_uiFlashCacheNext), FLASHCACHE_REC_SIZE);
+
+	//Even a failed record uses its cells
+	s_uiFlashCacheNext++;
+	if(ucReturn == 0)
+	{
+		mFlashCache_Set(s_aucFlashCacheStored, uiLine);
+		mFlashCache_Set(s_aucFlashCacheInHead, uiLine);
+		mFlashCache_Clear(s_aucFlashCacheDirty, uiLine);
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function finishes a move of the log: the stored lines whose newest record is in another block are
+*			copied to the head, then the other blocks of the log are retired
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+static uint8_t FlashCache_Settle(void)
+{
+	uint16_t uiLine;
+	uint16_t uiCopies = 0;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	for(uiLine = 0; uiLine < FLASHCACHE_LINES; uiLine++)
+	{
+		if(mFlashCache_Is(s_aucFlashCacheStored, uiLine) && !mFlashCache_Is(s_aucFlashCacheInHead, uiLine))
+		{
+			uiCopies++;
+		}
+	}
+	if((s_uiFlashCacheNext + uiCopies) > FLASHCACHE_BLOCK_SLOTS)
+	{
+		return FlashCache_Move();
+	}
+
+	for(uiLine = 0; uiLine < FLASHCACHE_LINES; uiLine++)
+	{
+		if(mFlashCache_Is(s_aucFlashCacheStored, uiLine) && !mFlashCache_Is(s_aucFlashCacheInHead, uiLine))
+		{
+			ucReturn = FlashCache_Append(uiLine);
+			if(ucReturn != 0)
+			{
+				return ucReturn;
+			}
+		}
+	}
+
+	//Once retired, the older records are not replayed whatever interrupts the erase of their block
+	for(i = 0; i < FLASHCACHE_BLOCKS; i++)
+	{
+		if((i != s_ucFlashCacheHead) && FlashCache_IsLogBlock(i))
+		{
+			ucReturn = FlashBlk_Retire(FLASHCACHE_BLOCK(i));
+			if(ucReturn != 0)
+			{
+				return ucReturn;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+* @brief	This function moves the log to the least worn free block of the range, with the next sequence number
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+static uint8_t FlashCache_Move(void)
+{
+	uint16_t uiSeq = (uint16_t)(FlashBlk_GetInfo(FLASHCACHE_BLOCK(s_ucFlashCacheHead))->uiSeq + 1);
+	uint8_t ucBlock;
+	uint8_t ucReturn;
+
+	ucReturn = FlashBlk_Alloc(FLASHCACHE_FIRST_BLOCK, FLASHCACHE_BLOCKS, &ucBlock);
+	if(ucReturn == 0)
+	{
+		ucReturn = FlashBlk_Activate(ucBlock, uiSeq);
+	}
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	s_ucFlashCacheHead = (uint8_t)(ucBlock - FLASHCACHE_FIRST_BLOCK);
+	s_uiFlashCacheNext = 0;
+	memset(s_aucFlashCacheInHead, 0, sizeof(s_aucFlashCacheInHead));
+
+	return FlashCache_Settle();
+}
+
+/**
+* @brief	This function loads the mirror from the log, replaying its blocks from the oldest to the newest one, and
+*			finishes a move interrupted by a power loss. It has to be called once at start up, after FlashManInit;
+*			a range without a log starts an empty one.
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashCache_Init(void)
+{
+	const FlashBlk_Info *ptInfo;
+	uint16_t uiDone = 0;
+	uint8_t ucBlocks = 0;
+	uint8_t ucNext;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	s_ucFlashCacheValid = 0;
+	memset(s_aucFlashCache, FLASHCACHE_FILL, sizeof(s_aucFlashCache));
+	memset(s_aucFlashCacheDirty, 0, sizeof(s_aucFlashCacheDirty));
+	memset(s_aucFlashCacheStored, 0, sizeof(s_aucFlashCacheStored));
+	memset(s_aucFlashCacheInHead, 0, sizeof(s_aucFlashCacheInHead));
+	s_uiFlashCacheIdle = 0;
+
+	ucReturn = FlashBlk_Mount();
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	//Oldest block first, so the newest record of every line is the one left in the mirror
+	for(;;)
+	{
+		ucNext = FLASHCACHE_NONE;
+		for(i = 0; i < FLASHCACHE_BLOCKS; i++)
+		{
+			ptInfo = FlashBlk_GetInfo(FLASHCACHE_BLOCK(i));
+			if(	FlashCache_IsLogBlock(i) && ((uiDone & (1U << i)) == 0)
+				&& (	(ucNext == FLASHCACHE_NONE)
+						|| ((int16_t)(ptInfo->uiSeq - FlashBlk_GetInfo(FLASHCACHE_BLOCK(ucNext))->uiSeq) < 0)))
+			{
+				ucNext = i;
+			}
+		}
+		if(ucNext == FLASHCACHE_NONE)
+		{
+			break;
+		}
+		ucReturn = FlashCache_Replay(ucNext);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		uiDone |= (uint16_t)(1U << ucNext);
+		ucBlocks++;
+	}
+
+	if(ucBlocks == 0)
+	{
+		ucReturn = FlashBlk_Alloc(FLASHCACHE_FIRST_BLOCK, FLASHCACHE_BLOCKS, &i);
+		if(ucReturn == 0)
+		{
+			ucReturn = FlashBlk_Activate(i, 0);
+		}
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		s_ucFlashCacheHead = (uint8_t)(i - FLASHCACHE_FIRST_BLOCK);
+		s_uiFlashCacheNext = 0;
+	}
+	else if(ucBlocks > 1)
+	{
+		ucReturn = FlashCache_Settle();
+	}
+	else
+	{
+		// Empty
+	}
+
+	if(ucReturn == 0)
+	{
+		s_ucFlashCacheValid = 1;
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function reads from the data flash, from the mirror for the cached range
+* @param	pucData, buffer
+* @param	ulAddr, read address (E2FLASHADDR_READBASE based)
+* @param	uiSize, number of bytes
+* @return	0 if OK, ERR_FLASHE2DATA_OUTRNG if the range is partially cached or in the log only,
+*			ERR_FLASHCACHE_NOTMOUNTED, Flash Manager error otherwise
+*/
+uint8_t FlashCache_Read(uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	if((ulAddr >= (FLASHCACHE_ADDR_RD + FLASHCACHE_AREA)) || ((ulAddr + uiSize) <= FLASHCACHE_ADDR_RD))
+	{
+		return FlashMan_ReadDF(pucData, ulAddr, uiSize);
+	}
+	if((ulAddr < FLASHCACHE_ADDR_RD) || ((ulAddr + uiSize) > (FLASHCACHE_ADDR_RD + FLASHCACHE_SIZE)))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	if(!s_ucFlashCacheValid)
+	{
+		return ERR_FLASHCACHE_NOTMOUNTED;
+	}
+
+	memcpy(pucData, &s_aucFlashCache[ulAddr - FLASHCACHE_ADDR_RD], uiSize);
+
+	return 0;
+}
+
+/**
+* @brief	This function writes to the data flash. For the cached range only the mirror is updated and the
+*			lines that change are marked dirty; they reach the data flash on the next write back.
+* @param	pucData, data
+* @param	ulAddr, write address (E2FLASHADDR_WRITEBASE based)
+* @param	uiSize, number of bytes
+* @return	0 if OK, ERR_FLASHE2DATA_OUTRNG if the range is partially cached or in the log only,
+*			ERR_FLASHCACHE_NOTMOUNTED, Flash Manager error otherwise
+*/
+uint8_t FlashCache_Write(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	uint16_t uiOffset;
+	uint16_t i;
+
+	if((ulAddr >= (FLASHCACHE_ADDR_WR + FLASHCACHE_AREA)) || ((ulAddr + uiSize) <= FLASHCACHE_ADDR_WR))
+	{
+		return FlashMan_WriteDF(pucData, ulAddr, uiSize);
+	}
+	if((ulAddr < FLASHCACHE_ADDR_WR) || ((ulAddr + uiSize) > (FLASHCACHE_ADDR_WR + FLASHCACHE_SIZE)))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+	if(!s_ucFlashCacheValid)
+	{
+		return ERR_FLASHCACHE_NOTMOUNTED;
+	}
+
+	uiOffset = (uint16_t)(ulAddr - FLASHCACHE_ADDR_WR);
+	for(i = 0; i < uiSize; i++, uiOffset++)
+	{
+		if(s_aucFlashCache[uiOffset] != pucData[i])
+		{
+			s_aucFlashCache[uiOffset] = pucData[i];
+			mFlashCache_Set(s_aucFlashCacheDirty, uiOffset / FLASHCACHE_LINE_SIZE);
+		}
+	}
+	s_uiFlashCacheIdle = 0;
+
+	return 0;
+}
+
+/**
+* @brief	This function writes back the dirty lines of the mirror: one record of FLASHCACHE_REC_SIZE bytes each,
+*			plus a move of the log when the head has no room left for them
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise (ERR_FLASHE2DATA_BUSY during an asynchronous
+*			operation). The lines not written back stay dirty.
+*/
+uint8_t FlashCache_Flush(void)
+{
+	uint16_t uiLine;
+	uint16_t uiDirty = 0;
+	uint8_t ucReturn;
+
+	for(uiLine = 0; uiLine < FLASHCACHE_LINES; uiLine++)
+	{
+		if(mFlashCache_Is(s_aucFlashCacheDirty, uiLine))
+		{
+			uiDirty++;
+		}
+	}
+	if(uiDirty == 0)
+	{
+		return 0;
+	}
+
+	//The move writes back the dirty lines already stored
+	if((s_uiFlashCacheNext + uiDirty) > FLASHCACHE_BLOCK_SLOTS)
+	{
+		ucReturn = FlashCache_Move();
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+
+	for(uiLine = 0; uiLine < FLASHCACHE_LINES; uiLine++)
+	{
+		if(mFlashCache_Is(s_aucFlashCacheDirty, uiLine))
+		{
+			ucReturn = FlashCache_Append(uiLine);
+			if(ucReturn != 0)
+			{
+				return ucReturn;
+			}
+		}
+	}
+	s_uiFlashCacheIdle = 0;
+
+	return 0;
+}
+
+/**
+* @brief	This function has to be called periodically; the mirror is written back once it has been dirty and
+*			without writes for FLASHCACHE_IDLE_TICKS calls
+* @param	none
+* @return	0 if OK, error of FlashCache_Flush otherwise
+*/
+uint8_t FlashCache_Tick(void)
+{
+	if((FLASHCACHE_IDLE_TICKS == 0) || !FlashCache_IsDirty())
+	{
+		return 0;
+	}
+
+	if(++s_uiFlashCacheIdle < FLASHCACHE_IDLE_TICKS)
+	{
+		return 0;
+	}
+
+	return FlashCache_Flush();
+}
+
+/**
+* @brief	This function has to be called on a power fail warning: the dirty lines are written back at once
+* @param	none
+* @return	0 if OK, error of FlashCache_Flush otherwise
+*/
+uint8_t FlashCache_PowerFail(void)
+{
+	return FlashCache_Flush();
+}
+
+/**
+* @brief	This function tells whether the mirror has data not yet written back
+* @param	none
+* @return	1 if dirty, 0 otherwise
+*/
+uint8_t FlashCache_IsDirty(void)
+{
+	uint16_t i;
+
+	for(i = 0; i < sizeof(s_aucFlashCacheDirty); i++)
+	{
+		if(s_aucFlashCacheDirty[i] != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
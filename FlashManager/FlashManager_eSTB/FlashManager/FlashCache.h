@@ -0,0 +1,73 @@
+/**
+* @brief The Flash Cache module keeps a RAM mirror of FLASHCACHE_SIZE bytes of parameters stored in a range of data
+* flash blocks. Reads of the mirror are served from RAM and writes only update RAM and mark the changed lines dirty;
+* the dirty lines are written back on FlashCache_Flush, after FLASHCACHE_IDLE_TICKS calls to FlashCache_Tick without
+* writes, or on FlashCache_PowerFail. A write back only appends the dirty lines to a log in the blocks of the range,
+* so a power loss during it costs at most the lines not yet appended, never the ones already stored. Addresses
+* outside of the blocks of the range go straight to the Flash Manager module.
+* The blocks FLASHCACHE_FIRST_BLOCK .. FLASHCACHE_FIRST_BLOCK + FLASHCACHE_BLOCKS - 1 must not be used by any other
+* module; their headers are kept by the Flash Block module.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHCACHE_H__
+#define __FLASHCACHE_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+#include "FlashBlock.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Blocks of the log, 2 at least: the log moves to another block when the active one is full
+#ifndef FLASHCACHE_FIRST_BLOCK
+#define FLASHCACHE_FIRST_BLOCK	0
+#endif
+#ifndef FLASHCACHE_BLOCKS
+#define FLASHCACHE_BLOCKS		2
+#endif
+
+//Write back granularity
+#ifndef FLASHCACHE_LINE_SIZE
+#define FLASHCACHE_LINE_SIZE	16
+#endif
+
+//Bytes mirrored, a whole number of lines; all of them must fit in half a block of the log
+#ifndef FLASHCACHE_SIZE
+#define FLASHCACHE_SIZE			256
+#endif
+
+//Value of the bytes of a line never written
+#define FLASHCACHE_FILL			0xFF
+
+//FlashCache_Tick calls without writes before the dirty lines are written back, 0 disables it
+#ifndef FLASHCACHE_IDLE_TICKS
+#define FLASHCACHE_IDLE_TICKS	100
+#endif
+
+//The mirror is addressed as the first FLASHCACHE_SIZE bytes of the range, the rest of the range is not accessible
+#define FLASHCACHE_AREA			( FLASHCACHE_BLOCKS * FLASHMAN_BLOCK_SIZE )
+#define FLASHCACHE_ADDR_RD		( FLASHMAN_BLOCK_ADDR_RD + (FLASHCACHE_FIRST_BLOCK * FLASHMAN_BLOCK_SIZE) )
+#define FLASHCACHE_ADDR_WR		( FLASHMAN_BLOCK_ADDR_WR + (FLASHCACHE_FIRST_BLOCK * FLASHMAN_BLOCK_SIZE) )
+
+//Errors, the Flash Manager and Flash Block ones are passed through
+#define ERR_FLASHCACHE_NOTMOUNTED	0x70
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint8_t FlashCache_Init(void);
+uint8_t FlashCache_Read(uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+uint8_t FlashCache_Write(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+uint8_t FlashCache_Flush(void);
+uint8_t FlashCache_Tick(void);
+uint8_t FlashCache_PowerFail(void);
+uint8_t FlashCache_IsDirty(void);
+
+
+#endif // __FLASHCACHE_H__
@@ -0,0 +1,161 @@
+/**
+* @brief The Flash Codec module packs and unpacks records, see FlashCodec.h.
+* Packing is greedy: a run of FLASHCODEC_RUN_MIN or more equal bytes is always coded as a run, everything else is
+* gathered in literal blocks. A run of two costs as much either way and is kept in the literals around it.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashCodec.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHCODEC_RUN			0x80	//Control byte of a run
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static uint8_t FlashCodec_Literals(const uint8_t *pucSrc, uint16_t uiFrom, uint16_t uiTo, uint8_t *pucDst,
+									uint16_t *puiOut, uint16_t uiMax);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function codes the bytes uiFrom .. uiTo - 1 as literal blocks
+* @param	pucSrc, data
+* @param	uiFrom, first byte
+* @param	uiTo, end of the bytes
+* @param	pucDst, packed data
+* @param	puiOut, bytes of pucDst in use, updated
+* @param	uiMax, size of pucDst
+* @return	1 if OK, 0 if pucDst is too small
+*/
+static uint8_t FlashCodec_Literals(const uint8_t *pucSrc, uint16_t uiFrom, uint16_t uiTo, uint8_t *pucDst,
+									uint16_t *puiOut, uint16_t uiMax)
+{
+	uint16_t uiCount;
+
+	while(uiFrom < uiTo)
+	{
+		uiCount = (uint16_t)(uiTo - uiFrom);
+		if(uiCount > FLASHCODEC_LIT_MAX)
+		{
+			uiCount = FLASHCODEC_LIT_MAX;
+		}
+		if(((uint32_t)*puiOut + 1 + uiCount) > uiMax)
+		{
+			return 0;
+		}
+
+		pucDst[(*puiOut)++] = (uint8_t)(uiCount - 1);
+		while(uiCount-- != 0)
+		{
+			pucDst[(*puiOut)++] = pucSrc[uiFrom++];
+		}
+	}
+
+	return 1;
+}
+
+/**
+* @brief	This function packs a record
+* @param	pucSrc, record
+* @param	uiSize, record size
+* @param	pucDst, packed record, mFlashCodec_MaxPacked(uiSize) bytes are always enough
+* @param	uiMax, size of pucDst. Packing stops as soon as it is exceeded, so a caller that only stores packed
+*			records smaller than the original passes uiSize - 1.
+* @return	packed size, 0 if it does not fit in uiMax bytes (or uiSize is 0)
+*/
+uint16_t FlashCodec_Pack(const uint8_t *pucSrc, uint16_t uiSize, uint8_t *pucDst, uint16_t uiMax)
+{
+	uint16_t uiIn = 0;
+	uint16_t uiOut = 0;
+	uint16_t uiLit = 0;		//First byte not coded yet
+	uint16_t uiRun;
+
+	while(uiIn < uiSize)
+	{
+		for(uiRun = 1; ((uiIn + uiRun) < uiSize) && (uiRun < FLASHCODEC_RUN_MAX)
+						&& (pucSrc[uiIn + uiRun] == pucSrc[uiIn]); uiRun++)
+		{
+		}
+
+		if(uiRun >= FLASHCODEC_RUN_MIN)
+		{
+			if(	(FlashCodec_Literals(pucSrc, uiLit, uiIn, pucDst, &uiOut, uiMax) == 0)
+				|| ((uiOut + 2U) > uiMax))
+			{
+				return 0;
+			}
+			pucDst[uiOut++] = (uint8_t)(FLASHCODEC_RUN | (uiRun - FLASHCODEC_RUN_MIN));
+			pucDst[uiOut++] = pucSrc[uiIn];
+			uiLit = (uint16_t)(uiIn + uiRun);
+		}
+
+		uiIn = (uint16_t)(uiIn + uiRun);
+	}
+
+	if(FlashCodec_Literals(pucSrc, uiLit, uiSize, pucDst, &uiOut, uiMax) == 0)
+	{
+		return 0;
+	}
+
+	return uiOut;
+}
+
+/**
+* @brief	This function unpacks a record packed by FlashCodec_Pack
+* @param	pucSrc, packed record
+* @param	uiSize, packed size
+* @param	pucDst, record
+* @param	uiMax, size of pucDst
+* @return	record size, 0 if the packed data is not valid or the record does not fit in uiMax bytes
+*/
+uint16_t FlashCodec_Unpack(const uint8_t *pucSrc, uint16_t uiSize, uint8_t *pucDst, uint16_t uiMax)
+{
+	uint16_t uiIn = 0;
+	uint16_t uiOut = 0;
+	uint16_t uiCount;
+	uint8_t ucCtrl;
+
+	while(uiIn < uiSize)
+	{
+		ucCtrl = pucSrc[uiIn++];
+		if((ucCtrl & FLASHCODEC_RUN) != 0)
+		{
+			uiCount = (uint16_t)((ucCtrl & ~FLASHCODEC_RUN) + FLASHCODEC_RUN_MIN);
+			if((uiIn >= uiSize) || (((uint32_t)uiOut + uiCount) > uiMax))
+			{
+				return 0;
+			}
+			while(uiCount-- != 0)
+			{
+				pucDst[uiOut++] = pucSrc[uiIn];
+			}
+			uiIn++;
+		}
+		else
+		{
+			uiCount = (uint16_t)(ucCtrl + 1);
+			if((((uint32_t)uiIn + uiCount) > uiSize) || (((uint32_t)uiOut + uiCount) > uiMax))
+			{
+				return 0;
+			}
+			while(uiCount-- != 0)
+			{
+				pucDst[uiOut++] = pucSrc[uiIn++];
+			}
+		}
+	}
+
+	return uiOut;
+}
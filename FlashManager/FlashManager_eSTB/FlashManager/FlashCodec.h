@@ -0,0 +1,37 @@
+/**
+* @brief The Flash Codec module packs records before they are programmed, so data with runs of equal bytes (zeros,
+* 0xFF fill, repeated fields) costs fewer program commands. The format is a byte oriented run length code:
+*	0x00 .. 0x7F	n + 1 literal bytes follow
+*	0x80 .. 0xFF	run of (n & 0x7F) + FLASHCODEC_RUN_MIN copies of the next byte
+* Packing and unpacking only use the buffers of the caller: no state, no heap.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHCODEC_H__
+#define __FLASHCODEC_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHCODEC_RUN_MIN		3		//Shorter runs are kept as literals
+#define FLASHCODEC_RUN_MAX		( 0x7F + FLASHCODEC_RUN_MIN )
+#define FLASHCODEC_LIT_MAX		0x80
+
+//Largest packed size of uiSize bytes (no run at all)
+#define mFlashCodec_MaxPacked(uiSize)	( (uiSize) + (((uiSize) + FLASHCODEC_LIT_MAX - 1) / FLASHCODEC_LIT_MAX) )
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint16_t FlashCodec_Pack(const uint8_t *pucSrc, uint16_t uiSize, uint8_t *pucDst, uint16_t uiMax);
+uint16_t FlashCodec_Unpack(const uint8_t *pucSrc, uint16_t uiSize, uint8_t *pucDst, uint16_t uiMax);
+
+
+#endif // __FLASHCODEC_H__
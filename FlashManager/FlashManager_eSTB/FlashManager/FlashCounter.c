@@ -0,0 +1,280 @@
+/**
+* @brief The Flash Counter module keeps monotonic counters in the data flash, see FlashCounter.h.
+*
+* Data flash layout, per FLASHMAN_BLOCK_SIZE block:
+*	header	FLASHBLK_HDR_SIZE bytes kept by the Flash Block module (state, sequence number, erase count)
+*	base	[value, 4 bytes little endian][~value, 4 bytes]
+*	tally	FLASHCNT_SLOTS bytes, programmed from the first one on, one per unit added
+* The value of a counter is the base of its active block plus the slots programmed. The slots in use are found with
+* a binary search over blank checks, as erased cells read as undefined values.
+* A fold activates the other block with the next sequence number, programs the new base and then retires the old
+* block, which is erased by the next fold. At mount the block with a valid base and the highest sequence number wins,
+* so a fold interrupted at any point leaves either the old or the new value; an interrupted tally program may count
+* that unit or not.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashCounter.h"
+#include "FlashBlock.h"
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHCNT_BASE_SIZE		8
+#define FLASHCNT_OFS_BASE		FLASHBLK_HDR_SIZE
+#define FLASHCNT_OFS_TALLY		( FLASHCNT_OFS_BASE + FLASHCNT_BASE_SIZE )
+#define FLASHCNT_SLOTS			( FLASHMAN_BLOCK_SIZE - FLASHCNT_OFS_TALLY )
+
+#define mFlashCnt_Block(ucCounter, ucHalf)	( (uint8_t)(FLASHCNT_FIRST_BLOCK + ((ucCounter) * 2) + (ucHalf)) )
+
+typedef char FlashCnt_CheckBlocks[(	(FLASHCNT_COUNTERS > 0)
+									&& ((FLASHCNT_FIRST_BLOCK + (2 * FLASHCNT_COUNTERS)) <= FLASHMAN_BLOCK_NUM)) ? 1 : -1];
+typedef char FlashCnt_CheckTally[((FLASHCNT_TALLY_MAX > 0) && (FLASHCNT_TALLY_MAX <= FLASHCNT_SLOTS)) ? 1 : -1];
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+typedef struct
+{
+	uint32_t ulBase;				//Base of the active block
+	uint16_t uiTally;				//Tally slots programmed
+	uint8_t ucBlock;				//Active block
+} FlashCnt_Counter;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static FlashCnt_Counter s_atFlashCnt[FLASHCNT_COUNTERS];
+static uint8_t s_ucFlashCntMounted = 0;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static uint8_t FlashCnt_ReadBase(uint8_t ucBlock, uint32_t *pulBase);
+static uint8_t FlashCnt_Load(uint8_t ucCounter);
+static uint8_t FlashCnt_Fold(uint8_t ucCounter, uint32_t ulBase);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function reads and checks the base of a block that holds a counter
+* @param	ucBlock, block index
+* @param	pulBase, base value
+* @return	1 if the block is ACTIVE and its base checks, 0 otherwise
+*/
+static uint8_t FlashCnt_ReadBase(uint8_t ucBlock, uint32_t *pulBase)
+{
+	const FlashBlk_Info *ptInfo = FlashBlk_GetInfo(ucBlock);
+	uint8_t aucBase[FLASHCNT_BASE_SIZE];
+	uint32_t ulCheck;
+
+	if(ptInfo->ucState != FLASHBLK_ST_ACTIVE)
+	{
+		return 0;
+	}
+	if(FlashMan_ReadDF(aucBase, mFlashMan_BlockAddrRd(ucBlock) + FLASHCNT_OFS_BASE, FLASHCNT_BASE_SIZE) != 0)
+	{
+		return 0;
+	}
+
+	*pulBase = (uint32_t)aucBase[0] | ((uint32_t)aucBase[1] << 8) | ((uint32_t)aucBase[2] << 16)
+				| ((uint32_t)aucBase[3] << 24);
+	ulCheck = (uint32_t)aucBase[4] | ((uint32_t)aucBase[5] << 8) | ((uint32_t)aucBase[6] << 16)
+				| ((uint32_t)aucBase[7] << 24);
+
+	return (uint8_t)(*pulBase == ~ulCheck);
+}
+
+/**
+* @brief	This function finds the active block of a counter and the tally slots in use. A counter without a
+*			valid block starts from 0.
+* @param	ucCounter, counter index
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+static uint8_t FlashCnt_Load(uint8_t ucCounter)
+{
+	FlashCnt_Counter *ptCnt = &s_atFlashCnt[ucCounter];
+	uint8_t ucBlock;
+	uint8_t ucFound = 0;
+	uint32_t ulBase;
+	uint8_t i;
+
+	for(i = 0; i < 2; i++)
+	{
+		ucBlock = mFlashCnt_Block(ucCounter, i);
+		if(	FlashCnt_ReadBase(ucBlock, &ulBase)
+			&& (!ucFound || ((int16_t)(FlashBlk_GetInfo(ucBlock)->uiSeq - FlashBlk_GetInfo(ptCnt->ucBlock)->uiSeq) > 0)))
+		{
+			ptCnt->ucBlock = ucBlock;
+			ptCnt->ulBase = ulBase;
+			ucFound = 1;
+		}
+	}
+
+	if(!ucFound)
+	{
+		ptCnt->ucBlock = mFlashCnt_Block(ucCounter, 1);
+		return FlashCnt_Fold(ucCounter, 0);
+	}
+
+	return FlashMan_FindFrontierDF(mFlashMan_BlockAddrWr(ptCnt->ucBlock) + FLASHCNT_OFS_TALLY, FLASHCNT_SLOTS,
+									&ptCnt->uiTally);
+}
+
+/**
+* @brief	This function moves a counter to its other block with a new base value and no tally
+* @param	ucCounter, counter index
+* @param	ulBase, new base value
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+static uint8_t FlashCnt_Fold(uint8_t ucCounter, uint32_t ulBase)
+{
+	FlashCnt_Counter *ptCnt = &s_atFlashCnt[ucCounter];
+	uint8_t ucOld = ptCnt->ucBlock;
+	uint8_t ucNew;
+	uint8_t aucBase[FLASHCNT_BASE_SIZE];
+	uint8_t ucReturn;
+	uint8_t i;
+
+	//Block pairs start at an even offset from FLASHCNT_FIRST_BLOCK
+	ucNew = (uint8_t)(((ucOld - FLASHCNT_FIRST_BLOCK) & 1U) ? (ucOld - 1) : (ucOld + 1));
+
+	ucReturn = FlashBlk_Activate(ucNew, (uint16_t)(FlashBlk_GetInfo(ucOld)->uiSeq + 1));
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	for(i = 0; i < 4; i++)
+	{
+		aucBase[i] = (uint8_t)(ulBase >> (8 * i));
+		aucBase[4 + i] = (uint8_t)~aucBase[i];
+	}
+	ucReturn = FlashMan_WriteDF(aucBase, mFlashMan_BlockAddrWr(ucNew) + FLASHCNT_OFS_BASE, FLASHCNT_BASE_SIZE);
+	if(ucReturn != 0)
+	{
+		//The new block does not check and is erased again by the next fold
+		return ucReturn;
+	}
+
+	ptCnt->ucBlock = ucNew;
+	ptCnt->ulBase = ulBase;
+	ptCnt->uiTally = 0;
+
+	//The old value must not come back, whatever happens before the old block is erased
+	return FlashBlk_Retire(ucOld);
+}
+
+/**
+* @brief	This function finds the counters from the block headers and a binary search of their tally. It has
+*			to be called once at start up, after FlashManInit; counters never written start from 0.
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashCnt_Mount(void)
+{
+	uint8_t ucReturn;
+	uint8_t i;
+
+	s_ucFlashCntMounted = 0;
+
+	ucReturn = FlashBlk_Mount();
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	for(i = 0; i < FLASHCNT_COUNTERS; i++)
+	{
+		ucReturn = FlashCnt_Load(i);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+
+	s_ucFlashCntMounted = 1;
+
+	return 0;
+}
+
+/**
+* @brief	This function gives the value of a counter
+* @param	ucCounter, counter index
+* @param	pulValue, value
+* @return	0 if OK, ERR_FLASHCNT_xxx otherwise
+*/
+uint8_t FlashCnt_Get(uint8_t ucCounter, uint32_t *pulValue)
+{
+	if(!s_ucFlashCntMounted)
+	{
+		return ERR_FLASHCNT_NOTMOUNTED;
+	}
+	if(ucCounter >= FLASHCNT_COUNTERS)
+	{
+		return ERR_FLASHCNT_PARAM;
+	}
+
+	*pulValue = s_atFlashCnt[ucCounter].ulBase + s_atFlashCnt[ucCounter].uiTally;
+
+	return 0;
+}
+
+/**
+* @brief	This function adds to a counter. Up to FLASHCNT_TALLY_MAX is added by programming as many tally slots;
+*			a bigger amount, or one that does not fit in the slots left, folds the counter into its other block.
+* @param	ucCounter, counter index
+* @param	ulAmount, amount to add
+* @return	0 if OK, ERR_FLASHCNT_xxx, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashCnt_Add(uint8_t ucCounter, uint32_t ulAmount)
+{
+	static const uint8_t s_aucMarks[FLASHCNT_TALLY_MAX] = { 0 };	//Any value marks a slot as used
+	FlashCnt_Counter *ptCnt;
+	uint32_t ulValue;
+	uint8_t ucReturn;
+
+	if(!s_ucFlashCntMounted)
+	{
+		return ERR_FLASHCNT_NOTMOUNTED;
+	}
+	if(ucCounter >= FLASHCNT_COUNTERS)
+	{
+		return ERR_FLASHCNT_PARAM;
+	}
+	ptCnt = &s_atFlashCnt[ucCounter];
+	ulValue = ptCnt->ulBase + ptCnt->uiTally;
+	if((ulValue + ulAmount) < ulValue)
+	{
+		return ERR_FLASHCNT_OVERFLOW;
+	}
+	if(ulAmount == 0)
+	{
+		return 0;
+	}
+
+	if((ulAmount > FLASHCNT_TALLY_MAX) || ((ptCnt->uiTally + ulAmount) > FLASHCNT_SLOTS))
+	{
+		return FlashCnt_Fold(ucCounter, ulValue + ulAmount);
+	}
+
+	ucReturn = FlashMan_WriteDF(s_aucMarks, mFlashMan_BlockAddrWr(ptCnt->ucBlock) + FLASHCNT_OFS_TALLY + ptCnt->uiTally,
+								(uint16_t)ulAmount);
+
+	//Even failed slots are used, and may have been counted by the next mount
+	ptCnt->uiTally = (uint16_t)(ptCnt->uiTally + ulAmount);
+
+	return ucReturn;
+}
@@ -0,0 +1,50 @@
+/**
+* @brief The Flash Counter module keeps monotonic counters (operating hours, cycles) in the data flash without
+* rewriting them: every counter owns two blocks, and the active one holds a base value followed by tally slots.
+* An increment programs the next slot, so it costs one byte program; only when the slots run out is the value
+* folded into the base of the other block, which is the only time a block is erased.
+* The blocks FLASHCNT_FIRST_BLOCK .. FLASHCNT_FIRST_BLOCK + 2 * FLASHCNT_COUNTERS - 1 must not be used by any other
+* module; their headers are kept by the Flash Block module.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHCOUNTER_H__
+#define __FLASHCOUNTER_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Counters, two blocks each from FLASHCNT_FIRST_BLOCK on
+#ifndef FLASHCNT_COUNTERS
+#define FLASHCNT_COUNTERS		2
+#endif
+#ifndef FLASHCNT_FIRST_BLOCK
+#define FLASHCNT_FIRST_BLOCK	( FLASHMAN_BLOCK_NUM - (2 * FLASHCNT_COUNTERS) )
+#endif
+
+//Largest amount added with tally slots, bigger ones are folded into the base at once
+#ifndef FLASHCNT_TALLY_MAX
+#define FLASHCNT_TALLY_MAX		8
+#endif
+
+//Errors, the Flash Manager and Flash Block ones are passed through
+#define ERR_FLASHCNT_NOTMOUNTED	0x40
+#define ERR_FLASHCNT_PARAM		0x41	//Counter out of range
+#define ERR_FLASHCNT_OVERFLOW	0x42	//The value would wrap around
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint8_t FlashCnt_Mount(void);
+uint8_t FlashCnt_Get(uint8_t ucCounter, uint32_t *pulValue);
+uint8_t FlashCnt_Add(uint8_t ucCounter, uint32_t ulAmount);
+
+
+#endif // __FLASHCOUNTER_H__
@@ -0,0 +1,668 @@
+/**
+* @brief The Flash EEPROM module emulates a byte addressable E2PROM on top of the Flash Manager module.
+*
+* Data flash layout, per FLASHMAN_BLOCK_SIZE block:
+*	header	FLASHBLK_HDR_SIZE bytes kept by the Flash Block module (state, sequence number, erase count)
+*	records	[key L][key H][len][data 0 .. len-1][sum L][sum H], sum = Fletcher-16 of key, len and data
+* With FLASHEEP_CODEC defined, a value that FlashCodec_Pack makes smaller is stored packed, flagged by
+* FLASHEEP_LEN_PACKED in len, and unpacked on read.
+* The blocks holding the log form a chain of consecutive sequence numbers in ring order, from the oldest (tail)
+* to the active one (head). The rest are spare blocks. An update only programs one record; a block is only erased
+* when the tail is reclaimed, so all blocks go through the same number of erase cycles.
+* Mounting only reads the block headers. The RAM index of the keys is built from the records on the first read or
+* write, so the start up time does not depend on the amount of data stored.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashEeprom.h"
+#include "FlashBlock.h"
+#include "FlashManager.h"
+#include "FlashSum.h"
+#ifdef FLASHEEP_CODEC
+#include "FlashCodec.h"
+#endif
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHEEP_HDR_SIZE		FLASHBLK_HDR_SIZE
+#define FLASHEEP_REC_HDR		3		//key + len
+#define FLASHEEP_REC_OVH		5		//key + len + sum
+#define FLASHEEP_NO_LOC			0xFFFF	//Key without record
+
+//Stored data size of a record from its len byte
+#ifdef FLASHEEP_CODEC
+#define FLASHEEP_LEN_PACKED		0x80	//Data packed by FlashCodec_Pack
+#define mFlashEep_DataLen(ucLen)	( (uint8_t)((ucLen) & ~FLASHEEP_LEN_PACKED) )
+#else
+#define mFlashEep_DataLen(ucLen)	(ucLen)
+#endif
+
+#define FLASHEEP_BLOCK_WR(b)	mFlashMan_BlockAddrWr(b)
+#define FLASHEEP_NEXT(b)		( (uint8_t)(((b) + 1) % FLASHMAN_BLOCK_NUM) )
+#define FLASHEEP_PREV(b)		( (uint8_t)(((b) + FLASHMAN_BLOCK_NUM - 1) % FLASHMAN_BLOCK_NUM) )
+
+//The live data of every key must fit in the blocks of the chain but one
+typedef char FlashEep_CheckCapacity[((uint32_t)FLASHEEP_MAX_KEYS * (FLASHEEP_MAX_DATA + FLASHEEP_REC_OVH)
+										< ((uint32_t)(FLASHMAN_BLOCK_NUM - 2) * (FLASHMAN_BLOCK_SIZE - FLASHEEP_HDR_SIZE))) ? 1 : -1];
+#ifdef FLASHEEP_CODEC
+typedef char FlashEep_CheckLen[(FLASHEEP_MAX_DATA < FLASHEEP_LEN_PACKED) ? 1 : -1];
+#endif
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static uint16_t s_auiFlashEepLoc[FLASHEEP_MAX_KEYS];	//Area offset of the last record of each key
+static uint8_t s_ucFlashEepMounted = 0;
+static uint8_t s_ucFlashEepIndexed = 0;					//s_auiFlashEepLoc and s_uiFlashEepOffset built
+static uint8_t s_ucFlashEepHead;						//Active block
+static uint8_t s_ucFlashEepTail;						//Oldest block of the log
+static uint8_t s_ucFlashEepUsed;						//Blocks in the log
+static uint16_t s_uiFlashEepSeq;						//Sequence number of the active block
+static uint16_t s_uiFlashEepOffset;						//Next free offset in the active block
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static uint8_t FlashEep_ReadRecord(uint16_t uiLoc, uint8_t *pucRec);
+static uint8_t FlashEep_Seal(uint16_t uiLoc, uint16_t uiFrom);
+static uint8_t FlashEep_ScanBlock(uint8_t ucBlock, uint8_t ucReclaim, uint16_t *puiEnd);
+static uint8_t FlashEep_OpenBlock(uint8_t ucBlock, uint16_t uiSeq);
+static uint8_t FlashEep_Append(const uint8_t *pucRec, uint8_t ucSize);
+static uint8_t FlashEep_MakeRoom(uint8_t ucSize);
+static uint8_t FlashEep_Index(void);
+static uint8_t FlashEep_IsLogBlock(const FlashBlk_Info *ptInfo);
+#ifdef FLASHEEP_CODEC
+static uint8_t FlashEep_ReadPacked(uint16_t uiLoc, uint8_t ucLen, uint8_t *pucData, uint8_t ucSize);
+#endif
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function tells if a block holds part of a log
+* @param	ptInfo, block header
+* @return	1 if the block is ACTIVE or FULL, 0 otherwise
+*/
+static uint8_t FlashEep_IsLogBlock(const FlashBlk_Info *ptInfo)
+{
+	return (uint8_t)((ptInfo->ucState == FLASHBLK_ST_ACTIVE) || (ptInfo->ucState == FLASHBLK_ST_FULL));
+}
+
+/**
+* @brief	This function reads and checks the record at uiLoc
+* @param	uiLoc, area offset of the record
+* @param	pucRec, buffer of FLASHEEP_MAX_DATA + FLASHEEP_REC_OVH bytes
+* @return	record size if it is valid, 0 otherwise
+*/
+static uint8_t FlashEep_ReadRecord(uint16_t uiLoc, uint8_t *pucRec)
+{
+	uint16_t uiKey;
+	uint8_t ucSize;
+	uint16_t uiSum;
+
+	if(FlashMan_ReadDF(pucRec, FLASHMAN_BLOCK_ADDR_RD + uiLoc, FLASHEEP_REC_HDR) != 0)
+	{
+		return 0;
+	}
+
+	uiKey = (uint16_t)(pucRec[0] | ((uint16_t)pucRec[1] << 8));
+	ucSize = (uint8_t)(FLASHEEP_REC_OVH + mFlashEep_DataLen(pucRec[2]));
+	if(	(uiKey >= FLASHEEP_MAX_KEYS) || (mFlashEep_DataLen(pucRec[2]) > FLASHEEP_MAX_DATA)
+		|| (((uiLoc % FLASHMAN_BLOCK_SIZE) + ucSize) > FLASHMAN_BLOCK_SIZE))
+	{
+		return 0;
+	}
+
+	if(FlashMan_ReadDF(&pucRec[FLASHEEP_REC_HDR], FLASHMAN_BLOCK_ADDR_RD + uiLoc + FLASHEEP_REC_HDR,
+						(uint16_t)(ucSize - FLASHEEP_REC_HDR)) != 0)
+	{
+		return 0;
+	}
+
+	uiSum = (uint16_t)(pucRec[ucSize - 2] | ((uint16_t)pucRec[ucSize - 1] << 8));
+	if(uiSum != FlashSum_Fletcher16(pucRec, (uint16_t)(ucSize - 2)))
+	{
+		return 0;
+	}
+
+	return ucSize;
+}
+
+/**
+* @brief	This function seals the record cut by a power loss at the end of the active block: its cells from the write
+*			frontier on, a cell programmed too weakly to fail the blank check included, are programmed with zeros up
+*			to the largest record size. The record then reads the same at every later scan, which no longer stops at
+*			the frontier once the block is full, and a half written value cannot come back later.
+* @param	uiLoc, area offset of the record
+* @param	uiFrom, area offset of the write frontier
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashEep_Seal(uint16_t uiLoc, uint16_t uiFrom)
+{
+	static const uint8_t s_aucZero[FLASHEEP_MAX_DATA + FLASHEEP_REC_OVH] = { 0 };
+	uint16_t uiTo = (uint16_t)(uiLoc + sizeof(s_aucZero));
+	uint16_t uiBlockEnd = (uint16_t)((uiLoc - (uiLoc % FLASHMAN_BLOCK_SIZE)) + FLASHMAN_BLOCK_SIZE);
+
+	uiTo = (uiTo > uiBlockEnd) ? uiBlockEnd : uiTo;
+	if(uiFrom >= uiTo)
+	{
+		return 0;
+	}
+
+	return FlashMan_WriteDF(s_aucZero, FLASHMAN_BLOCK_ADDR_WR + uiFrom, (uint16_t)(uiTo - uiFrom));
+}
+
+/**
+* @brief	This function walks the records of a block. At mount time it indexes them; when reclaiming it copies
+*			the ones still live to the active block. Only the active block can end with an interrupted record,
+*			so only its write frontier is searched, unless its header already marks it as full; such a record is
+*			sealed (FlashEep_Seal) and taken as valid only if it checks after that.
+* @param	ucBlock, block index
+* @param	ucReclaim, 0 to index the records, 1 to copy the live ones
+* @param	puiEnd, for the active block, offset of the first erased byte, FLASHMAN_BLOCK_SIZE if a record
+*			does not check (e.g. interrupted program) and nothing more must be appended to the block
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashEep_ScanBlock(uint8_t ucBlock, uint8_t ucReclaim, uint16_t *puiEnd)
+{
+	uint8_t aucRec[FLASHEEP_MAX_DATA + FLASHEEP_REC_OVH];
+	uint16_t uiOffset = FLASHEEP_HDR_SIZE;
+	uint16_t uiLoc;
+	uint16_t uiKey;
+	uint8_t ucSize;
+	uint8_t ucReturn = 0;
+
+	*puiEnd = FLASHMAN_BLOCK_SIZE;
+	if((ucBlock == s_ucFlashEepHead) && (FlashBlk_GetInfo(ucBlock)->ucState == FLASHBLK_ST_ACTIVE))
+	{
+		//Erased cells read as undefined values, the end of the log is found by blank checks; they start after
+		//the header, whose unused slots are erased
+		ucReturn = FlashMan_FindFrontierDF(FLASHEEP_BLOCK_WR(ucBlock) + FLASHEEP_HDR_SIZE,
+											FLASHMAN_BLOCK_SIZE - FLASHEEP_HDR_SIZE, puiEnd);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		*puiEnd = (uint16_t)(*puiEnd + FLASHEEP_HDR_SIZE);
+	}
+
+	//A full block ends with a gap smaller than a record, which does not check
+	while(uiOffset < *puiEnd)
+	{
+		uiLoc = (uint16_t)((ucBlock * FLASHMAN_BLOCK_SIZE) + uiOffset);
+		ucSize = FlashEep_ReadRecord(uiLoc, aucRec);
+		if((ucSize == 0) || ((uiOffset + ucSize) > *puiEnd))
+		{
+			if(*puiEnd < FLASHMAN_BLOCK_SIZE)
+			{
+				ucReturn = FlashEep_Seal(uiLoc, (uint16_t)((ucBlock * FLASHMAN_BLOCK_SIZE) + *puiEnd));
+				ucSize = (ucReturn == 0) ? FlashEep_ReadRecord(uiLoc, aucRec) : 0;
+				if((ucSize != 0) && (ucReclaim == 0))
+				{
+					s_auiFlashEepLoc[(uint16_t)(aucRec[0] | ((uint16_t)aucRec[1] << 8))] = uiLoc;
+				}
+			}
+			*puiEnd = FLASHMAN_BLOCK_SIZE;
+			break;
+		}
+
+		uiKey = (uint16_t)(aucRec[0] | ((uint16_t)aucRec[1] << 8));
+		if(ucReclaim == 0)
+		{
+			s_auiFlashEepLoc[uiKey] = uiLoc;
+		}
+		else if(s_auiFlashEepLoc[uiKey] == uiLoc)
+		{
+			ucReturn = FlashEep_Append(aucRec, ucSize);
+			if(ucReturn != 0)
+			{
+				break;
+			}
+		}
+		else
+		{
+			//Superseded record, dropped
+		}
+
+		uiOffset = (uint16_t)(uiOffset + ucSize);
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function makes ucBlock the active block. A spare block is used as it is, any other one is erased
+*			first.
+* @param	ucBlock, block index
+* @param	uiSeq, sequence number of the block
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashEep_OpenBlock(uint8_t ucBlock, uint16_t uiSeq)
+{
+	uint8_t ucReturn;
+
+	ucReturn = FlashBlk_Activate(ucBlock, uiSeq);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	s_ucFlashEepHead = ucBlock;
+	s_uiFlashEepSeq = uiSeq;
+	s_uiFlashEepOffset = FLASHEEP_HDR_SIZE;
+
+	return 0;
+}
+
+/**
+* @brief	This function programs a complete record at the end of the active block, which must have room for it
+* @param	pucRec, record
+* @param	ucSize, record size
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashEep_Append(const uint8_t *pucRec, uint8_t ucSize)
+{
+	uint16_t uiKey = (uint16_t)(pucRec[0] | ((uint16_t)pucRec[1] << 8));
+	uint16_t uiLoc = (uint16_t)((s_ucFlashEepHead * FLASHMAN_BLOCK_SIZE) + s_uiFlashEepOffset);
+	uint8_t ucReturn;
+
+	ucReturn = FlashMan_WriteDF(pucRec, FLASHMAN_BLOCK_ADDR_WR + uiLoc, ucSize);
+
+	//Even a failed record uses its cells
+	s_uiFlashEepOffset = (uint16_t)(s_uiFlashEepOffset + ucSize);
+
+	if(ucReturn == 0)
+	{
+		s_auiFlashEepLoc[uiKey] = uiLoc;
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function makes room for a record in the active block: it moves to the next block of the ring
+*			and, when no spare block is left, reclaims the oldest one
+* @param	ucSize, record size
+* @return	0 if OK, ERR_FLASHEEP_FULL or Flash Manager error otherwise
+*/
+static uint8_t FlashEep_MakeRoom(uint8_t ucSize)
+{
+	uint8_t ucTries;
+	uint8_t ucReturn;
+	uint16_t uiEnd;
+
+	for(ucTries = 0; ucTries <= FLASHMAN_BLOCK_NUM; ucTries++)
+	{
+		if((s_uiFlashEepOffset + ucSize) <= FLASHMAN_BLOCK_SIZE)
+		{
+			return 0;
+		}
+
+		//A head left without the marker only costs a frontier search at the next mount
+		(void)FlashBlk_MarkFull(s_ucFlashEepHead);
+
+		ucReturn = FlashEep_OpenBlock(FLASHEEP_NEXT(s_ucFlashEepHead), (uint16_t)(s_uiFlashEepSeq + 1));
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		s_ucFlashEepUsed++;
+
+		//Last spare block in use: the live records of the tail go to the new (empty) active block
+		if(s_ucFlashEepUsed >= FLASHMAN_BLOCK_NUM)
+		{
+			ucReturn = FlashEep_ScanBlock(s_ucFlashEepTail, 1, &uiEnd);
+			if(ucReturn != 0)
+			{
+				return ucReturn;
+			}
+
+			//Once retired, the old copies are not taken as live whatever interrupts the erase; a block left
+			//dirty is erased again when it is activated
+			(void)FlashBlk_Retire(s_ucFlashEepTail);
+			(void)FlashBlk_Prepare(s_ucFlashEepTail);
+			s_ucFlashEepTail = FLASHEEP_NEXT(s_ucFlashEepTail);
+			s_ucFlashEepUsed--;
+		}
+	}
+
+	return ERR_FLASHEEP_FULL;
+}
+
+/**
+* @brief	This function builds the RAM index of the keys from the records of the log, oldest block first so
+*			newer records win, and finds the end of the active block
+* @param	none
+* @return	0 if OK, Flash Manager error otherwise
+*/
+static uint8_t FlashEep_Index(void)
+{
+	uint16_t uiEnd = FLASHMAN_BLOCK_SIZE;
+	uint8_t ucReturn;
+	uint8_t ucBlock;
+	uint8_t i;
+
+	for(i = 0; i < FLASHEEP_MAX_KEYS; i++)
+	{
+		s_auiFlashEepLoc[i] = FLASHEEP_NO_LOC;
+	}
+
+	for(i = 0, ucBlock = s_ucFlashEepTail; i < s_ucFlashEepUsed; i++, ucBlock = FLASHEEP_NEXT(ucBlock))
+	{
+		ucReturn = FlashEep_ScanBlock(ucBlock, 0, &uiEnd);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+
+	s_uiFlashEepOffset = uiEnd;
+	s_ucFlashEepIndexed = 1;
+
+	return 0;
+}
+
+#ifdef FLASHEEP_CODEC
+/**
+* @brief	This function reads a packed value
+* @param	uiLoc, area offset of the record
+* @param	ucLen, len byte of the record
+* @param	pucData, buffer for the value
+* @param	ucSize, bytes to read, not more than the size written
+* @return	0 if OK, ERR_FLASHEEP_PARAM or Flash Manager error otherwise
+*/
+static uint8_t FlashEep_ReadPacked(uint16_t uiLoc, uint8_t ucLen, uint8_t *pucData, uint8_t ucSize)
+{
+	uint8_t aucPacked[FLASHEEP_MAX_DATA];
+	uint8_t aucValue[FLASHEEP_MAX_DATA];
+	uint8_t ucReturn;
+	uint8_t i;
+
+	ucReturn = FlashMan_ReadDF(aucPacked, FLASHMAN_BLOCK_ADDR_RD + uiLoc + FLASHEEP_REC_HDR, mFlashEep_DataLen(ucLen));
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+	if(ucSize > FlashCodec_Unpack(aucPacked, mFlashEep_DataLen(ucLen), aucValue, FLASHEEP_MAX_DATA))
+	{
+		return ERR_FLASHEEP_PARAM;
+	}
+
+	for(i = 0; i < ucSize; i++)
+	{
+		pucData[i] = aucValue[i];
+	}
+
+	return 0;
+}
+#endif
+
+/**
+* @brief	This function retires every block of the data flash and starts an empty log in block 0
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashEep_Format(void)
+{
+	uint8_t i;
+	uint8_t ucReturn;
+
+	s_ucFlashEepMounted = 0;
+	s_ucFlashEepIndexed = 0;
+
+	ucReturn = FlashBlk_Mount();
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	//No block of the old log must outlive the new one, whatever interrupts the format
+	for(i = 0; i < FLASHMAN_BLOCK_NUM; i++)
+	{
+		ucReturn = FlashBlk_Retire(i);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+
+	for(i = 0; i < FLASHEEP_MAX_KEYS; i++)
+	{
+		s_auiFlashEepLoc[i] = FLASHEEP_NO_LOC;
+	}
+
+	ucReturn = FlashEep_OpenBlock(0, 0);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	s_ucFlashEepTail = 0;
+	s_ucFlashEepUsed = 1;
+	s_ucFlashEepIndexed = 1;
+	s_ucFlashEepMounted = 1;
+
+	return 0;
+}
+
+/**
+* @brief	This function finds the log from the block headers. It has to be called once at start up, after
+*			FlashManInit; it reads one header per block whatever the data stored. A data flash without a log is
+*			formatted.
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashEep_Mount(void)
+{
+	const FlashBlk_Info *ptInfo;
+	const FlashBlk_Info *ptPrev;
+	uint8_t ucReturn;
+	uint8_t ucHead = 0xFF;
+	uint8_t ucBlock;
+	uint8_t i;
+
+	s_ucFlashEepMounted = 0;
+	s_ucFlashEepIndexed = 0;
+
+	ucReturn = FlashBlk_Mount();
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	//The active block is the log block with the highest sequence number
+	for(i = 0; i < FLASHMAN_BLOCK_NUM; i++)
+	{
+		ptInfo = FlashBlk_GetInfo(i);
+		if(	FlashEep_IsLogBlock(ptInfo)
+			&& ((ucHead == 0xFF) || ((int16_t)(ptInfo->uiSeq - FlashBlk_GetInfo(ucHead)->uiSeq) > 0)))
+		{
+			ucHead = i;
+		}
+	}
+
+	if(ucHead == 0xFF)
+	{
+		return FlashEep_Format();
+	}
+
+	//Walk back over the chain of consecutive sequence numbers, anything outside of it is erased before use
+	s_ucFlashEepTail = ucHead;
+	s_ucFlashEepUsed = 1;
+	while(s_ucFlashEepUsed < FLASHMAN_BLOCK_NUM)
+	{
+		ucBlock = FLASHEEP_PREV(s_ucFlashEepTail);
+		ptInfo = FlashBlk_GetInfo(s_ucFlashEepTail);
+		ptPrev = FlashBlk_GetInfo(ucBlock);
+		if(!FlashEep_IsLogBlock(ptPrev) || (ptPrev->uiSeq != (uint16_t)(ptInfo->uiSeq - 1)))
+		{
+			break;
+		}
+		s_ucFlashEepTail = ucBlock;
+		s_ucFlashEepUsed++;
+	}
+
+	//A chain of every block is a reclaim cut short: the head only holds copies of live records of the tail, which
+	//is still whole, so the head is dropped and the reclaim done again at the next block change
+	if(s_ucFlashEepUsed >= FLASHMAN_BLOCK_NUM)
+	{
+		ucReturn = FlashBlk_Retire(ucHead);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		ucHead = FLASHEEP_PREV(ucHead);
+		s_ucFlashEepUsed--;
+	}
+
+	s_ucFlashEepHead = ucHead;
+	s_uiFlashEepSeq = FlashBlk_GetInfo(ucHead)->uiSeq;
+	s_ucFlashEepMounted = 1;
+
+	return 0;
+}
+
+/**
+* @brief	This function reads the value of a virtual address
+* @param	uiKey, virtual address
+* @param	pucData, buffer for the value
+* @param	ucSize, bytes to read, not more than the size written
+* @return	0 if OK, ERR_FLASHEEP_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashEep_Read(uint16_t uiKey, uint8_t *pucData, uint8_t ucSize)
+{
+	uint8_t ucLen;
+	uint8_t ucReturn;
+
+	if(!s_ucFlashEepMounted)
+	{
+		return ERR_FLASHEEP_NOTMOUNTED;
+	}
+	if(uiKey >= FLASHEEP_MAX_KEYS)
+	{
+		return ERR_FLASHEEP_PARAM;
+	}
+	if(!s_ucFlashEepIndexed)
+	{
+		ucReturn = FlashEep_Index();
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+	if(s_auiFlashEepLoc[uiKey] == FLASHEEP_NO_LOC)
+	{
+		return ERR_FLASHEEP_NOTFOUND;
+	}
+
+	ucReturn = FlashMan_ReadDF(&ucLen, FLASHMAN_BLOCK_ADDR_RD + s_auiFlashEepLoc[uiKey] + 2, 1);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+#ifdef FLASHEEP_CODEC
+	if((ucLen & FLASHEEP_LEN_PACKED) != 0)
+	{
+		return FlashEep_ReadPacked(s_auiFlashEepLoc[uiKey], ucLen, pucData, ucSize);
+	}
+#endif
+	if(ucSize > ucLen)
+	{
+		return ERR_FLASHEEP_PARAM;
+	}
+
+	return FlashMan_ReadDF(pucData, FLASHMAN_BLOCK_ADDR_RD + s_auiFlashEepLoc[uiKey] + FLASHEEP_REC_HDR, ucSize);
+}
+
+/**
+* @brief	This function writes the value of a virtual address. Writing the value already stored costs nothing.
+* @param	uiKey, virtual address
+* @param	pucData, value
+* @param	ucSize, value size, up to FLASHEEP_MAX_DATA
+* @return	0 if OK, ERR_FLASHEEP_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashEep_Write(uint16_t uiKey, const uint8_t *pucData, uint8_t ucSize)
+{
+	uint8_t aucRec[FLASHEEP_MAX_DATA + FLASHEEP_REC_OVH];
+	uint8_t aucOld[FLASHEEP_MAX_DATA + FLASHEEP_REC_OVH];
+	uint8_t ucLen = 0;
+	uint8_t ucRecSize;
+	uint16_t uiSum;
+	uint8_t i;
+	uint8_t ucReturn;
+
+	if(!s_ucFlashEepMounted)
+	{
+		return ERR_FLASHEEP_NOTMOUNTED;
+	}
+	if((uiKey >= FLASHEEP_MAX_KEYS) || (ucSize > FLASHEEP_MAX_DATA))
+	{
+		return ERR_FLASHEEP_PARAM;
+	}
+	if(!s_ucFlashEepIndexed)
+	{
+		ucReturn = FlashEep_Index();
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+
+	aucRec[0] = (uint8_t)uiKey;
+	aucRec[1] = (uint8_t)(uiKey >> 8);
+#ifdef FLASHEEP_CODEC
+	//Packed only if it saves at least a byte
+	if(ucSize >= FLASHCODEC_RUN_MIN)
+	{
+		ucLen = (uint8_t)FlashCodec_Pack(pucData, ucSize, &aucRec[FLASHEEP_REC_HDR], (uint16_t)(ucSize - 1));
+	}
+	if(ucLen != 0)
+	{
+		aucRec[2] = (uint8_t)(ucLen | FLASHEEP_LEN_PACKED);
+	}
+	else
+#endif
+	{
+		ucLen = ucSize;
+		aucRec[2] = ucSize;
+		for(i = 0; i < ucSize; i++)
+		{
+			aucRec[FLASHEEP_REC_HDR + i] = pucData[i];
+		}
+	}
+	ucRecSize = (uint8_t)(FLASHEEP_REC_OVH + ucLen);
+	uiSum = FlashSum_Fletcher16(aucRec, (uint16_t)(ucRecSize - 2));
+	aucRec[ucRecSize - 2] = (uint8_t)uiSum;
+	aucRec[ucRecSize - 1] = (uint8_t)(uiSum >> 8);
+
+	//Same value already stored, packing gives the same record for the same value
+	if(	(s_auiFlashEepLoc[uiKey] != FLASHEEP_NO_LOC)
+		&& (FlashEep_ReadRecord(s_auiFlashEepLoc[uiKey], aucOld) == ucRecSize))
+	{
+		for(i = 0; (i < ucRecSize) && (aucOld[i] == aucRec[i]); i++)
+		{
+		}
+		if(i == ucRecSize)
+		{
+			return 0;
+		}
+	}
+
+	ucReturn = FlashEep_MakeRoom(ucRecSize);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	return FlashEep_Append(aucRec, ucRecSize);
+}
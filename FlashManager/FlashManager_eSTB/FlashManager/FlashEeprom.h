@@ -0,0 +1,43 @@
+/**
+* @brief The Flash EEPROM module emulates a byte addressable E2PROM on top of the Flash Manager module. Data is
+* stored as records identified by a virtual address (key). Records are appended to the active data flash block;
+* when it is full the next block of the ring becomes the active one, and when no spare block is left the live
+* records of the oldest block are copied to the active one and the oldest block is erased. Every block is
+* erased in turn, so wear is spread over the FLASHMAN_BLOCK_NUM blocks.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHEEPROM_H__
+#define __FLASHEEPROM_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHEEP_MAX_KEYS		64		//Virtual addresses 0 .. FLASHEEP_MAX_KEYS - 1
+#define FLASHEEP_MAX_DATA		32		//Largest record
+
+//With FLASHEEP_CODEC defined, values are stored packed by the Flash Codec module when that makes them smaller
+
+//Errors, the Flash Manager ones (ERR_FLASHE2DATA_xxx, FLASHMAN_STATUS_ERROR) are passed through
+#define ERR_FLASHEEP_NOTFOUND	0x10	//Key never written
+#define ERR_FLASHEEP_PARAM		0x11	//Key or size out of range
+#define ERR_FLASHEEP_FULL		0x12	//No room left even after reclaiming
+#define ERR_FLASHEEP_NOTMOUNTED	0x13
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint8_t FlashEep_Mount(void);
+uint8_t FlashEep_Format(void);
+uint8_t FlashEep_Read(uint16_t uiKey, uint8_t *pucData, uint8_t ucSize);
+uint8_t FlashEep_Write(uint16_t uiKey, const uint8_t *pucData, uint8_t ucSize);
+
+
+#endif // __FLASHEEPROM_H__
@@ -0,0 +1,305 @@
+/**
+* @brief The Flash Journal module keeps a circular log in the data flash, see FlashJournal.h.
+*
+* Data flash layout, per FLASHMAN_BLOCK_SIZE block of the ring:
+*	header	FLASHBLK_HDR_SIZE bytes kept by the Flash Block module (state, sequence number, erase count)
+*	entries	FLASHJRN_BLOCK_ENTRIES x [data 0 .. FLASHJRN_ENTRY_DATA - 1][sum L][sum H], sum = Fletcher-16 of the data
+* The blocks of the log form a chain of consecutive sequence numbers in ring order, from the oldest (tail) to the
+* active one (head); every block but the head has all its entry slots used. The oldest block is retired before it
+* is erased, so an interrupted erase never brings old entries back into the chain.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashJournal.h"
+#include "FlashBlock.h"
+#include "FlashManager.h"
+#include "FlashSum.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHJRN_BLOCK(r)		( (uint8_t)(FLASHJRN_FIRST_BLOCK + (r)) )			//Ring index to block
+#define FLASHJRN_NEXT(r)		( (uint8_t)(((r) + 1) % FLASHJRN_BLOCKS) )
+#define FLASHJRN_PREV(r)		( (uint8_t)(((r) + FLASHJRN_BLOCKS - 1) % FLASHJRN_BLOCKS) )
+
+#define mFlashJrn_EntryRd(r, uiEntry)	\
+	( mFlashMan_BlockAddrRd(FLASHJRN_BLOCK(r)) + FLASHBLK_HDR_SIZE + ((uint32_t)(uiEntry) * FLASHJRN_ENTRY_SIZE) )
+#define mFlashJrn_EntryWr(r, uiEntry)	\
+	( mFlashMan_BlockAddrWr(FLASHJRN_BLOCK(r)) + FLASHBLK_HDR_SIZE + ((uint32_t)(uiEntry) * FLASHJRN_ENTRY_SIZE) )
+
+typedef char FlashJrn_CheckBlocks[(	(FLASHJRN_BLOCKS >= 2)
+									&& ((FLASHJRN_FIRST_BLOCK + FLASHJRN_BLOCKS) <= FLASHMAN_BLOCK_NUM)) ? 1 : -1];
+typedef char FlashJrn_CheckEntry[((FLASHJRN_ENTRY_DATA > 0) && (FLASHJRN_BLOCK_ENTRIES >= 1)) ? 1 : -1];
+typedef char FlashJrn_CheckCount[(((uint32_t)FLASHJRN_BLOCKS * FLASHJRN_BLOCK_ENTRIES) <= 0xFFFFUL) ? 1 : -1];
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static uint8_t s_ucFlashJrnMounted = 0;
+static uint8_t s_ucFlashJrnHead;						//Active block, ring index
+static uint8_t s_ucFlashJrnUsed;						//Blocks in the log
+static uint16_t s_uiFlashJrnNext;						//Next entry slot of the active block
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static uint8_t FlashJrn_IsLogBlock(uint8_t ucRing);
+static uint8_t FlashJrn_NextBlock(void);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function tells if a block of the ring holds part of a log
+* @param	ucRing, ring index
+* @return	1 if the block is ACTIVE or FULL, 0 otherwise
+*/
+static uint8_t FlashJrn_IsLogBlock(uint8_t ucRing)
+{
+	const FlashBlk_Info *ptInfo = FlashBlk_GetInfo(FLASHJRN_BLOCK(ucRing));
+
+	return (uint8_t)((ptInfo->ucState == FLASHBLK_ST_ACTIVE) || (ptInfo->ucState == FLASHBLK_ST_FULL));
+}
+
+/**
+* @brief	This function moves the head to the next block of the ring, dropping the oldest block when the ring
+*			is full
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+static uint8_t FlashJrn_NextBlock(void)
+{
+	uint8_t ucNext = FLASHJRN_NEXT(s_ucFlashJrnHead);
+	uint16_t uiSeq = (uint16_t)(FlashBlk_GetInfo(FLASHJRN_BLOCK(s_ucFlashJrnHead))->uiSeq + 1);
+	uint8_t ucReturn;
+
+	//A head left without the marker is only searched again at the next mount
+	(void)FlashBlk_MarkFull(FLASHJRN_BLOCK(s_ucFlashJrnHead));
+
+	//Once retired, the entries of the oldest block are not taken as part of the log whatever interrupts its erase
+	ucReturn = FlashBlk_Retire(FLASHJRN_BLOCK(ucNext));
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+	if(s_ucFlashJrnUsed >= FLASHJRN_BLOCKS)
+	{
+		s_ucFlashJrnUsed--;
+	}
+
+	ucReturn = FlashBlk_Activate(FLASHJRN_BLOCK(ucNext), uiSeq);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	s_ucFlashJrnHead = ucNext;
+	s_ucFlashJrnUsed++;
+	s_uiFlashJrnNext = 0;
+
+	return 0;
+}
+
+/**
+* @brief	This function finds the log from the block headers and the next entry slot with a binary search of
+*			the active block. It has to be called once at start up, after FlashManInit; a ring without a log
+*			starts an empty one.
+* @param	none
+* @return	0 if OK, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashJrn_Mount(void)
+{
+	const FlashBlk_Info *ptInfo;
+	uint8_t ucHead = 0xFF;
+	uint8_t ucTail;
+	uint16_t uiEnd;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	s_ucFlashJrnMounted = 0;
+
+	ucReturn = FlashBlk_Mount();
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	//The active block is the log block with the highest sequence number
+	for(i = 0; i < FLASHJRN_BLOCKS; i++)
+	{
+		ptInfo = FlashBlk_GetInfo(FLASHJRN_BLOCK(i));
+		if(	FlashJrn_IsLogBlock(i)
+			&& ((ucHead == 0xFF) || ((int16_t)(ptInfo->uiSeq - FlashBlk_GetInfo(FLASHJRN_BLOCK(ucHead))->uiSeq) > 0)))
+		{
+			ucHead = i;
+		}
+	}
+
+	if(ucHead == 0xFF)
+	{
+		ucReturn = FlashBlk_Activate(FLASHJRN_BLOCK(0), 0);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		s_ucFlashJrnHead = 0;
+		s_ucFlashJrnUsed = 1;
+		s_uiFlashJrnNext = 0;
+		s_ucFlashJrnMounted = 1;
+		return 0;
+	}
+
+	//Walk back over the chain of consecutive sequence numbers
+	s_ucFlashJrnHead = ucHead;
+	s_ucFlashJrnUsed = 1;
+	ucTail = ucHead;
+	while(	(s_ucFlashJrnUsed < FLASHJRN_BLOCKS) && FlashJrn_IsLogBlock(FLASHJRN_PREV(ucTail))
+			&& (FlashBlk_GetInfo(FLASHJRN_BLOCK(FLASHJRN_PREV(ucTail)))->uiSeq
+				== (uint16_t)(FlashBlk_GetInfo(FLASHJRN_BLOCK(ucTail))->uiSeq - 1)))
+	{
+		ucTail = FLASHJRN_PREV(ucTail);
+		s_ucFlashJrnUsed++;
+	}
+
+	//Erased cells read as undefined values, the end of the log is found by blank checks. An interrupted entry
+	//still uses its slot.
+	s_uiFlashJrnNext = FLASHJRN_BLOCK_ENTRIES;
+	if(FlashBlk_GetInfo(FLASHJRN_BLOCK(ucHead))->ucState == FLASHBLK_ST_ACTIVE)
+	{
+		ucReturn = FlashMan_FindFrontierDF(mFlashJrn_EntryWr(ucHead, 0), FLASHJRN_BLOCK_ENTRIES * FLASHJRN_ENTRY_SIZE,
+											&uiEnd);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+		s_uiFlashJrnNext = (uint16_t)((uiEnd + FLASHJRN_ENTRY_SIZE - 1) / FLASHJRN_ENTRY_SIZE);
+	}
+
+	s_ucFlashJrnMounted = 1;
+
+	return 0;
+}
+
+/**
+* @brief	This function appends an entry to the log. It programs FLASHJRN_ENTRY_SIZE bytes, plus a block erase
+*			once every FLASHJRN_BLOCK_ENTRIES entries.
+* @param	pucData, FLASHJRN_ENTRY_DATA bytes
+* @return	0 if OK, ERR_FLASHJRN_NOTMOUNTED, ERR_FLASHBLK_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashJrn_Append(const uint8_t *pucData)
+{
+	uint8_t aucEntry[FLASHJRN_ENTRY_SIZE];
+	uint16_t uiSum;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	if(!s_ucFlashJrnMounted)
+	{
+		return ERR_FLASHJRN_NOTMOUNTED;
+	}
+
+	if(s_uiFlashJrnNext >= FLASHJRN_BLOCK_ENTRIES)
+	{
+		ucReturn = FlashJrn_NextBlock();
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+
+	for(i = 0; i < FLASHJRN_ENTRY_DATA; i++)
+	{
+		aucEntry[i] = pucData[i];
+	}
+	uiSum = FlashSum_Fletcher16(pucData, FLASHJRN_ENTRY_DATA);
+	aucEntry[FLASHJRN_ENTRY_DATA] = (uint8_t)uiSum;
+	aucEntry[FLASHJRN_ENTRY_DATA + 1] = (uint8_t)(uiSum >> 8);
+
+	ucReturn = FlashMan_WriteDF(aucEntry, mFlashJrn_EntryWr(s_ucFlashJrnHead, s_uiFlashJrnNext), FLASHJRN_ENTRY_SIZE);
+
+	//Even a failed entry uses its cells
+	s_uiFlashJrnNext++;
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function gives the number of entry slots in the log, interrupted entries included
+* @param	none
+* @return	entries, 0 if not mounted
+*/
+uint16_t FlashJrn_GetCount(void)
+{
+	if(!s_ucFlashJrnMounted)
+	{
+		return 0;
+	}
+
+	return (uint16_t)(((s_ucFlashJrnUsed - 1) * FLASHJRN_BLOCK_ENTRIES) + s_uiFlashJrnNext);
+}
+
+/**
+* @brief	This function reads an entry of the log, counting back from the newest one
+* @param	uiBack, 0 for the newest entry, FlashJrn_GetCount() - 1 for the oldest one
+* @param	pucData, FLASHJRN_ENTRY_DATA bytes
+* @return	0 if OK, ERR_FLASHJRN_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashJrn_Read(uint16_t uiBack, uint8_t *pucData)
+{
+	uint8_t aucEntry[FLASHJRN_ENTRY_SIZE];
+	uint8_t ucRing = s_ucFlashJrnHead;
+	uint16_t uiEntry;
+	uint16_t uiSum;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	if(!s_ucFlashJrnMounted)
+	{
+		return ERR_FLASHJRN_NOTMOUNTED;
+	}
+	if(uiBack >= FlashJrn_GetCount())
+	{
+		return ERR_FLASHJRN_NOTFOUND;
+	}
+
+	if(uiBack < s_uiFlashJrnNext)
+	{
+		uiEntry = (uint16_t)(s_uiFlashJrnNext - 1 - uiBack);
+	}
+	else
+	{
+		uiBack = (uint16_t)(uiBack - s_uiFlashJrnNext);
+		for(i = 0; i <= (uiBack / FLASHJRN_BLOCK_ENTRIES); i++)
+		{
+			ucRing = FLASHJRN_PREV(ucRing);
+		}
+		uiEntry = (uint16_t)(FLASHJRN_BLOCK_ENTRIES - 1 - (uiBack % FLASHJRN_BLOCK_ENTRIES));
+	}
+
+	ucReturn = FlashMan_ReadDF(aucEntry, mFlashJrn_EntryRd(ucRing, uiEntry), FLASHJRN_ENTRY_SIZE);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+	uiSum = (uint16_t)(aucEntry[FLASHJRN_ENTRY_DATA] | ((uint16_t)aucEntry[FLASHJRN_ENTRY_DATA + 1] << 8));
+	if(uiSum != FlashSum_Fletcher16(aucEntry, FLASHJRN_ENTRY_DATA))
+	{
+		return ERR_FLASHJRN_CORRUPT;
+	}
+
+	for(i = 0; i < FLASHJRN_ENTRY_DATA; i++)
+	{
+		pucData[i] = aucEntry[i];
+	}
+
+	return 0;
+}
@@ -0,0 +1,56 @@
+/**
+* @brief The Flash Journal module keeps a circular log of fixed size entries (faults, events) in a ring of data flash
+* blocks. An append programs one entry after the last one, without reading or erasing anything; when the active block
+* is full the oldest block of the ring is erased and becomes the active one, so the log always holds the latest
+* (FLASHJRN_BLOCKS - 1) * FLASHJRN_BLOCK_ENTRIES entries at least. After a reset the head is found from the block
+* headers and a binary search of the active block, whatever the number of entries.
+* The blocks FLASHJRN_FIRST_BLOCK .. FLASHJRN_FIRST_BLOCK + FLASHJRN_BLOCKS - 1 must not be used by any other module;
+* their headers are kept by the Flash Block module.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHJOURNAL_H__
+#define __FLASHJOURNAL_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+#include "FlashBlock.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Ring of blocks
+#ifndef FLASHJRN_FIRST_BLOCK
+#define FLASHJRN_FIRST_BLOCK	0
+#endif
+#ifndef FLASHJRN_BLOCKS
+#define FLASHJRN_BLOCKS			4
+#endif
+
+//Bytes of an entry given by the caller, a 2 byte checksum is added
+#ifndef FLASHJRN_ENTRY_DATA
+#define FLASHJRN_ENTRY_DATA		6
+#endif
+
+#define FLASHJRN_ENTRY_SIZE		( FLASHJRN_ENTRY_DATA + 2 )
+#define FLASHJRN_BLOCK_ENTRIES	( (FLASHMAN_BLOCK_SIZE - FLASHBLK_HDR_SIZE) / FLASHJRN_ENTRY_SIZE )
+
+//Errors, the Flash Manager and Flash Block ones are passed through
+#define ERR_FLASHJRN_NOTMOUNTED	0x50
+#define ERR_FLASHJRN_NOTFOUND	0x51	//Entry not in the log (any more)
+#define ERR_FLASHJRN_CORRUPT	0x52	//Entry does not check, e.g. its program was interrupted
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint8_t FlashJrn_Mount(void);
+uint8_t FlashJrn_Append(const uint8_t *pucData);
+uint8_t FlashJrn_Read(uint16_t uiBack, uint8_t *pucData);
+uint16_t FlashJrn_GetCount(void);
+
+
+#endif // __FLASHJOURNAL_H__
@@ -13,20 +13,119 @@
 * Includes
 ***********************************************************************************************************************/
 #include "../../../types.h"
+#include "../../FlashManager_Common/FlashManager/FlashManagerTarget.h"
 
 
 /***********************************************************************************************************************
 * Defines
 ***********************************************************************************************************************/
+#define FLASHMAN_STATUS_OK		(0x00U)
+#define FLASHMAN_STATUS_ERROR	(0x01U)
+
 #define ERR_FLASHE2DATA_NOREADMODE	1
 #define ERR_FLASHE2DATA_OUTRNG      2
 #define ERR_FLASHE2DATA_NOHOCO      3
 #define ERR_FLASHE2DATA_NOPEMODE	4
 #define ERR_FLASHE2DATA_LOWSPEED	5
+#define ERR_FLASHE2DATA_BUSY		6
+#define ERR_FLASHE2DATA_NEEDERASE	7
+#define ERR_FLASHE2DATA_CRC			8
+#define ERR_FLASHE2DATA_NOSTAGE		9
+#define ERR_FLASHE2DATA_VERIFY		10
+
+//Data flash modes tracked by the driver
+#define FLASHMAN_MODE_DISABLED	0	//DFLEN = 0, no access to the data flash
+#define FLASHMAN_MODE_READ		1	//Data flash readable at E2FLASHADDR_READBASE
+#define FLASHMAN_MODE_PE		2	//Data flash in program/erase mode
+
+
+//FlashMan_Poll and FlashMan_PollBudget results
+#define FLASHMAN_ASYNC_IDLE		0
+#define FLASHMAN_ASYNC_BUSY		1
+
+//FlashMan_WriteTrans.uiFailedAppend when no append failed
+#define FLASHMAN_TRANS_NO_FAIL	0xFFFF
+
+//Largest FlashMan_WriteDiffDF
+#define FLASHMAN_DIFF_MAX_SIZE	256
+
+//Operation types of FlashMan_Stats.atOp
+#define FLASHMAN_STATS_READ			0	//FlashMan_ReadDF
+#define FLASHMAN_STATS_WRITE		1	//FlashMan_WriteDF, FlashMan_SubmitWriteDF, write transactions, images
+#define FLASHMAN_STATS_ERASE		2	//FlashMan_BlockEraseDF, FlashMan_EraseBlocksDF and their Submit forms
+#define FLASHMAN_STATS_BLANKCHECK	3	//FlashMan_BlankCheckDF, FlashMan_FindFrontierDF
+#define FLASHMAN_STATS_DIFF			4	//FlashMan_WriteDiffDF
+#define FLASHMAN_STATS_OPS			5
+#ifdef FLASHMAN_CRC
+//Block digests, see FlashMan_GetDigestDF. CRC-16/CCITT: polynomial 0x1021, MSB first, no final XOR.
+#define FLASHMAN_CRC_INIT			0xFFFF
+#define FLASHMAN_DIGEST_UNKNOWN		0	//To be scanned from the data flash
+#define FLASHMAN_DIGEST_VALID		1	//Matches the data flash
+#define FLASHMAN_DIGEST_CLAIMED		2	//Given by FlashMan_ClaimDigest, not verified yet
+#endif
+#ifdef FLASHMAN_STAGE
+//Staging buffer, see FlashMan_StageDF: bytes and ranges
+#ifndef FLASHMAN_STAGE_SIZE
+#define FLASHMAN_STAGE_SIZE			256
+#endif
+#ifndef FLASHMAN_STAGE_RANGES
+#define FLASHMAN_STAGE_RANGES		4
+#endif
+#endif
+#ifdef FLASHMAN_TRACE
+//Trace ring size in events, a power of two
+#ifndef FLASHMAN_TRACE_SIZE
+#define FLASHMAN_TRACE_SIZE			64
+#endif
+#define FLASHMAN_TRACE_MAGIC		0x52544D46UL	//"FMTR" in a little endian dump
+//FlashMan_TraceEvent.ucEvent
+#define FLASHMAN_TR_READ			0	//FlashMan_ReadDF
+#define FLASHMAN_TR_WRITE			1	//FlashMan_WriteDF, FlashMan_SubmitWriteDF: from the submit to the end
+#define FLASHMAN_TR_ERASE			2	//Block erases, synchronous or not: from the submit to the end (size in blocks)
+#define FLASHMAN_TR_BLANKCHECK		3	//FlashMan_BlankCheckDF
+#define FLASHMAN_TR_FRONTIER		4	//FlashMan_FindFrontierDF
+#define FLASHMAN_TR_DIFF			5	//FlashMan_WriteDiffDF
+#define FLASHMAN_TR_TRANS			6	//FlashMan_WriteBegin to FlashMan_WriteCommit
+#define FLASHMAN_TR_APPEND			7	//FlashMan_WriteAppend
+#define FLASHMAN_TR_TO_PE			8	//Read mode to P/E mode
+#define FLASHMAN_TR_TO_READ			9	//P/E mode to read mode
+#define FLASHMAN_TR_ENABLE			10	//DFLEN = 1
+#define FLASHMAN_TR_DISABLE			11	//DFLEN = 0
+#define FLASHMAN_TR_IMAGE			12	//FlashMan_ProgramImageDF (size in blocks)
+//FlashMan_TraceEvent.ucKind
+#define FLASHMAN_TR_BEGIN			0	//ulAddr and uiArg = size of the operation
+#define FLASHMAN_TR_END				1	//uiArg = status
+#define FLASHMAN_TR_REJECT			2	//Call rejected because the driver was busy, ulAddr of the call
+#endif
+
+
+//info about all area: FLASHMAN_BLOCK_SIZE, FLASHMAN_BLOCK_NUM, FLASHMAN_AREA_SIZE in FlashManagerTarget.h
+
+//addresses of each block (read mode)
+#define	FLASHMAN_BLOCK_0_RD		( FLASHMAN_BLOCK_ADDR_RD )
+#define	FLASHMAN_BLOCK_1_RD		( FLASHMAN_BLOCK_0_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_2_RD		( FLASHMAN_BLOCK_1_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_3_RD		( FLASHMAN_BLOCK_2_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_4_RD		( FLASHMAN_BLOCK_3_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_5_RD		( FLASHMAN_BLOCK_4_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_6_RD		( FLASHMAN_BLOCK_5_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_7_RD		( FLASHMAN_BLOCK_6_RD + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_7_RD_END	( FLASHMAN_BLOCK_7_RD + FLASHMAN_BLOCK_SIZE - 1)
 
+//addresses of each block (write mode)
+#define	FLASHMAN_BLOCK_0_WR		( FLASHMAN_BLOCK_ADDR_WR )
+#define	FLASHMAN_BLOCK_1_WR		( FLASHMAN_BLOCK_0_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_2_WR		( FLASHMAN_BLOCK_1_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_3_WR		( FLASHMAN_BLOCK_2_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_4_WR		( FLASHMAN_BLOCK_3_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_5_WR		( FLASHMAN_BLOCK_4_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_6_WR		( FLASHMAN_BLOCK_5_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_7_WR		( FLASHMAN_BLOCK_6_WR + FLASHMAN_BLOCK_SIZE )
+#define	FLASHMAN_BLOCK_7_WR_END	( FLASHMAN_BLOCK_7_WR + FLASHMAN_BLOCK_SIZE - 1)
 
-#define E2FLASHADDR_READBASE	0x00100000
-#define E2FLASHADDR_WRITEBASE	0xFE000000
+
+#define E2FLASHADDR_READBASE	FLASHMAN_BLOCK_ADDR_RD
+#define E2FLASHADDR_WRITEBASE	FLASHMAN_BLOCK_ADDR_WR
 #define E2FLASHBLOCK_00			0x0000
 #define E2FLASHBLOCK_01			0x0100
 #define E2FLASHBLOCK_02			0x0200
@@ -45,14 +144,153 @@
 #define E2FLASHBLOCK_15			0x0F00
 
 
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+//Completion callback of an asynchronous operation, called with its write/erase status
+typedef void (*FlashMan_DoneCb)(uint8_t ucStatus);
+
+//Step hook, see FlashMan_SetStepHook
+typedef void (*FlashMan_StepHook)(void);
+
+//Read-only view of the data flash, see FlashMan_GetViewDF
+typedef struct
+{
+	const uint8_t *pucData;		//Data flash contents, memory mapped
+	uint16_t uiSize;
+	uint16_t uiEpoch;			//Read mode period the view belongs to
+} FlashMan_View;
+
+#ifndef FLASHMAN_NO_STATS
+//Counters of one operation type, see FlashMan_GetStats. Only calls that reach the data flash are counted (not the
+//ones rejected for their parameters or because the driver is busy); cycles go from the call, submit or
+//FlashMan_WriteBegin to the end of the operation.
+typedef struct
+{
+	uint32_t ulCalls;
+	uint32_t ulErrors;			//Calls that did not end with 0
+	uint32_t ulFrdyPolls;		//FRDY reads while waiting for the sequencer
+	uint32_t ulCyclesMin;
+	uint32_t ulCyclesMax;
+	uint64_t ullCyclesTotal;
+} FlashMan_OpStats;
+
+//Driver statistics, see FlashMan_GetStats
+typedef struct
+{
+	FlashMan_OpStats atOp[FLASHMAN_STATS_OPS];
+	uint32_t ulBytesProgrammed;	//Program commands
+	uint32_t ulBlocksErased;	//Blocks covered by erase commands
+	uint32_t ulBlankChecks;		//Blank check commands
+	uint32_t ulToPEMode;		//Read to P/E mode transitions
+	uint32_t ulToReadMode;		//P/E to read mode transitions
+	uint32_t ulErrorResets;		//FRESETR pulses after a command error
+	uint32_t ulPollCyclesMax;	//Longest FlashMan_Poll call
+	uint32_t ulStagedReads;		//Reads served from the staging buffer in P/E mode (FLASHMAN_STAGE)
+} FlashMan_Stats;
+#endif
+
+#ifdef FLASHMAN_CRC
+//Digest of the programmed part of a block, bytes 0 .. uiLength - 1
+typedef struct
+{
+	uint16_t uiCrc;
+	uint16_t uiLength;
+} FlashMan_Digest;
+#endif
+#ifdef FLASHMAN_TRACE
+//Trace event, see FlashMan_Trace
+typedef struct
+{
+	uint32_t ulTime;			//mFlashManHw_GetCycles, ulClockHz cycles per second
+	uint32_t ulAddr;
+	uint16_t uiArg;
+	uint8_t  ucEvent;			//FLASHMAN_TR_xxx
+	uint8_t  ucKind;			//FLASHMAN_TR_BEGIN, FLASHMAN_TR_END or FLASHMAN_TR_REJECT
+} FlashMan_TraceEvent;
+//Trace ring, see FlashMan_GetTrace. Event n (from 0 on) is kept at atEvent[n % uiSize] until it is overwritten, so
+//the last min(ulCount, uiSize) events are in the ring.
+typedef struct
+{
+	uint32_t ulMagic;			//FLASHMAN_TRACE_MAGIC
+	uint32_t ulClockHz;
+	uint32_t ulCount;			//Events recorded since FlashManInit / FlashMan_ClearTrace
+	uint16_t uiSize;			//FLASHMAN_TRACE_SIZE
+	uint16_t uiEventSize;		//sizeof(FlashMan_TraceEvent)
+	FlashMan_TraceEvent atEvent[FLASHMAN_TRACE_SIZE];
+} FlashMan_Trace;
+#endif
+//Whole data flash image, see FlashMan_ProgramImageDF
+typedef struct
+{
+	const uint8_t *pucData;		//FLASHMAN_AREA_SIZE bytes, block 0 first
+	const uint8_t *pucProgram;	//FLASHMAN_AREA_SIZE / 8 bytes, bit (n & 7) of byte n / 8 set: byte n is programmed
+} FlashMan_Image;
+//Write transaction, see FlashMan_WriteBegin
+typedef struct
+{
+	uint8_t  ucOpen;			//1 between FlashMan_WriteBegin and FlashMan_WriteCommit
+	uint8_t  ucStatus;			//Status of the first append that failed
+	uint16_t uiAppends;			//Number of appends done
+	uint16_t uiFailedAppend;	//Index of the first append that failed, FLASHMAN_TRANS_NO_FAIL if none
+	uint32_t ulFailedAddr;		//Address of the byte that failed
+} FlashMan_WriteTrans;
+
+
 /***********************************************************************************************************************
 * Declarations of Public Functions
 ***********************************************************************************************************************/
 void FlashManInit(void);
 static uint8_t E2FlashCheckHOCO(void);
 u8 FlashMan_ReadDF(volatile uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+uint8_t FlashMan_GetViewDF(uint32_t ulAddr, uint16_t uiSize, FlashMan_View *ptView);
+uint8_t FlashMan_IsViewValid(const FlashMan_View *ptView);
 uint8_t FlashMan_WriteDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+uint8_t FlashMan_WriteDiffDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize, uint16_t *puiProgrammed);
 uint8_t FlashMan_BlockEraseDF(uint32_t ulAddr);
+uint8_t FlashMan_EraseBlocksDF(uint32_t ulAddr, uint16_t uiBlocks, uint32_t *pulFailed);
+uint8_t FlashMan_ProgramImageDF(const FlashMan_Image *ptImage, uint32_t *pulFailed);
+uint8_t FlashMan_BlankCheckDF(uint32_t ulAddr, uint16_t uiSize, uint8_t *pucBlank);
+uint8_t FlashMan_FindFrontierDF(uint32_t ulAddr, uint16_t uiSize, uint16_t *puiOffset);
+uint8_t FlashMan_GetMode(void);
+#ifdef FLASHMAN_CLOCK_RUNTIME
+uint8_t FlashMan_SetClockDF(uint32_t ulIclkHz, uint32_t ulFclkHz);
+#endif
+uint8_t FlashMan_WriteBegin(FlashMan_WriteTrans *ptTrans);
+uint8_t FlashMan_WriteAppend(FlashMan_WriteTrans *ptTrans, const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+uint8_t FlashMan_WriteCommit(FlashMan_WriteTrans *ptTrans);
+uint8_t FlashMan_SubmitWriteDF(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize, FlashMan_DoneCb pfnDone);
+uint8_t FlashMan_SubmitEraseDF(uint32_t ulAddr, FlashMan_DoneCb pfnDone);
+uint8_t FlashMan_SubmitEraseBlocksDF(uint32_t ulAddr, uint16_t uiBlocks, FlashMan_DoneCb pfnDone);
+uint8_t FlashMan_Poll(void);
+#ifndef FLASHMAN_USE_FRDYI
+uint8_t FlashMan_PollBudget(uint32_t ulMaxUs, uint16_t uiMaxSteps);
+#endif
+void FlashMan_SetStepHook(FlashMan_StepHook pfnHook);
+uint8_t FlashMan_IsBusy(void);
+uint8_t FlashMan_GetLastStatus(void);
+uint32_t FlashMan_GetFailedBlocks(void);
+#ifndef FLASHMAN_NO_STATS
+void FlashMan_GetStats(FlashMan_Stats *ptStats);
+void FlashMan_ResetStats(void);
+#endif
+#ifdef FLASHMAN_CRC
+uint16_t FlashMan_Crc16(uint16_t uiCrc, const uint8_t *pucData, uint16_t uiSize);
+uint8_t FlashMan_GetDigestDF(uint16_t uiBlock, FlashMan_Digest *ptDigest);
+uint8_t FlashMan_ClaimDigest(uint16_t uiBlock, const FlashMan_Digest *ptDigest);
+uint8_t FlashMan_GetDigestState(uint16_t uiBlock);
+#endif
+#ifdef FLASHMAN_STAGE
+uint8_t FlashMan_StageDF(uint32_t ulAddr, uint16_t uiSize);
+void FlashMan_UnstageDF(void);
+#endif
+#ifdef FLASHMAN_TRACE
+const FlashMan_Trace *FlashMan_GetTrace(void);
+void FlashMan_ClearTrace(void);
+#endif
+#ifdef FLASHMAN_USE_FRDYI
+void FlashMan_FrdyIsr(void);
+#endif
 
 
 #endif // __FLASHMANAGER_H__
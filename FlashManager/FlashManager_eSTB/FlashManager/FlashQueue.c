@@ -0,0 +1,448 @@
+/**
+* @brief The Flash Queue module posts data flash writes from any context, see FlashQueue.h.
+* The posted slots form an intrusive multi producer / single consumer list: a producer claims a free slot with an
+* atomic exchange of its claim word, fills it and appends it by exchanging the head index, then links the previous
+* head to it. A producer preempted between the exchange and the link only delays the collection of the slots behind
+* it to the next FlashQ_Task; nothing waits for it. A stub slot keeps the list never empty.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <string.h>
+
+#include "FlashQueue.h"
+#include "FlashManager.h"
+#include "../../FlashManager_Common/FlashManager/FlashManagerHw.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHQ_STUB				FLASHQ_SLOTS
+#define FLASHQ_NIL				0xFF
+
+//Most lines a slot can touch, so collecting a slot never runs out of lines
+#define FLASHQ_SLOT_LINES		( ((FLASHQ_SLOT_DATA + FLASHQ_LINE_SIZE - 2) / FLASHQ_LINE_SIZE) + 1 )
+
+typedef char FlashQ_CheckSlots[(FLASHQ_SLOTS < FLASHQ_NIL) ? 1 : -1];
+typedef char FlashQ_CheckLine[(	(FLASHQ_LINE_SIZE <= 16)
+								&& ((FLASHQ_LINE_SIZE & (FLASHQ_LINE_SIZE - 1)) == 0)) ? 1 : -1];
+typedef char FlashQ_CheckLines[((FLASHQ_LINES >= FLASHQ_SLOT_LINES) && (FLASHQ_LINES < FLASHQ_NIL)) ? 1 : -1];
+typedef char FlashQ_CheckSize[(FLASHQ_SLOT_DATA <= 0xFF) ? 1 : -1];
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+//Posted write
+typedef struct
+{
+	int32_t lClaim;							//1 from FlashQ_Post until the slot is collected
+	uint8_t ucNext;							//Next slot posted, FLASHQ_NIL if not linked yet
+	uint8_t ucSize;
+	uint16_t uiOffset;						//Area offset of the data
+	uint8_t aucData[FLASHQ_SLOT_DATA];
+} FlashQ_Slot;
+
+//Pending line
+typedef struct
+{
+	uint16_t uiLine;						//Area offset / FLASHQ_LINE_SIZE
+	uint16_t uiMask;						//Bytes to program, bit n for byte n
+	uint8_t aucData[FLASHQ_LINE_SIZE];
+} FlashQ_Line;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Variables
+***********************************************************************************************************************/
+static volatile FlashQ_Slot s_atFlashQSlot[FLASHQ_SLOTS + 1];	//Last one is the stub
+static volatile int32_t s_lFlashQHead = FLASHQ_STUB;			//Last slot appended, producers side
+static uint8_t s_ucFlashQTail = FLASHQ_STUB;					//Oldest slot not collected, consumer side
+static FlashQ_Line s_atFlashQLine[FLASHQ_LINES];				//In address order
+static uint8_t s_ucFlashQLines = 0;
+static uint16_t s_uiFlashQIdle;									//FlashQ_Task calls without new posts
+static FlashQ_Stats s_tFlashQStats;
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static void FlashQ_Push(uint8_t ucSlot);
+static uint8_t FlashQ_Pop(void);
+static uint8_t FlashQ_FindLine(uint16_t uiLine);
+static void FlashQ_Merge(uint16_t uiOffset, const uint8_t *pucData, uint8_t ucSize);
+static uint8_t FlashQ_Collect(void);
+static uint8_t FlashQ_Drain(void);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function appends a slot to the list. It can be called from any context.
+* @param	ucSlot, slot index
+* @return	none
+*/
+static void FlashQ_Push(uint8_t ucSlot)
+{
+	int32_t lPrev = ucSlot;
+
+	s_atFlashQSlot[ucSlot].ucNext = FLASHQ_NIL;
+	mFlashManHw_Xchg(&s_lFlashQHead, &lPrev);
+	s_atFlashQSlot[lPrev].ucNext = ucSlot;
+}
+
+/**
+* @brief	This function takes the oldest slot of the list, consumer side only
+* @param	none
+* @return	slot index, FLASHQ_NIL if the list is empty or its oldest slot is still being linked
+*/
+static uint8_t FlashQ_Pop(void)
+{
+	uint8_t ucTail = s_ucFlashQTail;
+	uint8_t ucNext = s_atFlashQSlot[ucTail].ucNext;
+
+	if(ucTail == FLASHQ_STUB)
+	{
+		if(ucNext == FLASHQ_NIL)
+		{
+			return FLASHQ_NIL;
+		}
+		s_ucFlashQTail = ucNext;
+		ucTail = ucNext;
+		ucNext = s_atFlashQSlot[ucTail].ucNext;
+	}
+
+	if(ucNext != FLASHQ_NIL)
+	{
+		s_ucFlashQTail = ucNext;
+		return ucTail;
+	}
+
+	//Last slot: a producer may be appending behind it
+	if(ucTail != (uint8_t)s_lFlashQHead)
+	{
+		return FLASHQ_NIL;
+	}
+
+	//The stub goes behind it, so it can be taken without emptying the list
+	FlashQ_Push(FLASHQ_STUB);
+	ucNext = s_atFlashQSlot[ucTail].ucNext;
+	if(ucNext != FLASHQ_NIL)
+	{
+		s_ucFlashQTail = ucNext;
+		return ucTail;
+	}
+
+	return FLASHQ_NIL;
+}
+
+/**
+* @brief	This function finds the pending line of an area line, adding it in address order if there is none
+* @param	uiLine, area offset / FLASHQ_LINE_SIZE
+* @return	index in s_atFlashQLine, FLASHQ_NIL if the line is not pending and no line is free
+*/
+static uint8_t FlashQ_FindLine(uint16_t uiLine)
+{
+	uint8_t i;
+
+	for(i = 0; (i < s_ucFlashQLines) && (s_atFlashQLine[i].uiLine < uiLine); i++)
+	{
+	}
+
+	if((i < s_ucFlashQLines) && (s_atFlashQLine[i].uiLine == uiLine))
+	{
+		return i;
+	}
+	if(s_ucFlashQLines >= FLASHQ_LINES)
+	{
+		return FLASHQ_NIL;
+	}
+
+	memmove(&s_atFlashQLine[i + 1], &s_atFlashQLine[i], (size_t)(s_ucFlashQLines - i) * sizeof(FlashQ_Line));
+	s_atFlashQLine[i].uiLine = uiLine;
+	s_atFlashQLine[i].uiMask = 0;
+	s_ucFlashQLines++;
+
+	return i;
+}
+
+/**
+* @brief	This function merges a write into the pending lines, over the data of older writes. There must be
+*			FLASHQ_SLOT_LINES free lines.
+* @param	uiOffset, area offset
+* @param	pucData, data
+* @param	ucSize, number of bytes
+* @return	none
+*/
+static void FlashQ_Merge(uint16_t uiOffset, const uint8_t *pucData, uint8_t ucSize)
+{
+	FlashQ_Line *ptLine;
+	uint8_t ucPos;
+
+	while(ucSize > 0)
+	{
+		ptLine = &s_atFlashQLine[FlashQ_FindLine((uint16_t)(uiOffset / FLASHQ_LINE_SIZE))];
+		ucPos = (uint8_t)(uiOffset % FLASHQ_LINE_SIZE);
+		for(; (ucPos < FLASHQ_LINE_SIZE) && (ucSize > 0); ucPos++, ucSize--, uiOffset++)
+		{
+			ptLine->aucData[ucPos] = *pucData++;
+			ptLine->uiMask |= (uint16_t)(1U << ucPos);
+		}
+	}
+}
+
+/**
+* @brief	This function moves the posted slots to the pending lines, oldest first, while there is room for them
+* @param	none
+* @return	number of slots collected
+*/
+static uint8_t FlashQ_Collect(void)
+{
+	uint8_t aucData[FLASHQ_SLOT_DATA];
+	volatile FlashQ_Slot *ptSlot;
+	uint16_t uiOffset;
+	uint8_t ucSize;
+	uint8_t ucSlot;
+	uint8_t ucCollected = 0;
+	uint8_t i;
+
+	while((s_ucFlashQLines <= (FLASHQ_LINES - FLASHQ_SLOT_LINES)) && ((ucSlot = FlashQ_Pop()) != FLASHQ_NIL))
+	{
+		ptSlot = &s_atFlashQSlot[ucSlot];
+		uiOffset = ptSlot->uiOffset;
+		ucSize = ptSlot->ucSize;
+		for(i = 0; i < ucSize; i++)
+		{
+			aucData[i] = ptSlot->aucData[i];
+		}
+
+		//Free for the producers from here on
+		ptSlot->lClaim = 0;
+
+		FlashQ_Merge(uiOffset, aucData, ucSize);
+		s_tFlashQStats.ulPosts++;
+		s_tFlashQStats.ulBytesPosted += ucSize;
+		ucCollected++;
+	}
+
+	return ucCollected;
+}
+
+/**
+* @brief	This function programs the pending lines in one write transaction, each run of consecutive bytes
+*			with one append
+* @param	none
+* @return	0 if OK, Flash Manager error otherwise. If the transaction cannot be opened (e.g. busy) the lines are
+*			kept for the next call, otherwise they are dropped: failed cells cannot be programmed again.
+*/
+static uint8_t FlashQ_Drain(void)
+{
+	FlashMan_WriteTrans tTrans;
+	FlashQ_Line *ptLine;
+	uint8_t ucStart;
+	uint8_t ucEnd;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	ucReturn = FlashMan_WriteBegin(&tTrans);
+	if(ucReturn != 0)
+	{
+		return ucReturn;
+	}
+
+	for(i = 0; i < s_ucFlashQLines; i++)
+	{
+		ptLine = &s_atFlashQLine[i];
+		for(ucStart = 0; ucStart < FLASHQ_LINE_SIZE; ucStart = ucEnd)
+		{
+			for(; (ucStart < FLASHQ_LINE_SIZE) && !(ptLine->uiMask & (1U << ucStart)); ucStart++)
+			{
+			}
+			for(ucEnd = ucStart; (ucEnd < FLASHQ_LINE_SIZE) && (ptLine->uiMask & (1U << ucEnd)); ucEnd++)
+			{
+			}
+			if(ucEnd > ucStart)
+			{
+				(void)FlashMan_WriteAppend(&tTrans, &ptLine->aucData[ucStart],
+											FLASHMAN_BLOCK_ADDR_WR + ((uint32_t)ptLine->uiLine * FLASHQ_LINE_SIZE) + ucStart,
+											(uint16_t)(ucEnd - ucStart));
+				s_tFlashQStats.ulBytesProgrammed += (uint32_t)(ucEnd - ucStart);
+			}
+		}
+	}
+
+	ucReturn = FlashMan_WriteCommit(&tTrans);
+	s_ucFlashQLines = 0;
+	s_tFlashQStats.ulDrains++;
+	if(ucReturn != 0)
+	{
+		s_tFlashQStats.ulDrainErrors++;
+	}
+
+	return ucReturn;
+}
+
+/**
+* @brief	This function empties the queue. It has to be called before any other function of the module.
+* @param	none
+* @return	none
+*/
+void FlashQ_Init(void)
+{
+	uint8_t i;
+
+	for(i = 0; i <= FLASHQ_SLOTS; i++)
+	{
+		s_atFlashQSlot[i].lClaim = 0;
+		s_atFlashQSlot[i].ucNext = FLASHQ_NIL;
+	}
+	s_lFlashQHead = FLASHQ_STUB;
+	s_ucFlashQTail = FLASHQ_STUB;
+	s_ucFlashQLines = 0;
+	s_uiFlashQIdle = 0;
+	memset(&s_tFlashQStats, 0, sizeof(s_tFlashQStats));
+}
+
+/**
+* @brief	This function posts a write. It can be called from any context, interrupt handlers included, and
+*			returns at once: the data is copied, so the buffer can be reused.
+* @param	pucData, pointer of bytes to write
+* @param	ulAddr, address wherein you want to start writing (E2FLASHADDR_WRITEBASE based)
+* @param	uiSize, number of bytes to write, up to FLASHQ_SLOT_DATA
+* @return	0 if posted, ERR_FLASHQ_xxx or ERR_FLASHE2DATA_OUTRNG otherwise
+*/
+uint8_t FlashQ_Post(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize)
+{
+	volatile FlashQ_Slot *ptSlot;
+	int32_t lClaim;
+	uint8_t ucSlot;
+	uint16_t i;
+
+	if((uiSize == 0) || (uiSize > FLASHQ_SLOT_DATA))
+	{
+		return ERR_FLASHQ_PARAM;
+	}
+	if(!mFlashMan_IsInAreaWr(ulAddr, uiSize))
+	{
+		return ERR_FLASHE2DATA_OUTRNG;
+	}
+
+	for(ucSlot = 0; ucSlot < FLASHQ_SLOTS; ucSlot++)
+	{
+		lClaim = 1;
+		mFlashManHw_Xchg(&s_atFlashQSlot[ucSlot].lClaim, &lClaim);
+		if(lClaim == 0)
+		{
+			break;
+		}
+	}
+	if(ucSlot == FLASHQ_SLOTS)
+	{
+		return ERR_FLASHQ_FULL;
+	}
+
+	ptSlot = &s_atFlashQSlot[ucSlot];
+	ptSlot->uiOffset = (uint16_t)(ulAddr - FLASHMAN_BLOCK_ADDR_WR);
+	ptSlot->ucSize = (uint8_t)uiSize;
+	for(i = 0; i < uiSize; i++)
+	{
+		ptSlot->aucData[i] = pucData[i];
+	}
+	FlashQ_Push(ucSlot);
+
+	return 0;
+}
+
+/**
+* @brief	This function collects the posted writes and programs them once no write has been posted for
+*			FLASHQ_HOLD_TICKS calls, or as soon as the pending lines are full. It has to be called periodically,
+*			always from the same context.
+* @param	none
+* @return	0 if nothing was programmed or the program was OK, Flash Manager error otherwise
+*/
+uint8_t FlashQ_Task(void)
+{
+	if(FlashQ_Collect() != 0)
+	{
+		s_uiFlashQIdle = 0;
+	}
+	else if(s_uiFlashQIdle < 0xFFFF)
+	{
+		s_uiFlashQIdle++;
+	}
+	else
+	{
+		// Empty
+	}
+
+	//Idle counted from 1, so FLASHQ_HOLD_TICKS 0 does not compare an unsigned value below 0
+	if(	(s_ucFlashQLines == 0)
+		|| ((((uint32_t)s_uiFlashQIdle + 1) <= FLASHQ_HOLD_TICKS)
+			&& (s_ucFlashQLines <= (FLASHQ_LINES - FLASHQ_SLOT_LINES))))
+	{
+		return 0;
+	}
+
+	return FlashQ_Drain();
+}
+
+/**
+* @brief	This function programs every write posted so far, from the same context as FlashQ_Task
+* @param	none
+* @return	0 if OK, Flash Manager error of the first program that failed otherwise
+*/
+uint8_t FlashQ_Flush(void)
+{
+	uint8_t ucResult = 0;
+	uint8_t ucReturn;
+	uint8_t i;
+
+	//Posts done meanwhile from interrupts are taken too, in a bounded number of rounds
+	for(i = 0; i <= FLASHQ_SLOTS; i++)
+	{
+		(void)FlashQ_Collect();
+		if(s_ucFlashQLines == 0)
+		{
+			break;
+		}
+		ucReturn = FlashQ_Drain();
+		if(s_ucFlashQLines != 0)
+		{
+			//Transaction not opened
+			return ucReturn;
+		}
+		if(ucResult == 0)
+		{
+			ucResult = ucReturn;
+		}
+	}
+	s_uiFlashQIdle = 0;
+
+	return ucResult;
+}
+
+/**
+* @brief	This function tells if there are writes not programmed yet
+* @param	none
+* @return	1 if some write is queued or pending, 0 otherwise
+*/
+uint8_t FlashQ_IsPending(void)
+{
+	return (uint8_t)((s_ucFlashQLines != 0) || (s_ucFlashQTail != FLASHQ_STUB) || (s_lFlashQHead != FLASHQ_STUB));
+}
+
+/**
+* @brief	This function gives the queue statistics
+* @param	ptStats, copy of the statistics
+* @return	none
+*/
+void FlashQ_GetStats(FlashQ_Stats *ptStats)
+{
+	*ptStats = s_tFlashQStats;
+}
@@ -0,0 +1,77 @@
+/**
+* @brief The Flash Queue module lets several modules, interrupt handlers included, post data flash writes without
+* waiting for the Flash Manager module. FlashQ_Post only copies the data to a free slot and links it with one atomic
+* exchange, so it never blocks nor takes a lock. FlashQ_Task, called from a single context (e.g. the scheduler),
+* collects the slots into pending lines, where writes to the same bytes are merged (the last one posted wins), and
+* after FLASHQ_HOLD_TICKS calls without new posts programs all of them in address order inside one write
+* transaction, so a burst of small writes costs one P/E session.
+* Reads of the data flash do not see the posted data until it is programmed; use FlashQ_Flush first if needed.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHQUEUE_H__
+#define __FLASHQUEUE_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Writes posted and not collected yet
+#ifndef FLASHQ_SLOTS
+#define FLASHQ_SLOTS			8
+#endif
+
+//Largest FlashQ_Post
+#ifndef FLASHQ_SLOT_DATA
+#define FLASHQ_SLOT_DATA		16
+#endif
+
+//Pending data, in lines of FLASHQ_LINE_SIZE bytes (a power of two, up to 16)
+#ifndef FLASHQ_LINES
+#define FLASHQ_LINES			16
+#endif
+#ifndef FLASHQ_LINE_SIZE
+#define FLASHQ_LINE_SIZE		16
+#endif
+
+//FlashQ_Task calls without new posts before the pending lines are programmed, 0 programs them on every call
+#ifndef FLASHQ_HOLD_TICKS
+#define FLASHQ_HOLD_TICKS		5
+#endif
+
+//Errors, the Flash Manager ones (ERR_FLASHE2DATA_xxx, FLASHMAN_STATUS_ERROR) are passed through
+#define ERR_FLASHQ_FULL			0x30	//No free slot, post again later
+#define ERR_FLASHQ_PARAM		0x31	//Size 0 or above FLASHQ_SLOT_DATA
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+//Queue statistics, see FlashQ_GetStats
+typedef struct
+{
+	uint32_t ulPosts;			//Writes collected
+	uint32_t ulBytesPosted;
+	uint32_t ulBytesProgrammed;	//Bytes left after merging
+	uint32_t ulDrains;			//Write transactions
+	uint32_t ulDrainErrors;		//Write transactions that did not end with 0
+} FlashQ_Stats;
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+void FlashQ_Init(void);
+uint8_t FlashQ_Post(const uint8_t *pucData, uint32_t ulAddr, uint16_t uiSize);
+uint8_t FlashQ_Task(void);
+uint8_t FlashQ_Flush(void);
+uint8_t FlashQ_IsPending(void);
+void FlashQ_GetStats(FlashQ_Stats *ptStats);
+
+
+#endif // __FLASHQUEUE_H__
@@ -0,0 +1,38 @@
+/**
+* @brief The Flash Sum module computes the check of the data flash records, see FlashSum.h.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashSum.h"
+
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function computes the Fletcher-16 checksum of a range of bytes, seeded with FLASHSUM_SEED_1 and
+*			FLASHSUM_SEED_2
+* @param	pucData, bytes
+* @param	uiSize, number of bytes
+* @return	checksum, second sum in the high byte
+*/
+uint16_t FlashSum_Fletcher16(const uint8_t *pucData, uint16_t uiSize)
+{
+	uint16_t uiSum1 = FLASHSUM_SEED_1;
+	uint16_t uiSum2 = FLASHSUM_SEED_2;
+	uint16_t i;
+
+	for(i = 0; i < uiSize; i++)
+	{
+		uiSum1 = (uint16_t)((uiSum1 + pucData[i]) % 255);
+		uiSum2 = (uint16_t)((uiSum2 + uiSum1) % 255);
+	}
+
+	return (uint16_t)((uiSum2 << 8) | uiSum1);
+}
@@ -0,0 +1,31 @@
+/**
+* @brief The Flash Sum module computes the Fletcher-16 check stored with the records of the data flash formats (Flash
+* EEPROM records, Flash Journal entries, Flash Table images). Those formats are all written with this one function,
+* on the target and by the host tools (FlashTableGen), so their checks cannot drift apart. It only needs <stdint.h>.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHSUM_H__
+#define __FLASHSUM_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include <stdint.h>
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+//Seeds of the two sums, so a run of zeros does not sum to zero
+#define FLASHSUM_SEED_1			0x5A
+#define FLASHSUM_SEED_2			0xA5
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint16_t FlashSum_Fletcher16(const uint8_t *pucData, uint16_t uiSize);
+
+
+#endif // __FLASHSUM_H__
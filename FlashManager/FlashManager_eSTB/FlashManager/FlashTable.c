@@ -0,0 +1,192 @@
+/**
+* @brief The Flash Table module looks up read-only tables in place in the data flash, see FlashTable.h.
+*
+* Hash kind (hash and displace): a key goes to bucket FlashTbl_Hash(key, seed) % buckets, and to slot
+* FlashTbl_Hash(key, mFlashTbl_DispSeed(seed, disp[bucket])) % count. FlashTableGen picks the displacement of every
+* bucket so that all the keys get a slot of their own, so a lookup compares one key only. The hash and the seed of a
+* displacement must stay the same as in FlashTableGen.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashTable.h"
+#include "FlashManager.h"
+#include "FlashSum.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define mFlashTbl_DispSeed(ulSeed, uiDisp)	( (ulSeed) + (0x9E3779B9UL * ((uint32_t)(uiDisp) + 1U)) )
+
+#define mFlashTbl_Get16(puc)	((uint16_t)((puc)[0] | ((uint16_t)(puc)[1] << 8)))
+#define mFlashTbl_Get32(puc)	((uint32_t)(puc)[0] | ((uint32_t)(puc)[1] << 8) | ((uint32_t)(puc)[2] << 16)	\
+								| ((uint32_t)(puc)[3] << 24))
+
+
+/***********************************************************************************************************************
+* Declarations of Private Functions
+***********************************************************************************************************************/
+static uint32_t FlashTbl_Hash(uint32_t ulKey, uint32_t ulSeed);
+
+/***********************************************************************************************************************
+*  Functions
+***********************************************************************************************************************/
+
+/**
+* @brief	This function mixes a key with a seed (32-bit finalizer, two multiplications)
+* @param	ulKey, key
+* @param	ulSeed, seed
+* @return	hash
+*/
+static uint32_t FlashTbl_Hash(uint32_t ulKey, uint32_t ulSeed)
+{
+	ulKey ^= ulSeed;
+	ulKey ^= ulKey >> 16;
+	ulKey *= 0x7FEB352DUL;
+	ulKey ^= ulKey >> 15;
+	ulKey *= 0x846CA68BUL;
+	ulKey ^= ulKey >> 16;
+
+	return ulKey;
+}
+
+/**
+* @brief	This function opens the table stored at an address: the header is checked and the contents are summed
+*			in place, once. Nothing but the header fields is kept in RAM.
+* @param	ulAddr, image address (E2FLASHADDR_READBASE based)
+* @param	ptTable, table
+* @return	0 if OK, ERR_FLASHTBL_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashTbl_Open(uint32_t ulAddr, FlashTbl_Table *ptTable)
+{
+	uint8_t aucHdr[FLASHTBL_HDR_SIZE];
+	uint32_t ulSize;
+	uint8_t ucReturn;
+
+	ptTable->tView.pucData = 0;
+	ptTable->tView.uiSize = 0;
+
+	ucReturn = FlashMan_ReadDF(aucHdr, ulAddr, FLASHTBL_HDR_SIZE);
+	if(ucReturn != 0)
+	{
+		return (ucReturn == ERR_FLASHE2DATA_OUTRNG) ? ERR_FLASHTBL_FORMAT : ucReturn;
+	}
+
+	ptTable->ulAddr = ulAddr;
+	ptTable->uiCount = mFlashTbl_Get16(&aucHdr[4]);
+	ptTable->uiBuckets = mFlashTbl_Get16(&aucHdr[6]);
+	ptTable->ulSeed = mFlashTbl_Get32(&aucHdr[8]);
+	ptTable->ucKind = aucHdr[12];
+	ptTable->ucValueSize = aucHdr[13];
+
+	if(	(mFlashTbl_Get32(&aucHdr[0]) != FLASHTBL_MAGIC)
+		|| ((ptTable->ucKind == FLASHTBL_KIND_SORTED) && (ptTable->uiBuckets != 0))
+		|| ((ptTable->ucKind == FLASHTBL_KIND_HASH) && ((ptTable->uiBuckets == 0) || (ptTable->uiCount == 0)))
+		|| (ptTable->ucKind > FLASHTBL_KIND_HASH))
+	{
+		return ERR_FLASHTBL_FORMAT;
+	}
+	ulSize = mFlashTbl_Size(ptTable->uiCount, ptTable->uiBuckets, ptTable->ucValueSize);
+	if(ulSize > 0xFFFFU)
+	{
+		return ERR_FLASHTBL_FORMAT;
+	}
+	ptTable->uiKeysOfs = (uint16_t)(FLASHTBL_HDR_SIZE + (2U * ptTable->uiBuckets));
+	ptTable->uiValuesOfs = (uint16_t)(ptTable->uiKeysOfs + (4U * ptTable->uiCount));
+
+	ucReturn = FlashMan_GetViewDF(ulAddr, (uint16_t)ulSize, &ptTable->tView);
+	if(ucReturn != 0)
+	{
+		return (ucReturn == ERR_FLASHE2DATA_OUTRNG) ? ERR_FLASHTBL_FORMAT : ucReturn;
+	}
+
+	if(	FlashSum_Fletcher16(&ptTable->tView.pucData[FLASHTBL_HDR_SIZE], (uint16_t)(ulSize - FLASHTBL_HDR_SIZE))
+		!= mFlashTbl_Get16(&aucHdr[14]))
+	{
+		ptTable->tView.pucData = 0;
+		ptTable->tView.uiSize = 0;
+		return ERR_FLASHTBL_CHECK;
+	}
+
+	return 0;
+}
+
+/**
+* @brief	This function finds the value of a key: one slot of a hash table, or a binary search of a sorted one.
+*			The value is given in place, so it is valid while the view of the table is (FlashMan_IsViewValid); a
+*			view ended by a write or erase elsewhere in the data flash is renewed here, without summing it again.
+* @param	ptTable, table opened by FlashTbl_Open
+* @param	ulKey, key
+* @param	ppucValue, value in the data flash
+* @return	0 if OK, ERR_FLASHTBL_xxx or Flash Manager error otherwise
+*/
+uint8_t FlashTbl_Find(FlashTbl_Table *ptTable, uint32_t ulKey, const uint8_t **ppucValue)
+{
+	const uint8_t *pucKeys;
+	uint16_t uiSize = ptTable->tView.uiSize;
+	uint16_t uiSlot = 0;
+	uint16_t uiLow;
+	uint16_t uiHigh;
+	uint32_t ulMid;
+	uint8_t ucReturn;
+
+	if(uiSize == 0)
+	{
+		return ERR_FLASHTBL_FORMAT;
+	}
+	if(!FlashMan_IsViewValid(&ptTable->tView))
+	{
+		ucReturn = FlashMan_GetViewDF(ptTable->ulAddr, uiSize, &ptTable->tView);
+		if(ucReturn != 0)
+		{
+			return ucReturn;
+		}
+	}
+	pucKeys = &ptTable->tView.pucData[ptTable->uiKeysOfs];
+
+	if(ptTable->ucKind == FLASHTBL_KIND_HASH)
+	{
+		uiSlot = (uint16_t)(FlashTbl_Hash(ulKey, ptTable->ulSeed) % ptTable->uiBuckets);
+		uiSlot = mFlashTbl_Get16(&ptTable->tView.pucData[FLASHTBL_HDR_SIZE + (2U * uiSlot)]);
+		uiSlot = (uint16_t)(FlashTbl_Hash(ulKey, mFlashTbl_DispSeed(ptTable->ulSeed, uiSlot)) % ptTable->uiCount);
+		if(mFlashTbl_Get32(&pucKeys[4U * uiSlot]) != ulKey)
+		{
+			return ERR_FLASHTBL_NOTFOUND;
+		}
+	}
+	else
+	{
+		uiLow = 0;
+		uiHigh = ptTable->uiCount;
+		while(uiLow < uiHigh)
+		{
+			uiSlot = (uint16_t)((uiLow + uiHigh) / 2U);
+			ulMid = mFlashTbl_Get32(&pucKeys[4U * uiSlot]);
+			if(ulMid == ulKey)
+			{
+				break;
+			}
+			else if(ulMid < ulKey)
+			{
+				uiLow = (uint16_t)(uiSlot + 1U);
+			}
+			else
+			{
+				uiHigh = uiSlot;
+			}
+		}
+		if(uiLow >= uiHigh)
+		{
+			return ERR_FLASHTBL_NOTFOUND;
+		}
+	}
+
+	*ppucValue = &ptTable->tView.pucData[ptTable->uiValuesOfs + ((uint32_t)uiSlot * ptTable->ucValueSize)];
+
+	return 0;
+}
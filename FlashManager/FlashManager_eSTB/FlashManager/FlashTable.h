@@ -0,0 +1,71 @@
+/**
+* @brief The Flash Table module looks up read-only tables (e.g. the variant tables of the Variant Decoder and Variant
+* Table modules) in place in the memory mapped data flash, without copying them to RAM nor scanning them. A table maps
+* 32-bit keys to values of a fixed size and is built on the host by FlashTableGen, in one of two kinds:
+*	FLASHTBL_KIND_SORTED	keys in ascending order, binary search: O(log n)
+*	FLASHTBL_KIND_HASH		minimal perfect hash (hash and displace): one bucket read and one key compare, O(1)
+* Image layout, little endian, no alignment needed:
+*	header	[magic, 4][count, 2][buckets, 2][seed, 4][kind][value size][check, 2]
+*	disp	buckets x 2 bytes, displacement of every bucket (hash kind only)
+*	keys	count x 4 bytes, sorted or in hash slot order
+*	values	count x value size bytes, in the order of the keys
+* The check is the Fletcher-16 sum (FlashSum_Fletcher16) of everything after the header, verified once by
+* FlashTbl_Open; the lookups then read the keys they compare and the value found, nothing else.
+*
+* Copyright E.G.O. - All Rights Reserved
+* The above copyright refers to the E.G.O. group development centers.
+*/
+#ifndef __FLASHTABLE_H__
+#define __FLASHTABLE_H__
+/***********************************************************************************************************************
+* Includes
+***********************************************************************************************************************/
+#include "FlashManager.h"
+
+
+/***********************************************************************************************************************
+* Defines
+***********************************************************************************************************************/
+#define FLASHTBL_MAGIC			0x4C425446UL	//"FTBL"
+#define FLASHTBL_HDR_SIZE		16
+
+//Table kinds, header byte 12
+#define FLASHTBL_KIND_SORTED	0
+#define FLASHTBL_KIND_HASH		1
+
+//Size of a table image
+#define mFlashTbl_Size(uiCount, uiBuckets, ucValueSize)	\
+	( FLASHTBL_HDR_SIZE + (2UL * (uiBuckets)) + ((uint32_t)(uiCount) * (4U + (ucValueSize))) )
+
+//Errors, the Flash Manager ones are passed through
+#define ERR_FLASHTBL_FORMAT		0x60	//No table at the address, or it does not fit in the data flash
+#define ERR_FLASHTBL_CHECK		0x61	//Table contents do not check
+#define ERR_FLASHTBL_NOTFOUND	0x62	//Key not in the table
+
+
+/***********************************************************************************************************************
+* Types
+***********************************************************************************************************************/
+//Open table, all the data stays in the data flash
+typedef struct
+{
+	FlashMan_View tView;		//Whole image, renewed by FlashTbl_Find after a write or erase ended it
+	uint32_t ulAddr;			//Image address (E2FLASHADDR_READBASE based)
+	uint32_t ulSeed;
+	uint16_t uiCount;
+	uint16_t uiBuckets;
+	uint16_t uiKeysOfs;			//Offsets in the image
+	uint16_t uiValuesOfs;
+	uint8_t ucKind;				//FLASHTBL_KIND_xxx
+	uint8_t ucValueSize;
+} FlashTbl_Table;
+
+
+/***********************************************************************************************************************
+* Declarations of Public Functions
+***********************************************************************************************************************/
+uint8_t FlashTbl_Open(uint32_t ulAddr, FlashTbl_Table *ptTable);
+uint8_t FlashTbl_Find(FlashTbl_Table *ptTable, uint32_t ulKey, const uint8_t **ppucValue);
+
+
+#endif // __FLASHTABLE_H__